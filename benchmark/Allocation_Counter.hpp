@@ -0,0 +1,216 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Allocation_Counter.hpp
+ *  @brief Replaces the global operator new and operator delete with versions
+ *  that count every allocation, so that the memory used by the Serialiser can
+ *  be measured. This replaces the allocator for the whole program, so it must
+ *  only be included from a single translation unit.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#ifndef BENCHMARK_ALLOCATION_COUNTER_HPP
+#define BENCHMARK_ALLOCATION_COUNTER_HPP
+
+#include <algorithm>  // for max
+#include <atomic>   // for atomic, memory_order_relaxed
+#include <cstddef>  // for size_t
+#include <cstdlib>  // for malloc, aligned_alloc, free
+#include <new>      // for bad_alloc, nothrow_t, align_val_t
+
+#include <sys/resource.h>  // for getrusage, rusage, RUSAGE_SELF
+
+namespace Allocation_Counter
+{
+//! @brief A snapshot of the allocations made so far.
+struct Counts
+{
+    std::size_t allocations;
+    std::size_t bytes;
+};
+
+//! The total number of calls to operator new.
+inline std::atomic<std::size_t> g_allocations{0};
+//! The total number of bytes requested from operator new.
+inline std::atomic<std::size_t> g_bytes{0};
+
+//! @brief Takes a snapshot of the allocations made so far.
+//! @returns The number of allocations and bytes allocated since the program
+//! started.
+inline Counts Snapshot()
+{
+    return {g_allocations.load(std::memory_order_relaxed),
+            g_bytes.load(std::memory_order_relaxed)};
+}
+
+//! @brief Calculates the allocations made between two snapshots.
+//! @param p_start The snapshot taken at the start of the workload.
+//! @param p_end The snapshot taken at the end of the workload.
+//! @returns The allocations made between p_start and p_end.
+inline Counts Difference(const Counts& p_start, const Counts& p_end)
+{
+    return {p_end.allocations - p_start.allocations,
+            p_end.bytes - p_start.bytes};
+}
+
+//! @brief Gets the peak resident set size of this process.
+//! @returns The peak resident set size in kilobytes.
+inline long Peak_RSS_Kilobytes()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+//! @brief Records an allocation and forwards it to malloc.
+inline void* allocate(const std::size_t p_size) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(p_size, std::memory_order_relaxed);
+    return std::malloc(0 == p_size ? 1 : p_size);
+}
+
+//! @brief Records an over-aligned allocation and forwards it to
+//! aligned_alloc. std::pmr::new_delete_resource() allocates this way.
+inline void* allocate(const std::size_t p_size,
+                      const std::align_val_t p_alignment) noexcept
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(p_size, std::memory_order_relaxed);
+
+    // aligned_alloc requires the size to be a multiple of the alignment.
+    const auto alignment{static_cast<std::size_t>(p_alignment)};
+    const std::size_t size{(std::max<std::size_t>(p_size, 1) + alignment - 1) /
+                           alignment * alignment};
+    return std::aligned_alloc(alignment, size);
+}
+}  // namespace Allocation_Counter
+
+// GCC cannot see that these replacements pair malloc with free, so warns that
+// the allocation functions are mismatched when they are inlined.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(const std::size_t p_size)
+{
+    void* const pointer{Allocation_Counter::allocate(p_size)};
+    if (nullptr == pointer)
+    {
+        throw std::bad_alloc{};
+    }
+    return pointer;
+}
+
+void* operator new[](const std::size_t p_size)
+{
+    return operator new(p_size);
+}
+
+void* operator new(const std::size_t p_size, const std::nothrow_t&) noexcept
+{
+    return Allocation_Counter::allocate(p_size);
+}
+
+void* operator new[](const std::size_t p_size, const std::nothrow_t&) noexcept
+{
+    return Allocation_Counter::allocate(p_size);
+}
+
+void* operator new(const std::size_t p_size, const std::align_val_t p_alignment)
+{
+    void* const pointer{Allocation_Counter::allocate(p_size, p_alignment)};
+    if (nullptr == pointer)
+    {
+        throw std::bad_alloc{};
+    }
+    return pointer;
+}
+
+void* operator new[](const std::size_t p_size,
+                     const std::align_val_t p_alignment)
+{
+    return operator new(p_size, p_alignment);
+}
+
+void* operator new(const std::size_t p_size,
+                   const std::align_val_t p_alignment,
+                   const std::nothrow_t&) noexcept
+{
+    return Allocation_Counter::allocate(p_size, p_alignment);
+}
+
+void* operator new[](const std::size_t p_size,
+                     const std::align_val_t p_alignment,
+                     const std::nothrow_t&) noexcept
+{
+    return Allocation_Counter::allocate(p_size, p_alignment);
+}
+
+void operator delete(void* const p_pointer) noexcept
+{
+    std::free(p_pointer);
+}
+
+void operator delete[](void* const p_pointer) noexcept
+{
+    std::free(p_pointer);
+}
+
+void operator delete(void* const p_pointer, std::size_t) noexcept
+{
+    std::free(p_pointer);
+}
+
+void operator delete[](void* const p_pointer, std::size_t) noexcept
+{
+    std::free(p_pointer);
+}
+
+void operator delete(void* const p_pointer, std::align_val_t) noexcept
+{
+    std::free(p_pointer);
+}
+
+void operator delete[](void* const p_pointer, std::align_val_t) noexcept
+{
+    std::free(p_pointer);
+}
+
+void operator delete(void* const p_pointer,
+                     std::size_t,
+                     std::align_val_t) noexcept
+{
+    std::free(p_pointer);
+}
+
+void operator delete[](void* const p_pointer,
+                       std::size_t,
+                       std::align_val_t) noexcept
+{
+    std::free(p_pointer);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif  // BENCHMARK_ALLOCATION_COUNTER_HPP
@@ -0,0 +1,383 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Benchmarks.cpp
+ *  @brief Measures the rate at which traces can be added and saved, across a
+ *  sweep of sample types and trace set shapes. The results are printed as
+ *  JSON so that they can be compared between builds.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <chrono>     // for steady_clock, duration
+#include <cstdint>    // for uint8_t, uint16_t, uint32_t
+#include <cstdio>     // for remove
+#include <cstdlib>    // for strtoul
+#include <fstream>    // for ofstream
+#include <iostream>   // for cout, cerr
+#include <memory_resource>  // for memory_resource, get_default_resource
+#include <random>     // for mt19937, uniform_int_distribution
+#include <sstream>    // for ostringstream
+#include <stdexcept>  // for invalid_argument
+#include <string>     // for string
+#include <vector>     // for vector
+
+#include "Traces_Serialiser.hpp"  // for Serialiser, Save_Stats, ...
+
+namespace
+{
+//! The file each benchmark saves to. This is removed afterwards.
+constexpr char file_path[]{"Benchmark_Traces.trs"};
+
+//! @brief The shape of the trace set used by a single benchmark.
+struct Configuration
+{
+    std::size_t number_of_traces;
+    std::size_t samples_per_trace;
+    //! Whether every other trace is shorter, so needs padding when saved.
+    bool ragged;
+    //! Whether each trace has 16 bytes of hexadecimal extra data.
+    bool extra_data;
+    //! Whether the traces are stored in a Huge_Page_Arena rather than
+    //! allocated with new.
+    bool huge_page_arena;
+};
+
+//! @brief Settings given on the command line.
+struct Options
+{
+    std::vector<std::size_t> number_of_traces{100, 1000};
+    std::vector<std::size_t> samples_per_trace{1000, 5000};
+    //! The number of times each benchmark is run. The fastest run is kept.
+    std::size_t repetitions{3};
+    //! The memory resources the traces are stored in. Either "default" or
+    //! "huge_page_arena".
+    std::vector<std::string> memory_resources{"default", "huge_page_arena"};
+    //! If not empty, the JSON is written here rather than to stdout.
+    std::string output{};
+};
+
+//! @brief The results of a single benchmark.
+struct Result
+{
+    double add_trace_seconds;
+    double save_seconds;
+    std::uintmax_t file_size;
+    Traces_Serialiser::Save_Stats stats;
+};
+
+//! @brief Generates a trace set for p_configuration with random samples.
+//! The same seed is used each time so that runs are comparable.
+template <typename T_Sample>
+std::vector<std::vector<T_Sample>>
+generate_traces(const Configuration& p_configuration)
+{
+    std::mt19937 generator{42};
+    std::uniform_int_distribution<int> distribution{0, 255};
+
+    std::vector<std::vector<T_Sample>> traces(p_configuration.number_of_traces);
+    for (std::size_t i{0}; i < traces.size(); ++i)
+    {
+        const std::size_t length{p_configuration.ragged && 1 == i % 2
+                                     ? p_configuration.samples_per_trace / 2
+                                     : p_configuration.samples_per_trace};
+        traces[i].resize(length);
+        for (auto& sample : traces[i])
+        {
+            sample = static_cast<T_Sample>(distribution(generator));
+        }
+    }
+    return traces;
+}
+
+//! @brief Generates hexadecimal extra data for every trace, if requested.
+std::vector<std::string> generate_extra_data(const Configuration& p_configuration)
+{
+    if (!p_configuration.extra_data)
+    {
+        return std::vector<std::string>(p_configuration.number_of_traces);
+    }
+
+    std::mt19937 generator{7};
+    std::uniform_int_distribution<int> distribution{0, 15};
+    constexpr char digits[]{"0123456789abcdef"};
+
+    std::vector<std::string> extra_data(p_configuration.number_of_traces);
+    for (auto& data : extra_data)
+    {
+        for (std::size_t i{0}; i < 32; ++i)
+        {
+            data.push_back(digits[distribution(generator)]);
+        }
+    }
+    return extra_data;
+}
+
+//! @brief Adds every trace to a Serialiser one at a time and then saves it,
+//! timing both.
+template <typename T_Sample>
+Result run_once(const Configuration& p_configuration,
+                const std::vector<std::vector<T_Sample>>& p_traces,
+                const std::vector<std::string>& p_extra_data)
+{
+    Result result{};
+
+    // The arena is created and destroyed inside the timings as both are part
+    // of the cost of using it.
+    const auto start{std::chrono::steady_clock::now()};
+    Traces_Serialiser::Huge_Page_Arena arena{};
+    Traces_Serialiser::Serialiser<T_Sample> serialiser{
+        p_configuration.huge_page_arena
+            ? static_cast<std::pmr::memory_resource*>(&arena)
+            : std::pmr::get_default_resource()};
+    for (std::size_t i{0}; i < p_traces.size(); ++i)
+    {
+        serialiser.Add_Trace(p_traces[i], p_extra_data[i]);
+    }
+    const auto added{std::chrono::steady_clock::now()};
+
+    serialiser.Save(file_path, &result.stats);
+    const auto saved{std::chrono::steady_clock::now()};
+
+    result.add_trace_seconds =
+        std::chrono::duration<double>(added - start).count();
+    result.save_seconds = std::chrono::duration<double>(saved - added).count();
+
+    std::ifstream file{file_path, std::ios::binary | std::ios::ate};
+    result.file_size = static_cast<std::uintmax_t>(file.tellg());
+    file.close();
+    std::remove(file_path);
+
+    return result;
+}
+
+//! @brief Converts p_duration to seconds.
+double seconds(const std::chrono::nanoseconds p_duration)
+{
+    return std::chrono::duration<double>(p_duration).count();
+}
+
+//! @brief Runs the benchmark for p_configuration p_repetitions times and
+//! appends the fastest result to p_json as a JSON object.
+template <typename T_Sample>
+void benchmark(const std::string& p_type_name,
+               const Configuration& p_configuration,
+               const std::size_t p_repetitions,
+               std::ostringstream& p_json)
+{
+    const auto traces{generate_traces<T_Sample>(p_configuration)};
+    const auto extra_data{generate_extra_data(p_configuration)};
+
+    std::size_t samples{0};
+    for (const auto& trace : traces)
+    {
+        samples += trace.size();
+    }
+
+    Result best{};
+    for (std::size_t i{0}; i < p_repetitions; ++i)
+    {
+        const Result result{run_once(p_configuration, traces, extra_data)};
+        if (0 == i || result.save_seconds + result.add_trace_seconds <
+                          best.save_seconds + best.add_trace_seconds)
+        {
+            best = result;
+        }
+    }
+
+    const double input_megabytes{
+        static_cast<double>(samples * sizeof(T_Sample)) / 1e6};
+    const double file_megabytes{static_cast<double>(best.file_size) / 1e6};
+
+    p_json << "    {\"sample_type\": \"" << p_type_name << "\", "
+           << "\"number_of_traces\": " << p_configuration.number_of_traces
+           << ", \"samples_per_trace\": " << p_configuration.samples_per_trace
+           << ", \"ragged\": " << (p_configuration.ragged ? "true" : "false")
+           << ", \"extra_data\": "
+           << (p_configuration.extra_data ? "true" : "false")
+           << ", \"memory_resource\": \""
+           << (p_configuration.huge_page_arena ? "huge_page_arena" : "default")
+           << "\", \"file_bytes\": " << best.file_size
+           << ", \"add_trace_seconds\": " << best.add_trace_seconds
+           << ", \"add_trace_traces_per_second\": "
+           << static_cast<double>(traces.size()) / best.add_trace_seconds
+           << ", \"add_trace_mb_per_second\": "
+           << input_megabytes / best.add_trace_seconds
+           << ", \"save_seconds\": " << best.save_seconds
+           << ", \"save_mb_per_second\": " << file_megabytes / best.save_seconds
+           << ", \"phase_seconds\": {"
+           << "\"padding\": " << seconds(best.stats.padding)
+           << ", \"header_encoding\": " << seconds(best.stats.header_encoding)
+           << ", \"extra_data_decoding\": "
+           << seconds(best.stats.extra_data_decoding)
+           << ", \"trace_encoding\": " << seconds(best.stats.trace_encoding)
+           << ", \"io\": " << seconds(best.stats.io) << "}}";
+}
+
+//! @brief Parses a comma separated list of sizes, e.g. "100,1000".
+std::vector<std::size_t> parse_sizes(const std::string& p_list)
+{
+    std::vector<std::size_t> sizes;
+    std::istringstream stream{p_list};
+    std::string size;
+    while (std::getline(stream, size, ','))
+    {
+        sizes.push_back(std::stoul(size));
+    }
+    return sizes;
+}
+
+//! @brief Parses a comma separated list of memory resources, e.g.
+//! "default,huge_page_arena".
+std::vector<std::string> parse_memory_resources(const std::string& p_list)
+{
+    std::vector<std::string> memory_resources;
+    std::istringstream stream{p_list};
+    std::string memory_resource;
+    while (std::getline(stream, memory_resource, ','))
+    {
+        if ("default" != memory_resource &&
+            "huge_page_arena" != memory_resource)
+        {
+            throw std::invalid_argument("Unknown memory resource " +
+                                        memory_resource);
+        }
+        memory_resources.push_back(memory_resource);
+    }
+    return memory_resources;
+}
+
+//! @brief Parses the command line.
+Options parse_options(const int p_argc, const char* const p_argv[])
+{
+    Options options{};
+    for (int i{1}; i < p_argc; ++i)
+    {
+        const std::string option{p_argv[i]};
+        if (i + 1 >= p_argc)
+        {
+            throw std::invalid_argument("Missing value for " + option);
+        }
+        const std::string value{p_argv[++i]};
+
+        if ("--traces" == option)
+        {
+            options.number_of_traces = parse_sizes(value);
+        }
+        else if ("--samples" == option)
+        {
+            options.samples_per_trace = parse_sizes(value);
+        }
+        else if ("--repetitions" == option)
+        {
+            options.repetitions = std::stoul(value);
+        }
+        else if ("--memory-resources" == option)
+        {
+            options.memory_resources = parse_memory_resources(value);
+        }
+        else if ("--output" == option)
+        {
+            options.output = value;
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option " + option);
+        }
+    }
+    return options;
+}
+}  // namespace
+
+//! @brief Runs every benchmark and prints the results as JSON.
+//! Usage: benchmarks [--traces 100,1000] [--samples 1000,5000]
+//!                   [--repetitions 3]
+//!                   [--memory-resources default,huge_page_arena]
+//!                   [--output results.json]
+int main(const int argc, const char* const argv[])
+{
+    Options options{};
+    try
+    {
+        options = parse_options(argc, argv);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n'
+                  << "Usage: " << argv[0]
+                  << " [--traces 100,1000] [--samples 1000,5000]"
+                     " [--repetitions 3]"
+                     " [--memory-resources default,huge_page_arena]"
+                     " [--output results.json]\n";
+        return 1;
+    }
+
+    std::ostringstream json;
+    json << "{\n  \"benchmarks\": [\n";
+
+    bool first{true};
+    for (const auto number_of_traces : options.number_of_traces)
+    {
+        for (const auto samples_per_trace : options.samples_per_trace)
+        {
+            for (const bool ragged : {false, true})
+            {
+                for (const bool extra_data : {false, true})
+                {
+                    for (const auto& memory_resource : options.memory_resources)
+                    {
+                        const Configuration configuration{
+                            number_of_traces,
+                            samples_per_trace,
+                            ragged,
+                            extra_data,
+                            "huge_page_arena" == memory_resource};
+
+                        json << (first ? "" : ",\n");
+                        first = false;
+                        benchmark<std::uint8_t>(
+                            "uint8", configuration, options.repetitions, json);
+                        json << ",\n";
+                        benchmark<std::uint16_t>(
+                            "uint16", configuration, options.repetitions, json);
+                        json << ",\n";
+                        benchmark<std::uint32_t>(
+                            "uint32", configuration, options.repetitions, json);
+                        json << ",\n";
+                        benchmark<float>(
+                            "float", configuration, options.repetitions, json);
+                    }
+                }
+            }
+        }
+    }
+    json << "\n  ]\n}\n";
+
+    if (options.output.empty())
+    {
+        std::cout << json.str();
+    }
+    else
+    {
+        std::ofstream output_file{options.output};
+        output_file << json.str();
+    }
+
+    return 0;
+}
@@ -0,0 +1,226 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*!
+ *  @file Memory_Profile.cpp
+ *  @brief Runs representative workloads through the Serialiser and reports
+ *  the peak resident set size, the total number of allocations and the bytes
+ *  allocated per trace saved. Optional budgets can be given on the command
+ *  line, in which case the program fails if any workload exceeds them.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>    // for uint8_t, uint16_t
+#include <cstdio>     // for remove
+#include <iostream>   // for cout, cerr
+#include <limits>     // for numeric_limits
+#include <stdexcept>  // for invalid_argument
+#include <string>     // for string, stod, stoul
+#include <vector>     // for vector
+
+#include "Allocation_Counter.hpp"  // for Snapshot, Difference, Peak_RSS_...
+#include "Traces_Serialiser.hpp"   // for Serialiser
+
+namespace
+{
+//! The file each workload saves to. This is removed afterwards.
+constexpr char file_path[]{"Memory_Profile_Traces.trs"};
+
+//! @brief The limits that each workload must stay within.
+struct Budgets
+{
+    double allocations_per_trace{std::numeric_limits<double>::max()};
+    double bytes_per_trace{std::numeric_limits<double>::max()};
+    long peak_rss_kilobytes{std::numeric_limits<long>::max()};
+};
+
+//! @brief The measurements taken for a single workload.
+struct Measurement
+{
+    Allocation_Counter::Counts add_trace;
+    Allocation_Counter::Counts save;
+    std::size_t number_of_traces;
+};
+
+//! @brief Adds p_number_of_traces traces to a Serialiser, every other one
+//! shorter if p_ragged is set so that padding is needed, and then saves them.
+template <typename T_Sample>
+Measurement run_workload(const std::size_t p_number_of_traces,
+                         const std::size_t p_samples_per_trace,
+                         const bool p_ragged)
+{
+    std::vector<T_Sample> trace(p_samples_per_trace);
+    for (std::size_t i{0}; i < trace.size(); ++i)
+    {
+        trace[i] = static_cast<T_Sample>(i);
+    }
+    std::vector<T_Sample> short_trace(p_ragged ? p_samples_per_trace / 2
+                                               : p_samples_per_trace);
+    std::copy(std::begin(trace),
+              std::begin(trace) +
+                  static_cast<std::ptrdiff_t>(short_trace.size()),
+              std::begin(short_trace));
+
+    Measurement measurement{};
+    measurement.number_of_traces = p_number_of_traces;
+    {
+        const auto start{Allocation_Counter::Snapshot()};
+        Traces_Serialiser::Serialiser<T_Sample> serialiser{};
+        for (std::size_t i{0}; i < p_number_of_traces; ++i)
+        {
+            serialiser.Add_Trace(1 == i % 2 ? short_trace : trace, "0123abcd");
+        }
+        const auto added{Allocation_Counter::Snapshot()};
+        serialiser.Save(file_path);
+        const auto saved{Allocation_Counter::Snapshot()};
+
+        measurement.add_trace = Allocation_Counter::Difference(start, added);
+        measurement.save = Allocation_Counter::Difference(added, saved);
+    }
+    std::remove(file_path);
+
+    return measurement;
+}
+
+//! @brief Prints p_measurement as a JSON object and checks it against
+//! p_budgets.
+//! @returns Whether all of the budgets were met.
+bool report(const std::string& p_name,
+            const Measurement& p_measurement,
+            const Budgets& p_budgets,
+            const bool p_last)
+{
+    const double traces{static_cast<double>(p_measurement.number_of_traces)};
+    const double allocations_per_trace{
+        static_cast<double>(p_measurement.add_trace.allocations +
+                            p_measurement.save.allocations) /
+        traces};
+    const double bytes_per_trace{
+        static_cast<double>(p_measurement.add_trace.bytes +
+                            p_measurement.save.bytes) /
+        traces};
+    const long peak_rss{Allocation_Counter::Peak_RSS_Kilobytes()};
+
+    std::cout << "    {\"workload\": \"" << p_name << "\", "
+              << "\"number_of_traces\": " << p_measurement.number_of_traces
+              << ", \"add_trace_allocations\": "
+              << p_measurement.add_trace.allocations
+              << ", \"add_trace_bytes\": " << p_measurement.add_trace.bytes
+              << ", \"save_allocations\": " << p_measurement.save.allocations
+              << ", \"save_bytes\": " << p_measurement.save.bytes
+              << ", \"allocations_per_trace\": " << allocations_per_trace
+              << ", \"bytes_per_trace\": " << bytes_per_trace
+              << ", \"peak_rss_kilobytes\": " << peak_rss << "}"
+              << (p_last ? "\n" : ",\n");
+
+    bool within_budget{true};
+    if (allocations_per_trace > p_budgets.allocations_per_trace)
+    {
+        std::cerr << p_name << ": " << allocations_per_trace
+                  << " allocations per trace exceeds the budget of "
+                  << p_budgets.allocations_per_trace << '\n';
+        within_budget = false;
+    }
+    if (bytes_per_trace > p_budgets.bytes_per_trace)
+    {
+        std::cerr << p_name << ": " << bytes_per_trace
+                  << " bytes per trace exceeds the budget of "
+                  << p_budgets.bytes_per_trace << '\n';
+        within_budget = false;
+    }
+    if (peak_rss > p_budgets.peak_rss_kilobytes)
+    {
+        std::cerr << p_name << ": peak RSS of " << peak_rss
+                  << " KiB exceeds the budget of "
+                  << p_budgets.peak_rss_kilobytes << " KiB\n";
+        within_budget = false;
+    }
+    return within_budget;
+}
+
+//! @brief Parses the command line.
+Budgets parse_budgets(const int p_argc, const char* const p_argv[])
+{
+    Budgets budgets{};
+    for (int i{1}; i < p_argc; ++i)
+    {
+        const std::string option{p_argv[i]};
+        if (i + 1 >= p_argc)
+        {
+            throw std::invalid_argument("Missing value for " + option);
+        }
+        const std::string value{p_argv[++i]};
+
+        if ("--max-allocations-per-trace" == option)
+        {
+            budgets.allocations_per_trace = std::stod(value);
+        }
+        else if ("--max-bytes-per-trace" == option)
+        {
+            budgets.bytes_per_trace = std::stod(value);
+        }
+        else if ("--max-peak-rss-kb" == option)
+        {
+            budgets.peak_rss_kilobytes = std::stol(value);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option " + option);
+        }
+    }
+    return budgets;
+}
+}  // namespace
+
+//! @brief Runs every workload, prints the measurements as JSON and checks them
+//! against any budgets given.
+//! @returns 0 if every workload was within budget, 1 otherwise.
+int main(const int argc, const char* const argv[])
+{
+    Budgets budgets{};
+    try
+    {
+        budgets = parse_budgets(argc, argv);
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n'
+                  << "Usage: " << argv[0]
+                  << " [--max-allocations-per-trace N]"
+                     " [--max-bytes-per-trace N] [--max-peak-rss-kb N]\n";
+        return 1;
+    }
+
+    bool within_budget{true};
+    std::cout << "{\n  \"workloads\": [\n";
+    within_budget &= report("uint8_uniform",
+                            run_workload<std::uint8_t>(2000, 5000, false),
+                            budgets,
+                            false);
+    within_budget &= report("uint16_ragged",
+                            run_workload<std::uint16_t>(2000, 5000, true),
+                            budgets,
+                            false);
+    within_budget &= report(
+        "float_uniform", run_workload<float>(2000, 5000, false), budgets, true);
+    std::cout << "  ]\n}\n";
+
+    return within_budget ? 0 : 1;
+}
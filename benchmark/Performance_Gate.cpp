@@ -0,0 +1,367 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*!
+ *  @file Performance_Gate.cpp
+ *  @brief Measures the throughput and allocations of Add_Trace(),
+ *  Add_Header() and Save() and compares them against a baseline. The program
+ *  fails if any throughput has dropped by more than the given tolerance, or
+ *  if any path makes more allocations than the baseline allows.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <algorithm>  // for max_element
+#include <chrono>     // for steady_clock, duration
+#include <cstdint>    // for uint16_t
+#include <cstdio>     // for remove
+#include <fstream>    // for ifstream, ofstream
+#include <functional> // for function
+#include <iomanip>    // for setprecision
+#include <iostream>   // for cout, cerr
+#include <iterator>   // for istreambuf_iterator
+#include <map>        // for map
+#include <regex>      // for regex, sregex_iterator
+#include <stdexcept>  // for invalid_argument, runtime_error
+#include <string>     // for string, stod, stoul
+#include <vector>     // for vector
+
+#include "Allocation_Counter.hpp"  // for Snapshot, Difference
+#include "Traces_Serialiser.hpp"   // for Serialiser
+
+namespace
+{
+//! The file the Save() benchmark writes to. This is removed afterwards.
+constexpr char file_path[]{"Performance_Gate_Traces.trs"};
+
+//! @brief Settings given on the command line.
+struct Options
+{
+    //! The baseline to compare against. If empty, nothing is compared.
+    std::string baseline{};
+    //! If not empty, the measurements are written here as a new baseline.
+    std::string write_baseline{};
+    //! The percentage that a throughput may drop below the baseline by.
+    double tolerance{20};
+    //! The number of untimed runs made before measuring.
+    std::size_t warm_up_runs{2};
+    //! The number of timed runs. The fastest is used, as it is the least
+    //! affected by other work on the machine.
+    std::size_t runs{7};
+};
+
+//! @brief The result of a single timed run.
+struct Run
+{
+    //! The number of operations, or bytes, processed per second.
+    double throughput;
+    //! The number of allocations made per operation.
+    double allocations;
+};
+
+//! @brief Runs p_workload p_options.warm_up_runs times untimed and then
+//! p_options.runs times timed.
+//! @param p_workload Performs the work being measured and returns the number
+//! of operations, or bytes, that were processed. p_timed_section is called
+//! around the part of the work that is to be timed.
+//! @param p_operations The number of operations that allocations are
+//! counted per.
+//! @returns The highest throughput and the allocations per operation.
+Run measure(const std::function<double(const std::function<void(
+                                           const std::function<void()>&)>&)>&
+                p_workload,
+            const double p_operations,
+            const Options& p_options)
+{
+    std::vector<double> throughputs;
+    double allocations{0};
+    for (std::size_t i{0}; i < p_options.warm_up_runs + p_options.runs; ++i)
+    {
+        double seconds{0};
+        Allocation_Counter::Counts counts{};
+        const auto timed_section{[&](const std::function<void()>& p_work) {
+            const auto start_counts{Allocation_Counter::Snapshot()};
+            const auto start{std::chrono::steady_clock::now()};
+            p_work();
+            const auto end{std::chrono::steady_clock::now()};
+            counts = Allocation_Counter::Difference(
+                start_counts, Allocation_Counter::Snapshot());
+            seconds = std::chrono::duration<double>(end - start).count();
+        }};
+
+        const double processed{p_workload(timed_section)};
+        if (i >= p_options.warm_up_runs)
+        {
+            throughputs.push_back(processed / seconds);
+            allocations = static_cast<double>(counts.allocations) / p_operations;
+        }
+    }
+
+    return {*std::max_element(std::begin(throughputs), std::end(throughputs)),
+            allocations};
+}
+
+//! @brief Generates p_number_of_traces traces of p_samples_per_trace samples.
+template <typename T_Sample>
+std::vector<std::vector<T_Sample>>
+generate_traces(const std::size_t p_number_of_traces,
+                const std::size_t p_samples_per_trace)
+{
+    std::vector<std::vector<T_Sample>> traces(
+        p_number_of_traces, std::vector<T_Sample>(p_samples_per_trace));
+    for (std::size_t i{0}; i < p_number_of_traces; ++i)
+    {
+        for (std::size_t j{0}; j < p_samples_per_trace; ++j)
+        {
+            traces[i][j] = static_cast<T_Sample>((i * 31 + j * 7) % 251);
+        }
+    }
+    return traces;
+}
+
+//! @brief Measures every core path.
+//! @returns The measurements, keyed by name.
+std::map<std::string, double> measure_all(const Options& p_options)
+{
+    std::map<std::string, double> results;
+
+    constexpr std::size_t add_trace_count{2000};
+    const auto traces{generate_traces<std::uint16_t>(add_trace_count, 1000)};
+    const Run add_trace{measure(
+        [&](const auto& p_timed_section) {
+            Traces_Serialiser::Serialiser<std::uint16_t> serialiser{};
+            p_timed_section([&] {
+                for (const auto& trace : traces)
+                {
+                    serialiser.Add_Trace(trace, "0123abcd");
+                }
+            });
+            return static_cast<double>(add_trace_count);
+        },
+        add_trace_count,
+        p_options)};
+    results["add_trace_traces_per_second"] = add_trace.throughput;
+    results["add_trace_allocations_per_trace"] = add_trace.allocations;
+
+    constexpr std::size_t add_header_count{20000};
+    const Run add_header{measure(
+        [&](const auto& p_timed_section) {
+            Traces_Serialiser::Serialiser<std::uint16_t> serialiser{};
+            p_timed_section([&] {
+                for (std::size_t i{0}; i < add_header_count / 4; ++i)
+                {
+                    serialiser.Set_Trace_Title("Benchmark trace");
+                    serialiser.Set_Axis_Scale_X(1e-9f);
+                    serialiser.Set_Trace_Offset(
+                        static_cast<std::uint32_t>(i));
+                    serialiser.Set_Scope_Range(0.5f);
+                }
+            });
+            return static_cast<double>(add_header_count);
+        },
+        add_header_count,
+        p_options)};
+    results["add_header_headers_per_second"] = add_header.throughput;
+    results["add_header_allocations_per_header"] = add_header.allocations;
+
+    constexpr std::size_t save_count{500};
+    const auto float_traces{generate_traces<float>(save_count, 2000)};
+    const Run save{measure(
+        [&](const auto& p_timed_section) {
+            Traces_Serialiser::Serialiser<float> serialiser{};
+            for (const auto& trace : float_traces)
+            {
+                serialiser.Add_Trace(trace, "0123abcd");
+            }
+            p_timed_section([&] { serialiser.Save(file_path); });
+
+            std::ifstream file{file_path, std::ios::binary | std::ios::ate};
+            const double megabytes{static_cast<double>(file.tellg()) / 1e6};
+            file.close();
+            std::remove(file_path);
+            return megabytes;
+        },
+        save_count,
+        p_options)};
+    results["save_megabytes_per_second"] = save.throughput;
+    results["save_allocations_per_trace"] = save.allocations;
+
+    return results;
+}
+
+//! @brief Writes p_results as a flat JSON object.
+void write_json(std::ostream& p_stream,
+                const std::map<std::string, double>& p_results)
+{
+    p_stream << std::setprecision(9) << "{\n";
+    for (auto it{std::begin(p_results)}; it != std::end(p_results); ++it)
+    {
+        p_stream << "  \"" << it->first << "\": " << it->second
+                 << (std::next(it) == std::end(p_results) ? "\n" : ",\n");
+    }
+    p_stream << "}\n";
+}
+
+//! @brief Reads a flat JSON object of numbers, as written by write_json().
+//! @exception std::runtime_error Thrown if the file cannot be opened.
+std::map<std::string, double> read_json(const std::string& p_file_path)
+{
+    std::ifstream file{p_file_path};
+    if (!file)
+    {
+        throw std::runtime_error("Unable to open baseline " + p_file_path);
+    }
+    const std::string contents{std::istreambuf_iterator<char>{file},
+                               std::istreambuf_iterator<char>{}};
+
+    const std::regex pair{R"re("([a-z_]+)"\s*:\s*([-+0-9.eE]+))re"};
+    std::map<std::string, double> values;
+    for (auto it{std::sregex_iterator{
+             std::begin(contents), std::end(contents), pair}};
+         it != std::sregex_iterator{};
+         ++it)
+    {
+        values[(*it)[1]] = std::stod((*it)[2]);
+    }
+    return values;
+}
+
+//! @brief Compares p_results against p_baseline. Throughputs, those ending in
+//! "_per_second", may drop by up to p_tolerance percent. Allocation counts
+//! must not exceed the baseline, other than by rounding in the baseline file.
+//! @returns Whether every measurement passed.
+bool compare(const std::map<std::string, double>& p_results,
+             const std::map<std::string, double>& p_baseline,
+             const double p_tolerance)
+{
+    bool passed{true};
+    for (const auto& [name, expected] : p_baseline)
+    {
+        const auto result{p_results.find(name)};
+        if (std::end(p_results) == result)
+        {
+            std::cerr << name << ": missing from the measurements\n";
+            passed = false;
+            continue;
+        }
+
+        const bool is_throughput{name.size() > 11 &&
+                                 0 == name.compare(name.size() - 11,
+                                                   11,
+                                                   "_per_second")};
+        if (is_throughput &&
+            result->second < expected * (1 - p_tolerance / 100))
+        {
+            std::cerr << name << ": " << result->second << " is more than "
+                      << p_tolerance << "% below the baseline of "
+                      << expected << '\n';
+            passed = false;
+        }
+        else if (!is_throughput && result->second > expected * 1.0001 + 1e-6)
+        {
+            std::cerr << name << ": " << result->second
+                      << " exceeds the baseline of " << expected << '\n';
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+//! @brief Parses the command line.
+Options parse_options(const int p_argc, const char* const p_argv[])
+{
+    Options options{};
+    for (int i{1}; i < p_argc; ++i)
+    {
+        const std::string option{p_argv[i]};
+        if (i + 1 >= p_argc)
+        {
+            throw std::invalid_argument("Missing value for " + option);
+        }
+        const std::string value{p_argv[++i]};
+
+        if ("--baseline" == option)
+        {
+            options.baseline = value;
+        }
+        else if ("--write-baseline" == option)
+        {
+            options.write_baseline = value;
+        }
+        else if ("--tolerance" == option)
+        {
+            options.tolerance = std::stod(value);
+        }
+        else if ("--warm-up-runs" == option)
+        {
+            options.warm_up_runs = std::stoul(value);
+        }
+        else if ("--runs" == option)
+        {
+            options.runs = std::stoul(value);
+            if (0 == options.runs)
+            {
+                throw std::invalid_argument("At least one run is required");
+            }
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown option " + option);
+        }
+    }
+    return options;
+}
+}  // namespace
+
+//! @brief Measures every core path, prints the results as JSON and compares
+//! them against the baseline, if one was given.
+//! @returns 0 if every measurement was within tolerance of the baseline, 1
+//! otherwise.
+int main(const int argc, const char* const argv[])
+{
+    try
+    {
+        const Options options{parse_options(argc, argv)};
+        const auto results{measure_all(options)};
+        write_json(std::cout, results);
+
+        if (!options.write_baseline.empty())
+        {
+            std::ofstream baseline{options.write_baseline};
+            write_json(baseline, results);
+        }
+
+        if (!options.baseline.empty() &&
+            !compare(results, read_json(options.baseline), options.tolerance))
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& exception)
+    {
+        std::cerr << exception.what() << '\n'
+                  << "Usage: " << argv[0]
+                  << " [--baseline Baseline.json] [--tolerance 20]"
+                     " [--warm-up-runs 2] [--runs 7]"
+                     " [--write-baseline Baseline.json]\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -1,6 +1,68 @@
-%module Traces_Serialiser
+// threads="1" allows the GIL to be released while native code runs. It is
+// only released for the calls marked with %thread below, as these can take a
+// long time and do not touch any Python objects.
+%module(threads="1") Traces_Serialiser
 %{
+#include <cstring>      // for strchr
+#include <type_traits>  // for is_floating_point
+
 #include "Traces_Serialiser.hpp"
+
+//! @brief Gets a read only view of the memory of p_object, which must support
+//! the buffer protocol, for example a NumPy array or bytes. This allows
+//! samples to be passed without converting each one to a Python object.
+//! @param p_object The object holding the samples.
+//! @param p_view Filled in with the view. This must be released with
+//! PyBuffer_Release() if this returns true.
+//! @param p_dimensions The number of dimensions the samples must have, or 0
+//! if they can have any number.
+//! @returns Whether the view was acquired. If not, a Python exception is set.
+template <typename T_Sample>
+bool get_samples(PyObject* p_object, Py_buffer& p_view, const int p_dimensions)
+{
+    if (0 != PyObject_GetBuffer(p_object,
+                                &p_view,
+                                PyBUF_C_CONTIGUOUS | PyBUF_FORMAT))
+    {
+        return false;
+    }
+
+    // Native and little endian byte orders are the same on the platforms
+    // supported.
+    const char* format{nullptr == p_view.format ? "B" : p_view.format};
+    if (nullptr != std::strchr("@=<", *format))
+    {
+        ++format;
+    }
+
+    const bool format_matches{
+        '\0' != format[0] && '\0' == format[1] &&
+        nullptr != std::strchr(std::is_floating_point<T_Sample>::value
+                                   ? "fd"
+                                   : "BHILQ",
+                               format[0])};
+    if (!format_matches || sizeof(T_Sample) != p_view.itemsize)
+    {
+        PyBuffer_Release(&p_view);
+        PyErr_Format(PyExc_TypeError,
+                     "Expected C-contiguous %s samples of %d bytes",
+                     std::is_floating_point<T_Sample>::value ? "floating point"
+                                                             : "unsigned",
+                     static_cast<int>(sizeof(T_Sample)));
+        return false;
+    }
+
+    if (0 != p_dimensions && p_dimensions != p_view.ndim)
+    {
+        PyBuffer_Release(&p_view);
+        PyErr_Format(PyExc_ValueError,
+                     "Expected an array with %d dimension(s)",
+                     p_dimensions);
+        return false;
+    }
+
+    return true;
+}
 %}
 
 %include "stdint.i"
@@ -14,6 +76,7 @@ namespace std {
     %template(vector_16) vector<uint16_t>;
     %template(vector_32) vector<uint32_t>;
     %template(vector_float) vector<float>;
+    %template(vector_string) vector<string>;
 
     %template(vector_2d_8) vector<vector<uint8_t>>;
     %template(vector_2d_16) vector<vector<uint16_t>>;
@@ -21,6 +84,216 @@ namespace std {
     %template(vector_2d_float) vector<vector<float>>;
 }
 
+// Any object supporting the buffer protocol, such as a C-contiguous NumPy
+// array of the matching dtype, can be passed where samples are given by a
+// pointer and size. The samples are used where they are, without converting
+// each one. These are checked before the std::vector overloads.
+%define %sample_buffer_typemaps(T_Sample)
+%typemap(typecheck, precedence=SWIG_TYPECHECK_POINTER)
+    (const T_Sample* const p_samples, const std::size_t p_size),
+    (const T_Sample* const p_samples, const std::size_t p_number_of_samples),
+    (const T_Sample* const p_samples,
+     const std::size_t p_number_of_traces,
+     const std::size_t p_samples_per_trace)
+{
+    $1 = PyObject_CheckBuffer($input) ? 1 : 0;
+}
+
+%typemap(in) (const T_Sample* const p_samples, const std::size_t p_size)
+    (Py_buffer view = {})
+{
+    if (!get_samples<T_Sample>($input, view, 1))
+    {
+        SWIG_fail;
+    }
+    $1 = static_cast<const T_Sample*>(view.buf);
+    $2 = static_cast<std::size_t>(view.shape[0]);
+}
+
+%typemap(in) (const T_Sample* const p_samples,
+              const std::size_t p_number_of_samples)
+    (Py_buffer view = {})
+{
+    if (!get_samples<T_Sample>($input, view, 0))
+    {
+        SWIG_fail;
+    }
+    $1 = static_cast<const T_Sample*>(view.buf);
+    $2 = static_cast<std::size_t>(view.len / view.itemsize);
+}
+
+%typemap(in) (const T_Sample* const p_samples,
+              const std::size_t p_number_of_traces,
+              const std::size_t p_samples_per_trace)
+    (Py_buffer view = {})
+{
+    if (!get_samples<T_Sample>($input, view, 2))
+    {
+        SWIG_fail;
+    }
+    $1 = static_cast<const T_Sample*>(view.buf);
+    $2 = static_cast<std::size_t>(view.shape[0]);
+    $3 = static_cast<std::size_t>(view.shape[1]);
+}
+
+%typemap(freearg) (const T_Sample* const p_samples, const std::size_t p_size),
+                  (const T_Sample* const p_samples,
+                   const std::size_t p_number_of_samples),
+                  (const T_Sample* const p_samples,
+                   const std::size_t p_number_of_traces,
+                   const std::size_t p_samples_per_trace)
+{
+    if (nullptr != view$argnum.obj)
+    {
+        PyBuffer_Release(&view$argnum);
+    }
+}
+%enddef
+
+%sample_buffer_typemaps(uint8_t)
+%sample_buffer_typemaps(uint16_t)
+%sample_buffer_typemaps(uint32_t)
+%sample_buffer_typemaps(float)
+%sample_buffer_typemaps(double)
+
+// Raw samples of any type, for Raw_Serialiser. The sample coding is given
+// separately, so only the size of the buffer in bytes is needed.
+%typemap(typecheck, precedence=SWIG_TYPECHECK_POINTER)
+    (const void* const p_samples, const std::size_t p_size),
+    (const void* const p_samples,
+     const std::size_t p_number_of_traces,
+     const std::size_t p_trace_size)
+{
+    $1 = PyObject_CheckBuffer($input) ? 1 : 0;
+}
+
+%typemap(in) (const void* const p_samples, const std::size_t p_size)
+    (Py_buffer view = {})
+{
+    if (0 != PyObject_GetBuffer($input, &view, PyBUF_C_CONTIGUOUS))
+    {
+        SWIG_fail;
+    }
+    $1 = view.buf;
+    $2 = static_cast<std::size_t>(view.len);
+}
+
+// A 2D array of traces, one trace per row.
+%typemap(in) (const void* const p_samples,
+              const std::size_t p_number_of_traces,
+              const std::size_t p_trace_size)
+    (Py_buffer view = {})
+{
+    if (0 != PyObject_GetBuffer($input, &view, PyBUF_C_CONTIGUOUS))
+    {
+        SWIG_fail;
+    }
+    if (2 != view.ndim)
+    {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_ValueError, "Expected an array with 2 "
+                                          "dimensions");
+        SWIG_fail;
+    }
+    $1 = view.buf;
+    $2 = static_cast<std::size_t>(view.shape[0]);
+    $3 = 0 == view.shape[0]
+             ? 0
+             : static_cast<std::size_t>(view.len / view.shape[0]);
+}
+
+%typemap(freearg) (const void* const p_samples, const std::size_t p_size),
+                  (const void* const p_samples,
+                   const std::size_t p_number_of_traces,
+                   const std::size_t p_trace_size)
+{
+    if (nullptr != view$argnum.obj)
+    {
+        PyBuffer_Release(&view$argnum);
+    }
+}
+
+// Extra data given as raw bytes, for example bytes or a NumPy uint8 array.
+%typemap(typecheck, precedence=SWIG_TYPECHECK_POINTER)
+    (const std::uint8_t* const p_extra_data,
+     const std::size_t p_extra_data_size)
+{
+    $1 = PyObject_CheckBuffer($input) ? 1 : 0;
+}
+
+%typemap(in) (const std::uint8_t* const p_extra_data,
+              const std::size_t p_extra_data_size)
+    (Py_buffer view = {})
+{
+    if (!get_samples<std::uint8_t>($input, view, 0))
+    {
+        SWIG_fail;
+    }
+    $1 = static_cast<const std::uint8_t*>(view.buf);
+    $2 = static_cast<std::size_t>(view.len);
+}
+
+%typemap(freearg) (const std::uint8_t* const p_extra_data,
+                   const std::size_t p_extra_data_size)
+{
+    if (nullptr != view$argnum.obj)
+    {
+        PyBuffer_Release(&view$argnum);
+    }
+}
+
+// Traces are read into any writable buffer, such as a bytearray or NumPy
+// array, of exactly the right size.
+%typemap(typecheck, precedence=SWIG_TYPECHECK_POINTER)
+    (char* const p_buffer, const std::size_t p_buffer_size)
+{
+    $1 = PyObject_CheckBuffer($input) ? 1 : 0;
+}
+
+%typemap(in) (char* const p_buffer, const std::size_t p_buffer_size)
+    (Py_buffer view = {})
+{
+    if (0 != PyObject_GetBuffer($input,
+                                &view,
+                                PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE))
+    {
+        SWIG_fail;
+    }
+    $1 = static_cast<char*>(view.buf);
+    $2 = static_cast<std::size_t>(view.len);
+}
+
+%typemap(freearg) (char* const p_buffer, const std::size_t p_buffer_size)
+{
+    if (nullptr != view$argnum.obj)
+    {
+        PyBuffer_Release(&view$argnum);
+    }
+}
+
+// Headers are binary, so are returned as bytes rather than str.
+%typemap(out) std::string Traces_Serialiser::Reader::Get_Header
+{
+    $result = PyBytes_FromStringAndSize($1.data(), $1.size());
+}
+
+// Saving and adding traces are safe to run alongside other Python threads,
+// including ones adding traces to the same Serialiser during a save.
+%nothread;
+%thread Traces_Serialiser::Serialiser::Serialiser;
+%thread Traces_Serialiser::Serialiser::Add_Trace;
+%thread Traces_Serialiser::Serialiser::Add_Traces;
+%thread Traces_Serialiser::Serialiser::Save;
+%thread Traces_Serialiser::Header_Editor::Header_Editor;
+%thread Traces_Serialiser::Header_Editor::Save;
+%thread Traces_Serialiser::Stream_Writer::Append;
+%thread Traces_Serialiser::Stream_Writer::Close;
+%thread Traces_Serialiser::Raw_Serialiser::Add_Trace;
+%thread Traces_Serialiser::Raw_Serialiser::Add_Traces;
+%thread Traces_Serialiser::Raw_Serialiser::Save;
+%thread Traces_Serialiser::Reader::Reader;
+%thread Traces_Serialiser::Reader::Read_Traces;
+
 %include "Traces_Serialiser.hpp"
 
 namespace Traces_Serialiser {
@@ -29,4 +302,104 @@ namespace Traces_Serialiser {
     %template(Serialiser_32) Serialiser<uint32_t>;
     %template(Serialiser_float) Serialiser<float>;
     %template(Serialiser_double) Serialiser<double>;
+
+    %template(Stream_Writer_8) Stream_Writer<uint8_t>;
+    %template(Stream_Writer_16) Stream_Writer<uint16_t>;
+    %template(Stream_Writer_32) Stream_Writer<uint32_t>;
+    %template(Stream_Writer_float) Stream_Writer<float>;
+}
+
+%pythoncode %{
+import contextlib
+
+_stream_writers = {
+    "uint8": Stream_Writer_8,
+    "uint16": Stream_Writer_16,
+    "uint32": Stream_Writer_32,
+    "float32": Stream_Writer_float,
 }
+
+for _stream_writer in _stream_writers.values():
+    _stream_writer.append = _stream_writer.Append
+
+
+@contextlib.contextmanager
+def open_writer(path, dtype, samples, extra_data_length=0):
+    """Opens a writer that writes traces to the TRS file at path as they are
+    appended, so that any number of traces can be recorded in constant
+    memory. dtype is the type of the samples, e.g. numpy.float32 or "uint8",
+    and samples is the number of samples in every trace. The file is closed
+    when the with block ends.
+
+    with Traces_Serialiser.open_writer("capture.trs", numpy.uint8, 5000) as w:
+        w.Set_Trace_Title("Capture")
+        w.append(traces)
+    """
+    name = getattr(dtype, "__name__", None) or getattr(dtype, "name", str(dtype))
+    if name not in _stream_writers:
+        raise TypeError("Samples must be one of " + ", ".join(_stream_writers))
+
+    writer = _stream_writers[name](path, samples, extra_data_length)
+    try:
+        yield writer
+    finally:
+        writer.Close()
+
+
+class Trace_File(object):
+    """The traces of a TRS file, memory mapped so that they are only read
+    from disk as they are used.
+
+    samples is a 2D array of the samples of each trace, with the dtype given
+    by the sample coding of the file. data is a 2D uint8 array of the extra
+    data of each trace. traces is the structured array both are views of,
+    with the fields "data" and "samples". reader gives access to the headers.
+    """
+
+    # Integer samples are signed, as in the TRS specification.
+    _dtypes = {(1, False): "i1", (2, False): "<i2", (4, False): "<i4",
+               (2, True): "<f2", (4, True): "<f4"}
+
+    def __init__(self, path, mode="r"):
+        import numpy
+
+        self.reader = Reader(path)
+        sample_type = (self.reader.Get_Sample_Length(),
+                       self.reader.Is_Floating_Point())
+        if sample_type not in self._dtypes:
+            raise TypeError("The sample coding of the file is not supported")
+
+        record = numpy.dtype([
+            ("data", numpy.uint8, (self.reader.Get_Extra_Data_Length(),)),
+            ("samples", self._dtypes[sample_type],
+             (self.reader.Get_Samples_Per_Trace(),))])
+
+        # An empty file cannot be mapped.
+        number_of_traces = self.reader.Get_Number_Of_Traces()
+        if 0 == number_of_traces or 0 == record.itemsize:
+            self.traces = numpy.zeros(number_of_traces, dtype=record)
+        else:
+            self.traces = numpy.memmap(path, dtype=record, mode=mode,
+                                       offset=self.reader.Get_Data_Offset(),
+                                       shape=(number_of_traces,))
+        self.samples = self.traces["samples"]
+        self.data = self.traces["data"]
+
+    def __len__(self):
+        return len(self.traces)
+
+    def __getitem__(self, index):
+        return self.samples[index]
+
+
+def open(path, mode="r"):
+    """Opens the TRS file at path, returning a Trace_File. The headers are
+    parsed natively and the traces are memory mapped rather than read, so even
+    very large files open instantly. mode is passed to numpy.memmap, so "r+"
+    allows the traces to be modified in place.
+
+    traces = Traces_Serialiser.open("capture.trs")
+    mean = traces.samples[:1000].mean(axis=0)
+    """
+    return Trace_File(path, mode)
+%}
@@ -0,0 +1,92 @@
+#
+#   This file is part of Traces-Serialiser.
+#
+#   Traces-Serialiser is free software: you can redistribute it and/or modify
+#   it under the terms of the GNU Affero General Public License as published by
+#   the Free Software Foundation, either version 3 of the License, or
+#   (at your option) any later version.
+#
+#   Traces-Serialiser is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU Affero General Public License for more details.
+#
+#   You should have received a copy of the GNU Affero General Public License
+#   along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""Smoke tests for the Python bindings. These check that the typemaps and the
+Python helpers work, the library itself is covered by the C++ tests."""
+
+import os
+import sys
+import tempfile
+import unittest
+
+try:
+    import numpy
+except ImportError:
+    print("NumPy is not installed, skipping the Python tests")
+    sys.exit(77)  # Reported by CTest as skipped
+
+import Traces_Serialiser
+
+
+class Test_Bindings(unittest.TestCase):
+
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        self.file_path = os.path.join(self.directory.name, "Test_Traces.trs")
+
+    def tearDown(self):
+        self.directory.cleanup()
+
+    def test_serialiser_from_array(self):
+        traces = numpy.arange(6, dtype=numpy.float32).reshape(2, 3)
+
+        serialiser = Traces_Serialiser.Serialiser_float(traces)
+        serialiser.Add_Traces(numpy.ascontiguousarray(traces[::-1]))
+        serialiser.Save(self.file_path)
+
+        saved = Traces_Serialiser.open(self.file_path)
+        self.assertEqual(4, len(saved))
+        self.assertEqual(numpy.float32, saved.samples.dtype.base)
+        numpy.testing.assert_array_equal(traces, saved.samples[:2])
+        numpy.testing.assert_array_equal(traces[::-1], saved.samples[2:])
+
+    def test_quantised_samples_are_signed(self):
+        traces = numpy.array([[-1.0, 0.0, 1.0], [0.5, -0.5, 0.0]],
+                             dtype=numpy.float32)
+
+        serialiser = Traces_Serialiser.Serialiser_float(traces)
+        serialiser.Set_Quantisation(1)
+        serialiser.Save(self.file_path)
+
+        saved = Traces_Serialiser.open(self.file_path)
+        self.assertEqual(numpy.int8, saved.samples.dtype.base)
+        numpy.testing.assert_array_equal([[-127, 0, 127], [64, -64, 0]],
+                                         saved.samples)
+
+    def test_array_of_the_wrong_dtype(self):
+        traces = numpy.zeros((2, 3), dtype=numpy.float64)
+
+        with self.assertRaises(TypeError):
+            Traces_Serialiser.Serialiser_float(traces)
+
+    def test_open_writer(self):
+        traces = numpy.array([[1, 2, 3], [4, 5, 6]], dtype=numpy.uint8)
+
+        with Traces_Serialiser.open_writer(self.file_path, numpy.uint8, 3,
+                                           extra_data_length=1) as writer:
+            writer.Set_Trace_Title("Smoke test")
+            writer.append(traces, b"\xab\xcd")
+
+        saved = Traces_Serialiser.open(self.file_path)
+        numpy.testing.assert_array_equal(traces, saved.samples)
+        numpy.testing.assert_array_equal([[0xab], [0xcd]], saved.data)
+        self.assertEqual(b"Smoke test", saved.reader.Get_Header(
+            Traces_Serialiser.Headers.Tag_Trace_Title))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,42 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Traces_Serialiser.cpp
+ *  @brief Instantiates the common sample types of Serialiser and
+ *  Stream_Writer for the optional compiled library. Code linked against it
+ *  sees these as extern templates so does not instantiate them again.
+ *  @author Scott Egerton
+ *  @date 2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>  // for uint8_t, uint16_t, uint32_t
+
+#include "Traces_Serialiser.hpp"  // for Serialiser, Stream_Writer
+
+namespace Traces_Serialiser
+{
+template class Serialiser<std::uint8_t>;
+template class Serialiser<std::uint16_t>;
+template class Serialiser<std::uint32_t>;
+template class Serialiser<float>;
+template class Stream_Writer<std::uint8_t>;
+template class Stream_Writer<std::uint16_t>;
+template class Stream_Writer<std::uint32_t>;
+template class Stream_Writer<float>;
+}  // namespace Traces_Serialiser
@@ -35,8 +35,8 @@
 
 /*!
  *  @file Traces_Serialiser.hpp
- *  @brief This file contains the logic behind Traces_Serialiser. This is the
- *  only file needed to use this tool.
+ *  @brief This file contains the logic behind Traces_Serialiser. This and
+ *  Traces_Serialiser_Fwd.hpp are the only files needed to use this tool.
  *  @author Scott Egerton
  *  @date 2018
  *  @copyright GNU Affero General Public License Version 3+
@@ -45,930 +45,5790 @@
 #ifndef SRC_TRACES_SERIALISER_HPP
 #define SRC_TRACES_SERIALISER_HPP
 
-#include <algorithm>    // for remove_if
+#include <algorithm>    // for remove_if, clamp, transform, minmax_element
+#include <array>        // for array
+#include <atomic>       // for atomic, memory_order_relaxed
+#include <chrono>       // for steady_clock, nanoseconds
+#include <cerrno>       // for errno, EINTR
+#include <condition_variable>  // for condition_variable
 #include <cstddef>      // for byte
-#include <cstdint>      // for uint8_t, uint32_t
-#include <fstream>      // for ofstream
+#include <cmath>        // for sin, cos, sqrt, nearbyint, abs, isfinite
+#include <cstdint>      // for uint8_t, uint32_t, uint64_t
+#include <cstdio>       // for remove, rename, tmpfile, fclose
+#include <cstring>      // for memcpy
+#include <fstream>      // for ofstream, ifstream, fstream
+#include <istream>      // for istream
 #include <iomanip>      // for setw, setfill
+#include <functional>   // for minus, function
+#include <iterator>     // for data, size
 #include <ios>          // for failure
-#include <map>          // for map
+#include <ostream>      // for ostream
+#include <limits>       // for numeric_limits
+#include <memory>       // for align, shared_ptr, make_shared
+#include <memory_resource>  // for memory_resource, polymorphic_allocator
+#include <mutex>        // for mutex, recursive_mutex, unique_lock
+#include <new>          // for bad_alloc, align_val_t
+#include <numeric>      // for accumulate
+#include <optional>     // for optional
 #include <sstream>      // for ostringstream
-#include <stdexcept>    // for range_error
+#include <stdexcept>    // for range_error, length_error
 #include <string>       // for string
-#include <type_traits>  // for is_arithmetic, is_floating_point, is_same
+#include <thread>       // for thread
+#include <type_traits>  // for is_arithmetic, is_floating_point, is_same,
+                        // conditional
 #include <utility>      // for move, pair
 #include <vector>       // for vector
 
+#include "Traces_Serialiser_Fwd.hpp"  // for Serialiser, Stream_Writer, ...
+
+#if __has_include(<unistd.h>)
+#include <fcntl.h>     // for open, fallocate, O_WRONLY, O_RDWR
+#include <sys/stat.h>  // for fstat, stat
+#include <unistd.h>    // for fsync, close, pwrite
+#endif
+
+#if __has_include(<sys/mman.h>)
+#include <sys/mman.h>  // for mmap, munmap, madvise
+#endif
+
+#if defined(__linux__) && __has_include(<linux/falloc.h>)
+#include <linux/falloc.h>  // for FALLOC_FL_INSERT_RANGE, ...
+#endif
+
 namespace Traces_Serialiser
 {
-//! @class Serialiser
-//! @brief This is the main class that is used in order to serialise traces.
-//! Currently it supports saving in the format used by Riscure's inspector
-//! tool.
-//! @see https://www.riscure.com/security-tools/inspector-sca/
-template <typename T_Sample = float> class Serialiser
+//! @brief The time taken by each phase of Serialiser::Save() and the amount
+//! written. This allows the cost of saving to be measured and any regressions
+//! to be found.
+struct Save_Stats
 {
-    // Ensure that the template type T_Sample is arithmetic.
-    static_assert(std::is_arithmetic<T_Sample>::value,
-                  "Traces must be stored as a number");
+    //! Checking that the headers and extra data will create a valid file.
+    std::chrono::nanoseconds validation{};
+    //! Making all traces the same length.
+    std::chrono::nanoseconds padding{};
+    //! Building the headers and encoding them ready to be written.
+    std::chrono::nanoseconds header_encoding{};
+    //! Validating the extra data and decoding it into the bytes written.
+    std::chrono::nanoseconds extra_data_decoding{};
+    //! Encoding the samples into the bytes written.
+    std::chrono::nanoseconds trace_encoding{};
+    //! Opening, writing to and closing the file.
+    std::chrono::nanoseconds io{};
+    //! Flushing the file to disk, if enabled with Set_Sync_On_Save().
+    std::chrono::nanoseconds fsync{};
+    //! The whole save.
+    std::chrono::nanoseconds total{};
+    //! The number of bytes written so far, including the headers.
+    std::uint64_t bytes_written{0};
+    //! The number of traces written so far.
+    std::uint64_t traces_written{0};
+    //! The number of traces that will be written in total.
+    std::uint64_t traces_to_write{0};
+    //! The average rate at which the file was written, in MB/s.
+    double megabytes_per_second{0};
+    //! Whether the save was cancelled by the progress callback.
+    bool cancelled{false};
+};
+
+//! @brief Called periodically by Serialiser::Save() with the progress made so
+//! far.
+//! @returns false to cancel the save, in which case the partially written
+//! file is removed.
+using Save_Progress_Callback = std::function<bool(const Save_Stats&)>;
+
+//! @class Latency_Histogram
+//! @brief A histogram of durations that can be recorded to and read from
+//! different threads without locking. The buckets are cumulative upper
+//! bounds, as used by Prometheus.
+class Latency_Histogram
+{
+public:
+    //! The number of buckets, excluding the implicit +Inf bucket.
+    constexpr static std::size_t Bucket_Count{8};
+
+    //! The upper bound of each bucket in nanoseconds, from 1us to 10s.
+    constexpr static std::array<std::uint64_t, Bucket_Count> Bucket_Bounds{
+        1'000,
+        10'000,
+        100'000,
+        1'000'000,
+        10'000'000,
+        100'000'000,
+        1'000'000'000,
+        10'000'000'000};
+
+    Latency_Histogram() : m_buckets{}, m_count{0}, m_sum{0} {}
+
+    //! @brief Takes a snapshot of p_other.
+    Latency_Histogram(const Latency_Histogram& p_other) : Latency_Histogram{}
+    {
+        *this = p_other;
+    }
+
+    //! @brief Takes a snapshot of p_other.
+    Latency_Histogram& operator=(const Latency_Histogram& p_other)
+    {
+        for (std::size_t i{0}; i < Bucket_Count; ++i)
+        {
+            m_buckets[i].store(p_other.Get_Bucket(i),
+                               std::memory_order_relaxed);
+        }
+        m_count.store(p_other.Get_Count(), std::memory_order_relaxed);
+        m_sum.store(p_other.Get_Sum().count(), std::memory_order_relaxed);
+        return *this;
+    }
+
+    //! @brief Records a single duration.
+    void Record(const std::chrono::nanoseconds p_duration)
+    {
+        const auto nanoseconds{static_cast<std::uint64_t>(p_duration.count())};
+        for (std::size_t i{0}; i < Bucket_Count; ++i)
+        {
+            if (nanoseconds <= Bucket_Bounds[i])
+            {
+                m_buckets[i].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(p_duration.count(), std::memory_order_relaxed);
+    }
+
+    //! @returns The number of durations no longer than Bucket_Bounds[p_index].
+    std::uint64_t Get_Bucket(const std::size_t p_index) const
+    {
+        return m_buckets[p_index].load(std::memory_order_relaxed);
+    }
+
+    //! @returns The number of durations recorded.
+    std::uint64_t Get_Count() const
+    {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    //! @returns The sum of all durations recorded.
+    std::chrono::nanoseconds Get_Sum() const
+    {
+        return std::chrono::nanoseconds{m_sum.load(std::memory_order_relaxed)};
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, Bucket_Count> m_buckets;
+    std::atomic<std::uint64_t> m_count;
+    std::atomic<std::chrono::nanoseconds::rep> m_sum;
+};
+
+//! @class Metrics
+//! @brief Counters describing the work done by a Serialiser. These are
+//! updated by the thread using the Serialiser and can be read from any other
+//! thread at any time without locking, so that long running acquisitions can
+//! be monitored. Reads are not synchronised with each other, so values read
+//! during a save may be from slightly different points in time.
+class Metrics
+{
+public:
+    Metrics()
+        : m_traces_ingested{0}, m_traces_dropped{0}, m_queue_depth{0},
+          m_bytes_pending{0}, m_bytes_written{0},
+          m_megabytes_per_second_bits{0}, m_encode_latency{},
+          m_write_latency{}
+    {
+    }
+
+    //! @brief Takes a snapshot of p_other.
+    Metrics(const Metrics& p_other) : Metrics{} { *this = p_other; }
+
+    //! @brief Takes a snapshot of p_other.
+    Metrics& operator=(const Metrics& p_other)
+    {
+        m_traces_ingested.store(p_other.Get_Traces_Ingested());
+        m_traces_dropped.store(p_other.Get_Traces_Dropped());
+        m_queue_depth.store(p_other.Get_Queue_Depth());
+        m_bytes_pending.store(p_other.Get_Bytes_Pending());
+        m_bytes_written.store(p_other.Get_Bytes_Written());
+        m_megabytes_per_second_bits.store(
+            p_other.m_megabytes_per_second_bits.load());
+        m_encode_latency = p_other.m_encode_latency;
+        m_write_latency = p_other.m_write_latency;
+        return *this;
+    }
+
+    //! @returns The number of traces given to Add_Trace().
+    std::uint64_t Get_Traces_Ingested() const
+    {
+        return m_traces_ingested.load(std::memory_order_relaxed);
+    }
+
+    //! @returns The number of traces rejected rather than stored.
+    std::uint64_t Get_Traces_Dropped() const
+    {
+        return m_traces_dropped.load(std::memory_order_relaxed);
+    }
+
+    //! @returns The number of traces stored since the last completed save.
+    std::uint64_t Get_Queue_Depth() const
+    {
+        return m_queue_depth.load(std::memory_order_relaxed);
+    }
+
+    //! @returns The number of sample bytes stored since the last completed
+    //! save.
+    std::uint64_t Get_Bytes_Pending() const
+    {
+        return m_bytes_pending.load(std::memory_order_relaxed);
+    }
+
+    //! @returns The number of bytes written by all saves.
+    std::uint64_t Get_Bytes_Written() const
+    {
+        return m_bytes_written.load(std::memory_order_relaxed);
+    }
+
+    //! @returns The rate at which the current, or last, save is writing in
+    //! MB/s.
+    double Get_Megabytes_Per_Second() const
+    {
+        const std::uint64_t bits{
+            m_megabytes_per_second_bits.load(std::memory_order_relaxed)};
+        double megabytes_per_second{0};
+        std::memcpy(&megabytes_per_second, &bits, sizeof(bits));
+        return megabytes_per_second;
+    }
+
+    //! @returns The time taken to encode each trace while saving.
+    const Latency_Histogram& Get_Encode_Latency() const
+    {
+        return m_encode_latency;
+    }
+
+    //! @returns The time taken to write each trace while saving.
+    const Latency_Histogram& Get_Write_Latency() const
+    {
+        return m_write_latency;
+    }
+
+    //! @brief Writes every metric to p_stream in the Prometheus text
+    //! exposition format.
+    //! @see https://prometheus.io/docs/instrumenting/exposition_formats/
+    void Write_Prometheus(std::ostream& p_stream) const
+    {
+        const auto write_counter{[&p_stream](const char* const p_name,
+                                             const char* const p_type,
+                                             const char* const p_help,
+                                             const auto p_value) {
+            p_stream << "# HELP traces_serialiser_" << p_name << ' ' << p_help
+                     << "\n# TYPE traces_serialiser_" << p_name << ' ' << p_type
+                     << "\ntraces_serialiser_" << p_name << ' ' << p_value
+                     << '\n';
+        }};
+
+        write_counter("traces_ingested_total",
+                      "counter",
+                      "Traces given to Add_Trace().",
+                      Get_Traces_Ingested());
+        write_counter("traces_dropped_total",
+                      "counter",
+                      "Traces rejected rather than stored.",
+                      Get_Traces_Dropped());
+        write_counter("queue_depth",
+                      "gauge",
+                      "Traces stored since the last completed save.",
+                      Get_Queue_Depth());
+        write_counter("bytes_pending",
+                      "gauge",
+                      "Sample bytes stored since the last completed save.",
+                      Get_Bytes_Pending());
+        write_counter("bytes_written_total",
+                      "counter",
+                      "Bytes written by all saves.",
+                      Get_Bytes_Written());
+        write_counter("write_megabytes_per_second",
+                      "gauge",
+                      "Rate of the current or last save in MB/s.",
+                      Get_Megabytes_Per_Second());
+
+        write_histogram(p_stream,
+                        "encode_latency_seconds",
+                        "Time taken to encode each trace while saving.",
+                        m_encode_latency);
+        write_histogram(p_stream,
+                        "write_latency_seconds",
+                        "Time taken to write each trace while saving.",
+                        m_write_latency);
+    }
+
+    //! @brief Records that a trace was given to Add_Trace().
+    void Trace_Ingested()
+    {
+        m_traces_ingested.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //! @brief Records that a trace was rejected rather than stored.
+    void Trace_Dropped()
+    {
+        m_traces_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //! @brief Records that a trace of p_bytes bytes was stored.
+    void Trace_Stored(const std::uint64_t p_bytes)
+    {
+        m_queue_depth.fetch_add(1, std::memory_order_relaxed);
+        m_bytes_pending.fetch_add(p_bytes, std::memory_order_relaxed);
+    }
+
+    //! @brief Records that a trace was encoded in p_encode_time and written in
+    //! p_write_time.
+    void Trace_Written(const std::uint64_t p_bytes,
+                       const std::chrono::nanoseconds p_encode_time,
+                       const std::chrono::nanoseconds p_write_time)
+    {
+        m_bytes_written.fetch_add(p_bytes, std::memory_order_relaxed);
+        m_encode_latency.Record(p_encode_time);
+        m_write_latency.Record(p_write_time);
+    }
+
+    //! @brief Records the rate the current save is writing at.
+    void Set_Megabytes_Per_Second(const double p_megabytes_per_second)
+    {
+        std::uint64_t bits{0};
+        std::memcpy(&bits, &p_megabytes_per_second, sizeof(bits));
+        m_megabytes_per_second_bits.store(bits, std::memory_order_relaxed);
+    }
+
+    //! @brief Records that a save completed, so nothing is pending.
+    void Save_Completed()
+    {
+        m_queue_depth.store(0, std::memory_order_relaxed);
+        m_bytes_pending.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    //! @brief Writes p_histogram to p_stream in the Prometheus text
+    //! exposition format.
+    static void write_histogram(std::ostream& p_stream,
+                                const char* const p_name,
+                                const char* const p_help,
+                                const Latency_Histogram& p_histogram)
+    {
+        p_stream << "# HELP traces_serialiser_" << p_name << ' ' << p_help
+                 << "\n# TYPE traces_serialiser_" << p_name << " histogram\n";
+        for (std::size_t i{0}; i < Latency_Histogram::Bucket_Count; ++i)
+        {
+            p_stream << "traces_serialiser_" << p_name << "_bucket{le=\""
+                     << static_cast<double>(
+                            Latency_Histogram::Bucket_Bounds[i]) /
+                            1e9
+                     << "\"} " << p_histogram.Get_Bucket(i) << '\n';
+        }
+        p_stream << "traces_serialiser_" << p_name << "_bucket{le=\"+Inf\"} "
+                 << p_histogram.Get_Count() << '\n'
+                 << "traces_serialiser_" << p_name << "_sum "
+                 << std::chrono::duration<double>(p_histogram.Get_Sum())
+                        .count()
+                 << "\ntraces_serialiser_" << p_name << "_count "
+                 << p_histogram.Get_Count() << '\n';
+    }
+
+    std::atomic<std::uint64_t> m_traces_ingested;
+    std::atomic<std::uint64_t> m_traces_dropped;
+    std::atomic<std::uint64_t> m_queue_depth;
+    std::atomic<std::uint64_t> m_bytes_pending;
+    std::atomic<std::uint64_t> m_bytes_written;
+
+    //! The bits of a double, as std::atomic<double> has no lock-free
+    //! guarantee.
+    std::atomic<std::uint64_t> m_megabytes_per_second_bits;
+
+    Latency_Histogram m_encode_latency;
+    Latency_Histogram m_write_latency;
+};
+
+//! @class Metrics_Dumper
+//! @brief Periodically writes Metrics to a file in the Prometheus text
+//! exposition format from a background thread, for collection by the
+//! node-exporter textfile collector. Each dump is written to a temporary file
+//! which is then renamed, so that a partially written file is never read.
+//! The Metrics must outlive the Metrics_Dumper.
+class Metrics_Dumper
+{
+public:
+    //! @brief Starts dumping p_metrics to p_file_path every p_interval.
+    Metrics_Dumper(const Metrics& p_metrics,
+                   const std::string& p_file_path,
+                   const std::chrono::milliseconds p_interval =
+                       std::chrono::seconds{15})
+        : m_metrics{p_metrics}, m_file_path{p_file_path},
+          m_interval{p_interval}, m_mutex{}, m_stop_requested{},
+          m_stop{false}, m_thread{}
+    {
+        m_thread = std::thread{[this] { run(); }};
+    }
+
+    Metrics_Dumper(const Metrics_Dumper&) = delete;
+    Metrics_Dumper& operator=(const Metrics_Dumper&) = delete;
+
+    //! @brief Stops the background thread, after writing a final dump.
+    ~Metrics_Dumper()
+    {
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            m_stop = true;
+        }
+        m_stop_requested.notify_one();
+        m_thread.join();
+    }
+
+    //! @brief Writes the metrics to the file now.
+    //! @returns Whether the file was written successfully.
+    bool Dump() const
+    {
+        const std::string temporary_path{m_file_path + ".tmp"};
+        bool written{false};
+        {
+            std::ofstream file{temporary_path};
+            m_metrics.Write_Prometheus(file);
+            file.close();
+            written = static_cast<bool>(file);
+        }
+        if (written &&
+            0 == std::rename(temporary_path.c_str(), m_file_path.c_str()))
+        {
+            return true;
+        }
+
+        // A partially written file is not left behind.
+        std::remove(temporary_path.c_str());
+        return false;
+    }
+
+private:
+    //! @brief Dumps the metrics every m_interval until stopped, and once more
+    //! when stopped.
+    void run()
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+        bool stop{false};
+        while (!stop)
+        {
+            stop = m_stop_requested.wait_for(
+                lock, m_interval, [this] { return m_stop; });
+
+            lock.unlock();
+            Dump();
+            lock.lock();
+        }
+    }
+
+    const Metrics& m_metrics;
+    const std::string m_file_path;
+    const std::chrono::milliseconds m_interval;
+    std::mutex m_mutex;
+    std::condition_variable m_stop_requested;
+    bool m_stop;
+    std::thread m_thread;
+};
+
+//! @class Header_Table
+//! @brief Stores the value of each header, indexed directly by its one byte
+//! tag. Small values are stored inline so that setting a header usually does
+//! not allocate. The headers are rendered into the bytes written to the file
+//! only when they have changed since they were last rendered.
+class Header_Table
+{
+public:
+    //! Values up to this many bytes are stored without allocating.
+    constexpr static std::size_t Inline_Capacity{16};
+
+    //! The tag marking the end of the headers and the start of the traces.
+    constexpr static std::uint8_t Trace_Block_Marker{0x5F};
+
+    //! The most bytes that the length of a value can be encoded into.
+    constexpr static std::size_t Max_Length_Size{1 + sizeof(std::size_t)};
+
+    Header_Table() : m_entries{}, m_rendered{}, m_dirty{true} {}
+
+    //! @brief Calculates the number of bytes needed to store p_value in
+    //! little endian order, omitting the high order zero bytes.
+    //! @returns The number of bytes needed. This is at least 1, so that 0 is
+    //! still stored.
+    constexpr static std::size_t Significant_Bytes(const std::uint64_t p_value)
+    {
+        std::size_t size{1};
+        while (size < sizeof(p_value) && 0 != (p_value >> (8 * size)))
+        {
+            ++size;
+        }
+        return size;
+    }
+
+    //! @brief Encodes the length of a value of p_size bytes. Lengths that
+    //! don't fit into 7 bits have the 8th bit set in the first byte, with the
+    //! rest of it being the number of bytes that follow, which store the
+    //! length in little endian order.
+    //! @param p_size The length of the value.
+    //! @param p_length The encoded length is written to the start of this.
+    //! @returns The number of bytes written to p_length.
+    constexpr static std::size_t
+    Encode_Length(const std::size_t p_size,
+                  std::array<std::byte, Max_Length_Size>& p_length)
+    {
+        if (0b01111111 >= p_size)
+        {
+            p_length[0] = std::byte{static_cast<std::uint8_t>(p_size)};
+            return 1;
+        }
+
+        const std::size_t size{Significant_Bytes(p_size)};
+        p_length[0] =
+            std::byte{static_cast<std::uint8_t>(0b10000000 | size)};
+        for (std::size_t i{0}; i < size; ++i)
+        {
+            p_length[1 + i] = std::byte{
+                static_cast<std::uint8_t>((p_size >> (8 * i)) & 0xFF)};
+        }
+        return 1 + size;
+    }
+
+    //! @brief Sets the header p_tag to the p_size bytes at p_value,
+    //! replacing any previous value.
+    void Set(const std::uint8_t p_tag,
+             const std::byte* const p_value,
+             const std::size_t p_size)
+    {
+        Entry& entry{m_entries[p_tag]};
+        if (Inline_Capacity < p_size)
+        {
+            entry.heap_value.assign(p_value, p_value + p_size);
+        }
+        else
+        {
+            entry.heap_value.clear();
+            std::copy(p_value, p_value + p_size, std::begin(entry.inline_value));
+        }
+        entry.size = p_size;
+        entry.set = true;
+        m_dirty = true;
+    }
+
+    //! @brief Removes the header p_tag, if it is set.
+    void Erase(const std::uint8_t p_tag)
+    {
+        Entry& entry{m_entries[p_tag]};
+        m_dirty |= entry.set;
+        entry.set = false;
+        entry.size = 0;
+        entry.heap_value.clear();
+    }
+
+    //! @returns Whether the header p_tag has been set.
+    bool Contains(const std::uint8_t p_tag) const
+    {
+        return m_entries[p_tag].set;
+    }
+
+    //! @returns The value of the header p_tag. This is only valid until the
+    //! header is next changed.
+    const std::byte* Value(const std::uint8_t p_tag) const
+    {
+        const Entry& entry{m_entries[p_tag]};
+        return Inline_Capacity < entry.size ? entry.heap_value.data()
+                                            : entry.inline_value.data();
+    }
+
+    //! @returns The length in bytes of the value of the header p_tag.
+    std::size_t Value_Size(const std::uint8_t p_tag) const
+    {
+        return m_entries[p_tag].size;
+    }
+
+    //! @brief Encodes all of the headers in order of their tags, in the
+    //! type-length-value format, followed by the Trace Block Marker.
+    //! @see https://en.wikipedia.org/wiki/Type-length-value
+    //! @returns The encoded headers, ready to be written. This is only
+    //! re-encoded if the headers have changed since the last call.
+    const std::vector<char>& Render()
+    {
+        if (!m_dirty)
+        {
+            return m_rendered;
+        }
+
+        m_rendered.clear();
+        for (std::size_t tag{0}; tag < m_entries.size(); ++tag)
+        {
+            if (!m_entries[tag].set)
+            {
+                continue;
+            }
+
+            m_rendered.push_back(static_cast<char>(tag));
+            encode_length(m_entries[tag].size, m_rendered);
+
+            const std::byte* const value{
+                Value(static_cast<std::uint8_t>(tag))};
+            for (std::size_t i{0}; i < m_entries[tag].size; ++i)
+            {
+                m_rendered.push_back(static_cast<char>(value[i]));
+            }
+        }
+
+        // The start of traces is marked by a Trace Block Marker tag. The
+        // length of the Trace Block Marker (always 0) is still required.
+        m_rendered.push_back(static_cast<char>(Trace_Block_Marker));
+        m_rendered.push_back(0x00);
+
+        m_dirty = false;
+        return m_rendered;
+    }
+
+    //! @brief Reads headers encoded by Render() from p_stream, up to and
+    //! including the Trace Block Marker, replacing any with the same tags.
+    //! @param p_stream The stream to read from, positioned at the start of
+    //! the headers.
+    //! @returns The number of bytes read.
+    //! @exception std::ios_base::failure If the stream ends before the Trace
+    //! Block Marker or a length is invalid.
+    std::size_t Read(std::istream& p_stream)
+    {
+        const auto start{p_stream.tellg()};
+        std::vector<std::byte> value;
+        while (true)
+        {
+            const std::uint8_t tag{read_byte(p_stream)};
+            const std::size_t size{read_length(p_stream)};
+            if (Trace_Block_Marker == tag)
+            {
+                break;
+            }
+
+            value.resize(size);
+            p_stream.read(reinterpret_cast<char*>(value.data()),
+                          static_cast<std::streamsize>(size));
+            if (!p_stream)
+            {
+                throw std::ios_base::failure("The file ends within its "
+                                             "headers");
+            }
+            Set(tag, value.data(), value.size());
+        }
+        return static_cast<std::size_t>(p_stream.tellg() - start);
+    }
+
+private:
+    //! @brief A single header. Only one of inline_value and heap_value is
+    //! used, depending on the size.
+    struct Entry
+    {
+        std::array<std::byte, Inline_Capacity> inline_value;
+        std::vector<std::byte> heap_value;
+        std::size_t size;
+        bool set;
+    };
+
+    //! @brief Appends the encoded length of a value of p_size bytes to
+    //! p_bytes.
+    static void encode_length(const std::size_t p_size,
+                              std::vector<char>& p_bytes)
+    {
+        std::array<std::byte, Max_Length_Size> length{};
+        const std::size_t length_size{Encode_Length(p_size, length)};
+        for (std::size_t i{0}; i < length_size; ++i)
+        {
+            p_bytes.push_back(static_cast<char>(length[i]));
+        }
+    }
+
+    //! @brief Reads a single byte from p_stream.
+    //! @exception std::ios_base::failure If the end of the stream is
+    //! reached.
+    static std::uint8_t read_byte(std::istream& p_stream)
+    {
+        const auto byte{p_stream.get()};
+        if (std::char_traits<char>::eof() == byte)
+        {
+            throw std::ios_base::failure("The file ends within its headers");
+        }
+        return static_cast<std::uint8_t>(byte);
+    }
+
+    //! @brief Reads the length of a header, as encoded by Encode_Length().
+    //! @exception std::ios_base::failure If the length is invalid.
+    static std::size_t read_length(std::istream& p_stream)
+    {
+        const std::uint8_t first{read_byte(p_stream)};
+        if (0 == (0b10000000 & first))
+        {
+            return first;
+        }
+
+        const std::size_t length_size{0b01111111u & first};
+        if (sizeof(std::size_t) < length_size)
+        {
+            throw std::ios_base::failure("A header length is too long");
+        }
+
+        std::size_t size{0};
+        for (std::size_t i{0}; i < length_size; ++i)
+        {
+            size |= static_cast<std::size_t>(read_byte(p_stream)) << (8 * i);
+        }
+        return size;
+    }
+
+    std::array<Entry, 256> m_entries;
+
+    //! The headers encoded by the last call to Render().
+    std::vector<char> m_rendered;
+
+    //! Whether the headers have changed since the last call to Render().
+    bool m_dirty;
+};
+
+//! @class Static_Headers
+//! @brief Encodes headers that are known at compile time, such as the title,
+//! axis labels and scope settings of a particular rig. The headers are
+//! encoded in exactly the same way as Serialiser::Add_Header() so that they
+//! can be added to a Serialiser with Serialiser::Add_Headers() without any
+//! encoding at run time.
+//! @code
+//! constexpr auto rig_headers{
+//!     Traces_Serialiser::Static_Headers<64>{}
+//!         .Add(Traces_Serialiser::Headers::Tag_Trace_Title, "Rig 1")
+//!         .Add(Traces_Serialiser::Headers::Tag_Axis_Scale_X, 1e-9f)};
+//! @endcode
+//! @tparam Capacity The maximum total size of the encoded headers in bytes.
+//! @tparam Max_Headers The maximum number of headers.
+//! @note A header added more than once is encoded more than once, but only
+//! the last value is used by Serialiser::Add_Headers().
+template <std::size_t Capacity, std::size_t Max_Headers> class Static_Headers
+{
+public:
+    //! @brief The position of a single header within the encoded bytes.
+    struct Entry
+    {
+        std::uint8_t tag;
+        //! The index of the first byte of the value.
+        std::size_t value_offset;
+        std::size_t value_size;
+    };
+
+    constexpr Static_Headers() : m_bytes{}, m_size{0}, m_entries{}, m_count{0}
+    {
+    }
+
+    //! @brief Adds a string header, such as a title or a label.
+    //! @param p_tag The tag of the header.
+    //! @param p_value The value of the header. The terminating null is not
+    //! included.
+    //! @returns A copy of this with the header added.
+    //! @exception std::length_error If Capacity or Max_Headers is exceeded.
+    //! When evaluated at compile time, this is a compile error instead.
+    template <std::size_t Length>
+    constexpr Static_Headers Add(const std::uint8_t p_tag,
+                                 const char (&p_value)[Length]) const
+    {
+        std::array<std::byte, Length> value{};
+        for (std::size_t i{0}; i + 1 < Length; ++i)
+        {
+            value[i] = std::byte{static_cast<std::uint8_t>(p_value[i])};
+        }
+        return add(p_tag, value, Length - 1);
+    }
+
+    //! @brief Adds a numeric header, such as a scale or an offset.
+    //! @param p_tag The tag of the header.
+    //! @param p_value The value of the header. As with
+    //! Serialiser::Add_Header(), the high order zero bytes of an integer are
+    //! omitted.
+    //! @returns A copy of this with the header added.
+    //! @exception std::length_error If Capacity or Max_Headers is exceeded.
+    //! When evaluated at compile time, this is a compile error instead.
+    template <typename T_Data,
+              typename = std::enable_if_t<std::is_arithmetic_v<T_Data>>>
+    constexpr Static_Headers Add(const std::uint8_t p_tag,
+                                 const T_Data p_value) const
+    {
+        std::array<std::byte, sizeof(T_Data)> value{};
+        std::size_t size{sizeof(T_Data)};
+
+        if constexpr (std::is_floating_point_v<T_Data>)
+        {
+            const auto bits{float_bits(p_value)};
+            for (std::size_t i{0}; i < sizeof(T_Data); ++i)
+            {
+                value[i] = std::byte{
+                    static_cast<std::uint8_t>((bits >> (8 * i)) & 0xFF)};
+            }
+        }
+        else
+        {
+            // bool has no unsigned equivalent, but is always 0 or 1.
+            using T_Unsigned = typename std::make_unsigned<std::conditional_t<
+                std::is_same_v<T_Data, bool>,
+                unsigned char,
+                T_Data>>::type;
+            const auto bits{static_cast<std::uint64_t>(
+                static_cast<T_Unsigned>(p_value))};
+            size = Header_Table::Significant_Bytes(bits);
+            for (std::size_t i{0}; i < size; ++i)
+            {
+                value[i] =
+                    std::byte{static_cast<std::uint8_t>((bits >> (8 * i)) & 0xFF)};
+            }
+        }
+
+        return add(p_tag, value, size);
+    }
+
+    //! @returns The headers encoded in the type-length-value format. Only the
+    //! first Get_Size() bytes are used.
+    constexpr const std::array<std::byte, Capacity>& Get_Bytes() const
+    {
+        return m_bytes;
+    }
+
+    //! @returns The number of bytes used by the encoded headers.
+    constexpr std::size_t Get_Size() const { return m_size; }
+
+    //! @returns The position of each header within Get_Bytes(). Only the
+    //! first Get_Count() entries are used.
+    constexpr const std::array<Entry, Max_Headers>& Get_Entries() const
+    {
+        return m_entries;
+    }
+
+    //! @returns The number of headers added.
+    constexpr std::size_t Get_Count() const { return m_count; }
+
+private:
+    //! @brief Appends the header p_tag with the first p_size bytes of
+    //! p_value.
+    template <std::size_t Length>
+    constexpr Static_Headers add(const std::uint8_t p_tag,
+                                 const std::array<std::byte, Length>& p_value,
+                                 const std::size_t p_size) const
+    {
+        std::array<std::byte, Header_Table::Max_Length_Size> length{};
+        const std::size_t length_size{
+            Header_Table::Encode_Length(p_size, length)};
+
+        if (Max_Headers == m_count ||
+            Capacity < m_size + 1 + length_size + p_size)
+        {
+            throw std::length_error("Static_Headers capacity exceeded");
+        }
+
+        Static_Headers result{*this};
+        result.m_bytes[result.m_size++] = std::byte{p_tag};
+        for (std::size_t i{0}; i < length_size; ++i)
+        {
+            result.m_bytes[result.m_size++] = length[i];
+        }
+        result.m_entries[result.m_count++] = {p_tag, result.m_size, p_size};
+        for (std::size_t i{0}; i < p_size; ++i)
+        {
+            result.m_bytes[result.m_size++] = p_value[i];
+        }
+        return result;
+    }
+
+    //! @brief Gets the bits of an IEEE 754 float or double at compile time,
+    //! as std::bit_cast is not available in C++17.
+    //! @note -0 is encoded as 0 and every NaN as the quiet NaN.
+    template <typename T_Float>
+    constexpr static auto float_bits(const T_Float p_value)
+    {
+        using T_Bits = std::conditional_t<sizeof(T_Float) == 4,
+                                          std::uint32_t,
+                                          std::uint64_t>;
+        constexpr int mantissa_bits{std::numeric_limits<T_Float>::digits - 1};
+        constexpr int exponent_bias{std::numeric_limits<T_Float>::max_exponent -
+                                    1};
+        constexpr T_Bits sign_bit{T_Bits{1} << (sizeof(T_Bits) * 8 - 1)};
+        constexpr T_Bits infinity{
+            ((T_Bits{1} << (sizeof(T_Bits) * 8 - 1 - mantissa_bits)) - 1)
+            << mantissa_bits};
+
+        if (p_value != p_value)
+        {
+            return static_cast<T_Bits>(infinity |
+                                       (T_Bits{1} << (mantissa_bits - 1)));
+        }
+
+        const T_Bits sign{p_value < 0 ? sign_bit : T_Bits{0}};
+        T_Float magnitude{p_value < 0 ? -p_value : p_value};
+        if (0 == magnitude)
+        {
+            return sign;
+        }
+        if (std::numeric_limits<T_Float>::max() < magnitude)
+        {
+            return static_cast<T_Bits>(sign | infinity);
+        }
+
+        // Scale the magnitude into [1, 2), tracking the exponent.
+        int exponent{0};
+        while (2 <= magnitude)
+        {
+            magnitude /= 2;
+            ++exponent;
+        }
+        while (1 > magnitude && 1 - exponent_bias < exponent)
+        {
+            magnitude *= 2;
+            --exponent;
+        }
+
+        // Subnormal numbers have no implicit leading 1.
+        const bool is_subnormal{1 > magnitude};
+        for (int i{0}; i < mantissa_bits; ++i)
+        {
+            magnitude *= 2;
+        }
+        const auto mantissa{static_cast<T_Bits>(magnitude)};
+        if (is_subnormal)
+        {
+            return static_cast<T_Bits>(sign | mantissa);
+        }
+
+        return static_cast<T_Bits>(
+            sign |
+            (static_cast<T_Bits>(exponent + exponent_bias) << mantissa_bits) |
+            (mantissa & ((T_Bits{1} << mantissa_bits) - 1)));
+    }
+
+    std::array<std::byte, Capacity> m_bytes;
+    std::size_t m_size;
+    std::array<Entry, Max_Headers> m_entries;
+    std::size_t m_count;
+};
+
+//! @class Sample_Encoder
+//! @brief Encodes samples into the bytes saved to a TRS file. This works on
+//! raw bytes with the sample length and type given at run time, so the same
+//! code encodes the samples of every Serialiser, Stream_Writer and
+//! Raw_Serialiser, however their samples are typed.
+class Sample_Encoder
+{
+public:
+    //! @brief Appends the encoded bytes of p_number_of_samples samples to
+    //! p_bytes.
+    //! @param p_samples The bytes of the samples, in native byte order.
+    //! @param p_number_of_samples The number of samples.
+    //! @param p_sample_length The length of a single sample in bytes.
+    //! @param p_bytes The encoded samples are appended to this.
+    //! @note Samples are saved in little endian order, as they are held in
+    //! memory. Only little endian platforms are supported.
+    static void Encode(const std::byte* const p_samples,
+                       const std::size_t p_number_of_samples,
+                       const std::size_t p_sample_length,
+                       std::vector<char>& p_bytes)
+    {
+        const auto bytes{reinterpret_cast<const char*>(p_samples)};
+        p_bytes.insert(std::end(p_bytes),
+                       bytes,
+                       bytes + p_number_of_samples * p_sample_length);
+    }
+};
+
+// This is only used by Serialiser so is hidden from SWIG.
+#ifndef SWIG
+//! @class Spill_File
+//! @brief An anonymous temporary file that a Serialiser moves its oldest
+//! traces to once it exceeds its memory budget. Data is only ever appended,
+//! so once written it never changes. This allows copies of a Serialiser to
+//! share the file.
+//! @see Serialiser::Set_Memory_Budget()
+class Spill_File
+{
+public:
+    //! @class Destination
+    //! @brief A file that spilled data can be copied into with Copy_To().
+    //! This is closed when destroyed.
+    class Destination
+    {
+    public:
+        //! @brief Opens the existing file at p_file_path for writing.
+        //! @exception std::ios_base::failure If the file cannot be opened.
+        explicit Destination(const std::string& p_file_path)
+            : m_file_descriptor{-1}
+        {
+#if __has_include(<unistd.h>)
+            m_file_descriptor = ::open(p_file_path.c_str(), O_WRONLY);
+#else
+            static_cast<void>(p_file_path);
+#endif
+            if (-1 == m_file_descriptor)
+            {
+                throw std::ios_base::failure("An error occurred when "
+                                             "preparing the file to be "
+                                             "written to");
+            }
+        }
+
+        Destination(const Destination&) = delete;
+        Destination& operator=(const Destination&) = delete;
+
+        ~Destination()
+        {
+#if __has_include(<unistd.h>)
+            ::close(m_file_descriptor);
+#endif
+        }
+
+    private:
+        friend class Spill_File;
+
+        int m_file_descriptor;
+    };
+
+    //! @brief Creates the file. This is removed automatically when it is
+    //! closed, or if the program exits.
+    //! @exception std::ios_base::failure If the file cannot be created.
+    //! @exception std::domain_error If this platform does not support
+    //! spilling to disk.
+    Spill_File() : m_file{nullptr}, m_size{0}, m_mutex{}
+    {
+#if __has_include(<unistd.h>)
+        m_file = std::tmpfile();
+        if (nullptr == m_file)
+        {
+            throw std::ios_base::failure("An error occurred when creating "
+                                         "the file to spill traces to");
+        }
+#else
+        throw std::domain_error("Spilling traces to disk is not supported "
+                                "on this platform");
+#endif
+    }
+
+    Spill_File(const Spill_File&) = delete;
+    Spill_File& operator=(const Spill_File&) = delete;
+
+    ~Spill_File() { std::fclose(m_file); }
+
+    //! @brief Appends p_size bytes starting at p_data to the file.
+    //! @returns The offset they were written to.
+    //! @exception std::ios_base::failure If they cannot be written.
+    std::uint64_t Append(const char* const p_data, const std::size_t p_size)
+    {
+        const std::lock_guard<std::mutex> lock{m_mutex};
+        const std::uint64_t offset{m_size};
+        write_at(file_descriptor(), p_data, p_size, offset);
+        m_size += p_size;
+        return offset;
+    }
+
+    //! @brief Reads p_size bytes starting at p_offset into p_data.
+    //! @exception std::ios_base::failure If they cannot be read.
+    void Read(const std::uint64_t p_offset,
+              char* const p_data,
+              const std::size_t p_size) const
+    {
+#if __has_include(<unistd.h>)
+        std::size_t done{0};
+        while (done < p_size)
+        {
+            const ::ssize_t result{
+                ::pread(file_descriptor(),
+                        p_data + done,
+                        p_size - done,
+                        static_cast<::off_t>(p_offset + done))};
+            if (0 >= result && !(0 > result && EINTR == errno))
+            {
+                throw std::ios_base::failure("An error occurred when reading "
+                                             "spilled traces");
+            }
+            done += 0 < result ? static_cast<std::size_t>(result) : 0;
+        }
+#else
+        static_cast<void>(p_offset);
+        static_cast<void>(p_data);
+        static_cast<void>(p_size);
+#endif
+    }
+
+    //! @brief Copies p_size bytes starting at p_offset into p_destination at
+    //! p_destination_offset. Where possible this uses copy_file_range(), so
+    //! that the data is copied by the kernel without passing through this
+    //! process, and may not be copied at all on file systems that share
+    //! extents.
+    //! @exception std::ios_base::failure If they cannot be copied.
+    void Copy_To(const Destination& p_destination,
+                 std::uint64_t p_destination_offset,
+                 std::uint64_t p_offset,
+                 std::uint64_t p_size) const
+    {
+#if defined(__linux__)
+        while (0 < p_size)
+        {
+            auto input_offset{static_cast<::off64_t>(p_offset)};
+            auto output_offset{static_cast<::off64_t>(p_destination_offset)};
+            const ::ssize_t result{
+                ::copy_file_range(file_descriptor(),
+                                  &input_offset,
+                                  p_destination.m_file_descriptor,
+                                  &output_offset,
+                                  static_cast<std::size_t>(p_size),
+                                  0)};
+            if (0 > result && EINTR == errno)
+            {
+                continue;
+            }
+            if (0 >= result)
+            {
+                // Fall back to copying through memory, for example if the
+                // files are on different file systems on older kernels.
+                break;
+            }
+            p_offset += static_cast<std::uint64_t>(result);
+            p_destination_offset += static_cast<std::uint64_t>(result);
+            p_size -= static_cast<std::uint64_t>(result);
+        }
+#endif
+
+        std::vector<char> buffer(
+            static_cast<std::size_t>(std::min<std::uint64_t>(p_size, 1 << 20)));
+        while (0 < p_size)
+        {
+            const auto size{static_cast<std::size_t>(
+                std::min<std::uint64_t>(p_size, buffer.size()))};
+            Read(p_offset, buffer.data(), size);
+            write_at(p_destination.m_file_descriptor,
+                     buffer.data(),
+                     size,
+                     p_destination_offset);
+            p_offset += size;
+            p_destination_offset += size;
+            p_size -= size;
+        }
+    }
+
+private:
+    //! @returns The file descriptor of m_file.
+    int file_descriptor() const
+    {
+#if __has_include(<unistd.h>)
+        return ::fileno(m_file);
+#else
+        return -1;
+#endif
+    }
+
+    //! @brief Writes p_size bytes starting at p_data to p_file_descriptor
+    //! at p_offset.
+    //! @exception std::ios_base::failure If they cannot be written.
+    static void write_at(const int p_file_descriptor,
+                         const char* const p_data,
+                         const std::size_t p_size,
+                         const std::uint64_t p_offset)
+    {
+#if __has_include(<unistd.h>)
+        std::size_t done{0};
+        while (done < p_size)
+        {
+            const ::ssize_t result{
+                ::pwrite(p_file_descriptor,
+                         p_data + done,
+                         p_size - done,
+                         static_cast<::off_t>(p_offset + done))};
+            if (0 > result && EINTR != errno)
+            {
+                throw std::ios_base::failure("An error occurred when writing "
+                                             "spilled traces");
+            }
+            done += 0 < result ? static_cast<std::size_t>(result) : 0;
+        }
+#else
+        static_cast<void>(p_file_descriptor);
+        static_cast<void>(p_data);
+        static_cast<void>(p_size);
+        static_cast<void>(p_offset);
+#endif
+    }
+
+    //! The temporary file. std::tmpfile() creates this without a name where
+    //! the platform allows it.
+    std::FILE* m_file;
+
+    //! The number of bytes appended so far.
+    std::uint64_t m_size;
+
+    //! Held while appending, as copies of a Serialiser share the file.
+    std::mutex m_mutex;
+};
+#endif  // SWIG
+
+// This is only used by Serialiser so is hidden from SWIG.
+#ifndef SWIG
+//! @class Thread_Pool
+//! @brief A fixed set of worker threads that a Serialiser splits the work on
+//! long traces between. The threads are started once and wait between jobs,
+//! so that short jobs are not dominated by the cost of starting threads.
+//! @see Serialiser::Set_Threads()
+class Thread_Pool
+{
+public:
+    //! @brief Starts p_workers worker threads.
+    explicit Thread_Pool(const std::size_t p_workers)
+        : m_mutex{}, m_run_mutex{}, m_work_ready{}, m_work_done{},
+          m_task{nullptr}, m_count{0}, m_next{0}, m_busy{0}, m_generation{0},
+          m_stop{false}, m_workers{}
+    {
+        m_workers.reserve(p_workers);
+        for (std::size_t i{0}; i < p_workers; ++i)
+        {
+            m_workers.emplace_back([this] { work(); });
+        }
+    }
+
+    Thread_Pool(const Thread_Pool&) = delete;
+    Thread_Pool& operator=(const Thread_Pool&) = delete;
+
+    //! @brief Stops and joins the worker threads.
+    ~Thread_Pool()
+    {
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            m_stop = true;
+        }
+        m_work_ready.notify_all();
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    //! @returns The number of worker threads.
+    std::size_t Get_Number_Of_Workers() const { return m_workers.size(); }
+
+    //! @brief Calls p_task(i) for every i in [0, p_count), sharing the calls
+    //! between the worker threads and the calling thread, and returns once
+    //! all of them have finished. Only one job runs at a time, so copies of a
+    //! Serialiser can share a pool.
+    //! @param p_count The number of calls.
+    //! @param p_task The function to be called. This must not throw.
+    void Run(const std::size_t p_count,
+             const std::function<void(std::size_t)>& p_task)
+    {
+        const std::lock_guard<std::mutex> run_lock{m_run_mutex};
+        {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            m_task = &p_task;
+            m_count = p_count;
+            m_next = 0;
+            m_busy = m_workers.size();
+            ++m_generation;
+        }
+        m_work_ready.notify_all();
+
+        run_tasks();
+
+        std::unique_lock<std::mutex> lock{m_mutex};
+        m_work_done.wait(lock, [this] { return 0 == m_busy; });
+        m_task = nullptr;
+    }
+
+private:
+    //! @brief The loop of each worker thread, which helps with every job
+    //! until the pool is destroyed.
+    void work()
+    {
+        std::uint64_t generation{0};
+        std::unique_lock<std::mutex> lock{m_mutex};
+        while (true)
+        {
+            m_work_ready.wait(lock, [&] {
+                return m_stop || generation != m_generation;
+            });
+            if (m_stop)
+            {
+                return;
+            }
+            generation = m_generation;
+
+            lock.unlock();
+            run_tasks();
+            lock.lock();
+
+            if (0 == --m_busy)
+            {
+                m_work_done.notify_one();
+            }
+        }
+    }
+
+    //! @brief Makes the calls of the current job that no other thread has
+    //! taken yet.
+    void run_tasks()
+    {
+        for (std::size_t i{m_next++}; i < m_count; i = m_next++)
+        {
+            (*m_task)(i);
+        }
+    }
+
+    //! Guards every member below it except m_next.
+    std::mutex m_mutex;
+
+    //! Held by Run() so that only one job runs at a time.
+    std::mutex m_run_mutex;
+
+    //! Notified when a job starts or the pool is stopped.
+    std::condition_variable m_work_ready;
+
+    //! Notified when every worker has finished the current job.
+    std::condition_variable m_work_done;
+
+    //! The function called by the current job.
+    const std::function<void(std::size_t)>* m_task;
+
+    //! The number of calls in the current job.
+    std::size_t m_count;
+
+    //! The next call of the current job to be made.
+    std::atomic<std::size_t> m_next;
+
+    //! The number of workers still working on the current job.
+    std::size_t m_busy;
+
+    //! Incremented for every job, so that each worker takes part once.
+    std::uint64_t m_generation;
+
+    //! Set when the pool is being destroyed.
+    bool m_stop;
+
+    //! The worker threads.
+    std::vector<std::thread> m_workers;
+};
+#endif  // SWIG
+
+// SWIG cannot wrap std::pmr::memory_resource so this is hidden from it.
+#ifndef SWIG
+//! @class Huge_Page_Arena
+//! @brief A memory resource for storing large trace sets, to be given to the
+//! Serialiser constructor. Memory is taken from the operating system in large
+//! blocks, each of which is asked to be backed by transparent huge pages, and
+//! is handed out in order without any bookkeeping. This avoids fragmentation
+//! and greatly reduces the number of page faults when storing gigabytes of
+//! traces. Memory is only returned when the arena is released or destroyed.
+//! @code
+//! Traces_Serialiser::Huge_Page_Arena arena{};
+//! Traces_Serialiser::Serialiser<std::uint8_t> serialiser{&arena};
+//! @endcode
+//! @note This is not thread safe. Serialiser only allocates while holding its
+//! own lock, so an arena must not be shared between Serialisers used on
+//! different threads.
+class Huge_Page_Arena : public std::pmr::memory_resource
+{
+public:
+    //! The size of a huge page on x86-64 and most ARM64 systems. Blocks are
+    //! aligned to, and a multiple of, this size.
+    constexpr static std::size_t Huge_Page_Size{std::size_t{1} << 21};
+
+    //! The size of the first block unless specified.
+    constexpr static std::size_t Default_Block_Size{64 * Huge_Page_Size};
+
+    //! @brief Constructs the arena. No memory is mapped until the first
+    //! allocation.
+    //! @param p_block_size The size of the first block. Each further block is
+    //! twice the size of the one before it.
+    //! @param p_prefault Whether each block is written to as soon as it is
+    //! mapped, so that the page faults happen then rather than while traces
+    //! are being added.
+    explicit Huge_Page_Arena(
+        const std::size_t p_block_size = Default_Block_Size,
+        const bool p_prefault          = false)
+        : std::pmr::memory_resource{}, m_blocks{},
+          m_next_block_size{round_up(std::max<std::size_t>(p_block_size, 1))},
+          m_current{nullptr}, m_remaining{0}, m_prefault{p_prefault}
+    {
+    }
+
+    Huge_Page_Arena(const Huge_Page_Arena&) = delete;
+    Huge_Page_Arena& operator=(const Huge_Page_Arena&) = delete;
+
+    ~Huge_Page_Arena() override { Release(); }
+
+    //! @brief Returns every block to the operating system. Nothing allocated
+    //! from the arena may be used afterwards.
+    void Release() noexcept
+    {
+        for (const auto& block : m_blocks)
+        {
+            unmap(block.first, block.second);
+        }
+        m_blocks.clear();
+        m_current   = nullptr;
+        m_remaining = 0;
+    }
+
+    //! @returns The total size of the blocks currently mapped, in bytes.
+    std::size_t Get_Mapped_Size() const
+    {
+        std::size_t size{0};
+        for (const auto& block : m_blocks)
+        {
+            size += block.second;
+        }
+        return size;
+    }
+
+private:
+    //! @returns p_size rounded up to a whole number of huge pages.
+    constexpr static std::size_t round_up(const std::size_t p_size)
+    {
+        return (p_size + Huge_Page_Size - 1) / Huge_Page_Size * Huge_Page_Size;
+    }
+
+    void* do_allocate(const std::size_t p_bytes,
+                      const std::size_t p_alignment) override
+    {
+        void* pointer{m_current};
+        std::size_t space{m_remaining};
+        if (nullptr == pointer ||
+            nullptr == std::align(p_alignment, p_bytes, pointer, space))
+        {
+            // Blocks start on a huge page boundary so the allocation is
+            // always aligned at the start of a new block.
+            add_block(p_bytes);
+            pointer = m_current;
+            space   = m_remaining;
+        }
+
+        m_current   = static_cast<char*>(pointer) + p_bytes;
+        m_remaining = space - p_bytes;
+        return pointer;
+    }
+
+    //! Memory is only reused once the whole arena is released.
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& p_other) const
+        noexcept override
+    {
+        return this == &p_other;
+    }
+
+    //! @brief Maps a new block of at least p_minimum_size bytes and makes it
+    //! the one that allocations are taken from. The rest of the previous
+    //! block is not used.
+    //! @exception std::bad_alloc If the block cannot be mapped.
+    void add_block(const std::size_t p_minimum_size)
+    {
+        const std::size_t size{
+            round_up(std::max(m_next_block_size, p_minimum_size))};
+
+        // Reserve first so that the block cannot be lost if this throws.
+        m_blocks.reserve(m_blocks.size() + 1);
+        void* const block{map(size)};
+        m_blocks.emplace_back(block, size);
+
+        m_next_block_size = 2 * size;
+        m_current         = block;
+        m_remaining       = size;
+    }
+
+    //! @brief Maps p_size bytes, aligned to a huge page, from the operating
+    //! system.
+    //! @exception std::bad_alloc If the memory cannot be mapped.
+    void* map(const std::size_t p_size) const
+    {
+#if __has_include(<sys/mman.h>)
+        // Transparent huge pages are only used for aligned ranges, so an
+        // extra huge page is mapped and the unaligned ends unmapped again.
+        const std::size_t mapped_size{p_size + Huge_Page_Size};
+        void* const mapping{mmap(nullptr,
+                                 mapped_size,
+                                 PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS,
+                                 -1,
+                                 0)};
+        if (MAP_FAILED == mapping)
+        {
+            throw std::bad_alloc{};
+        }
+
+        const auto start{reinterpret_cast<std::uintptr_t>(mapping)};
+        const std::uintptr_t aligned{round_up(start)};
+        if (aligned != start)
+        {
+            munmap(mapping, aligned - start);
+        }
+        if (start + mapped_size != aligned + p_size)
+        {
+            munmap(reinterpret_cast<void*>(aligned + p_size),
+                   start + mapped_size - (aligned + p_size));
+        }
+        void* const block{reinterpret_cast<void*>(aligned)};
+
+#ifdef MADV_HUGEPAGE
+        // If huge pages are unavailable this fails and normal pages are used.
+        madvise(block, p_size, MADV_HUGEPAGE);
+#endif
+#else
+        void* const block{
+            ::operator new(p_size, std::align_val_t{Huge_Page_Size})};
+#endif
+
+        if (m_prefault)
+        {
+            // Writing to one byte of each normal sized page faults in all of
+            // them, whether or not huge pages are used.
+            for (std::size_t i{0}; i < p_size; i += 4096)
+            {
+                static_cast<char*>(block)[i] = 0;
+            }
+        }
+        return block;
+    }
+
+    //! @brief Returns a block mapped by map() to the operating system.
+    static void unmap(void* const p_block, const std::size_t p_size) noexcept
+    {
+#if __has_include(<sys/mman.h>)
+        munmap(p_block, p_size);
+#else
+        ::operator delete(p_block, p_size, std::align_val_t{Huge_Page_Size});
+#endif
+    }
+
+    //! The address and size of every block mapped.
+    std::vector<std::pair<void*, std::size_t>> m_blocks;
+
+    //! The size of the next block to be mapped.
+    std::size_t m_next_block_size;
+
+    //! The start of the unused part of the current block.
+    void* m_current;
+
+    //! The size of the unused part of the current block.
+    std::size_t m_remaining;
+
+    //! Whether blocks are faulted in as soon as they are mapped.
+    bool m_prefault;
+};
+#endif  // SWIG
+
+//! @class Headers
+//! @brief The headers of a TRS file, along with the functions used to set
+//! them. This is shared by Serialiser, which writes new files, and
+//! Header_Editor, which edits the headers of existing files.
+class Headers
+{
+public:
+    // These variables are intended to improve readability and nothing more.
+    // Public so user can write code like this:
+    // Add_Header(Tag_Number_Of_Traces, 4);
+    // clang-format off
+    constexpr static std::uint8_t Tag_Number_Of_Traces                 {0x41};
+    constexpr static std::uint8_t Tag_Number_Of_Samples_Per_Trace      {0x42};
+    constexpr static std::uint8_t Tag_Sample_Coding                    {0x43};
+    constexpr static std::uint8_t Tag_Length_Of_Cryptographic_Data     {0x44};
+    constexpr static std::uint8_t Tag_Title_Space_Per_Trace            {0x45};
+    constexpr static std::uint8_t Tag_Trace_Title                      {0x46};
+    constexpr static std::uint8_t Tag_Description                      {0x47};
+    constexpr static std::uint8_t Tag_Axis_Offset_X                    {0x48};
+    constexpr static std::uint8_t Tag_Axis_Label_X                     {0x49};
+    constexpr static std::uint8_t Tag_Axis_Label_Y                     {0x4A};
+    constexpr static std::uint8_t Tag_Axis_Scale_X                     {0x4B};
+    constexpr static std::uint8_t Tag_Axis_Scale_Y                     {0x4C};
+    constexpr static std::uint8_t Tag_Trace_Offset                     {0x4D};
+    constexpr static std::uint8_t Tag_Logarithmic_Scale                {0x4E};
+    // 0x4F - 0x54 Reserved for future use.
+    constexpr static std::uint8_t Tag_Scope_Range                      {0x55};
+    constexpr static std::uint8_t Tag_Scope_Coupling                   {0x56};
+    constexpr static std::uint8_t Tag_Scope_Offset                     {0x57};
+    constexpr static std::uint8_t Tag_Scope_Input_Impedance            {0x58};
+    constexpr static std::uint8_t Tag_Scope_ID                         {0x59};
+    constexpr static std::uint8_t Tag_Filter_Type                      {0x5A};
+    constexpr static std::uint8_t Tag_Filter_Frequency                 {0x5B};
+    constexpr static std::uint8_t Tag_Filter_Range                     {0x5C};
+    // 0x5D - 0x5E Undocumented.
+    constexpr static std::uint8_t Tag_Trace_Block_Marker               {0x5F};
+    constexpr static std::uint8_t Tag_External_Clock_Used              {0x60};
+    constexpr static std::uint8_t Tag_External_Clock_Threshold         {0x61};
+    constexpr static std::uint8_t Tag_External_Clock_Multiplier        {0x62};
+    constexpr static std::uint8_t Tag_External_Clock_Phase_Shift       {0x63};
+    constexpr static std::uint8_t Tag_External_Clock_Resampler_Mask    {0x64};
+    constexpr static std::uint8_t Tag_External_Clock_Resampler_Enabled {0x65};
+    constexpr static std::uint8_t Tag_External_Clock_Frequency         {0x66};
+    constexpr static std::uint8_t Tag_External_Clock_Time_Base         {0x67};
+    // clang-format on
+
+    //! @brief This is this function that adds headers to the list of
+    //! headers to be saved. This is called by all other functions that add
+    //! headers as it is the only place headers are added.
+    //! @param p_tag The tag representing which header is currently being
+    //! set.
+    //! @param p_data The data that should be assigned to the header given
+    //! by p_tag.
+    //! @note This is public to allow user to add new headers that may not
+    //! have functions
+    template <typename T_Data>
+    void Add_Header(const std::uint8_t& p_tag, const T_Data& p_data)
+    {
+        const auto lock{lock_headers()};
+        validate_header(p_tag);
+
+        // Strings are stored as they are. The length is encoded when the
+        // headers are saved.
+        if constexpr (std::is_same<T_Data, std::string>::value)
+        {
+            m_headers.Set(p_tag,
+                          reinterpret_cast<const std::byte*>(p_data.data()),
+                          p_data.size());
+        }
+        else
+        {
+            // Cast to a byte array.
+            std::array<std::byte, sizeof(T_Data)> value{};
+            std::memcpy(value.data(), &p_data, sizeof(T_Data));
+            std::size_t size{sizeof(T_Data)};
+
+            // Integers have their high order zero bytes removed. Only
+            // little endian platforms are supported.
+            if constexpr (std::is_integral<T_Data>::value)
+            {
+                std::uint64_t bits{0};
+                std::memcpy(&bits, &p_data, sizeof(T_Data));
+                size = Header_Table::Significant_Bytes(bits);
+            }
+
+            m_headers.Set(p_tag, value.data(), size);
+        }
+    }
+
+    //! @brief Adds every header encoded at compile time by p_headers. These
+    //! replace any headers with the same tags. No encoding is done at run
+    //! time.
+    //! @param p_headers The headers to be added.
+    //! @exception std::range_error If an external clock header is added
+    //! before the external clock is enabled, as with Add_Header().
+    template <std::size_t Capacity, std::size_t Max_Headers>
+    void Add_Headers(const Static_Headers<Capacity, Max_Headers>& p_headers)
+    {
+        const auto lock{lock_headers()};
+        for (std::size_t i{0}; i < p_headers.Get_Count(); ++i)
+        {
+            const auto& entry{p_headers.Get_Entries()[i]};
+            validate_header(entry.tag);
+            m_headers.Set(entry.tag,
+                          p_headers.Get_Bytes().data() + entry.value_offset,
+                          entry.value_size);
+        }
+    }
+
+    // Beyond this point there are only functions designed to simplify the
+    // usage of the Add_Header function.
+    // The default parameters in the following functions are copied from the
+    // Riscure inspector documentation.
+
+    // TODO: Rename
+    // https://wandbox.org/permlink/TiG2k4xzQUojzfdO
+    void Set_Cryptographic_Data_Length(const std::uint16_t p_length = 0)
+    {
+        Add_Header(Tag_Length_Of_Cryptographic_Data, p_length);
+    }
+
+    // TODO: Implement this.
+    void Set_Title_Space_Per_Trace(const std::uint8_t p_length = 0)
+    {
+        Add_Header(Tag_Title_Space_Per_Trace, p_length);
+    }
+
+    void Set_Trace_Title(const std::string& p_title = "trace")
+    {
+        Add_Header(Tag_Trace_Title, p_title);
+    }
+
+    void Set_Trace_Description(const std::string& p_description)
+    {
+        Add_Header(Tag_Description, p_description);
+    }
+
+    void Set_Axis_Offset_X(const std::uint32_t p_offset = 0)
+    {
+        Add_Header(Tag_Axis_Offset_X, p_offset);
+    }
+
+    void Set_Axis_Label_X(const std::string& p_label)
+    {
+        Add_Header(Tag_Axis_Label_X, p_label);
+    }
+
+    void Set_Axis_Label_Y(const std::string& p_label)
+    {
+        Add_Header(Tag_Axis_Label_Y, p_label);
+    }
+
+    void Set_Axis_Scale_X(const float p_scale = 1)
+    {
+        Add_Header(Tag_Axis_Scale_X, p_scale);
+    }
+
+    void Set_Axis_Scale_Y(const float p_scale = 1)
+    {
+        Add_Header(Tag_Axis_Scale_Y, p_scale);
+    }
+
+    void Set_Trace_Offset(const std::uint32_t p_offset = 0)
+    {
+        Add_Header(Tag_Trace_Offset, p_offset);
+    }
+
+    // TODO: Calling this with a float argument works. Validate to ensure
+    // that this does not work.
+    void Set_Logarithmic_Scale(const std::uint8_t p_scale = 0)
+    {
+        Add_Header(Tag_Logarithmic_Scale, p_scale);
+    }
+
+    // 0x4F - 0x54 Reserved for future use.
+
+    void Set_Scope_Range(const float p_range = 0)
+    {
+        Add_Header(Tag_Scope_Range, p_range);
+    }
+
+    void Set_Scope_Coupling(const std::uint32_t p_coupling = 0)
+    {
+        Add_Header(Tag_Scope_Coupling, p_coupling);
+    }
+
+    void Set_Scope_Offset(const float p_offset = 0)
+    {
+        Add_Header(Tag_Scope_Offset, p_offset);
+    }
+
+    void Set_Scope_Input_Impedance(const float p_impedance = 0)
+    {
+        Add_Header(Tag_Scope_Input_Impedance, p_impedance);
+    }
+
+    // TODO: Should this be a string?
+    void Set_Scope_ID(const std::string& p_id)
+    {
+        Add_Header(Tag_Scope_ID, p_id);
+    }
+
+    void Set_Filter_Type(const std::uint32_t p_type = 0)
+    {
+        Add_Header(Tag_Filter_Type, p_type);
+    }
+
+    void Set_Filter_Frequency(const float p_frequency = 0)
+    {
+        Add_Header(Tag_Filter_Frequency, p_frequency);
+    }
+
+    void Set_Filter_Range(const float p_range = 0)
+    {
+        Add_Header(Tag_Filter_Range, p_range);
+    }
+
+    // 0x5D - 0x5E Undocumented
+    // 0x5F Marks header end
+
+    void Set_External_Clock_Used(const bool p_used = true)
+    {
+        Add_Header(Tag_External_Clock_Used, p_used);
+    }
+
+    void Set_External_Clock_Threshold(const float p_threshold = 0)
+    {
+        Add_Header(Tag_External_Clock_Threshold, p_threshold);
+    }
+
+    void Set_External_Clock_Multiplier(const std::uint32_t p_multiplier = 0)
+    {
+        Add_Header(Tag_External_Clock_Multiplier, p_multiplier);
+    }
+
+    void Set_External_Clock_Phase_Shift(const std::uint32_t p_phase_shift = 0)
+    {
+        Add_Header(Tag_External_Clock_Phase_Shift, p_phase_shift);
+    }
+
+    void
+    Set_External_Clock_Resampler_Mask(const std::uint32_t p_resampler_mask = 0)
+    {
+        Add_Header(Tag_External_Clock_Resampler_Mask, p_resampler_mask);
+    }
+
+    void
+    Set_External_Clock_Resampler_Enabled(const bool p_resampler_enabled = true)
+    {
+        Add_Header(Tag_External_Clock_Resampler_Enabled, p_resampler_enabled);
+    }
+
+    void Set_External_Clock_Frequency(const float p_frequency = 0)
+    {
+        Add_Header(Tag_External_Clock_Frequency, p_frequency);
+    }
+
+    // TODO: All int headers are unsigned, Change them to signed?
+    void Set_External_Clock_Time_Base(const std::uint32_t p_time_base = 0)
+    {
+        Add_Header(Tag_External_Clock_Time_Base, p_time_base);
+    }
+
+protected:
+    Headers() : m_headers{} {}
+    Headers(const Headers&)            = default;
+    Headers(Headers&&)                 = default;
+    Headers& operator=(const Headers&) = default;
+    Headers& operator=(Headers&&)      = default;
+    virtual ~Headers()                 = default;
+
+    //! @brief A recursive mutex that does not prevent its owner from being
+    //! copied. A copy has its own, unlocked, mutex.
+    struct Copyable_Mutex : std::recursive_mutex
+    {
+        Copyable_Mutex() = default;
+        Copyable_Mutex(const Copyable_Mutex&) : std::recursive_mutex{} {}
+        Copyable_Mutex& operator=(const Copyable_Mutex&) { return *this; }
+    };
+
+    //! @brief Locks the headers while one is set, so that a writer whose
+    //! Save() can run on another thread does not read them as they change.
+    //! Writers that can do so override this to lock the mutex held by their
+    //! Save().
+    //! @returns The lock, held until the header has been set. By default
+    //! nothing is locked.
+    virtual std::unique_lock<std::recursive_mutex> lock_headers()
+    {
+        return {};
+    }
+
+    //! This is the main container that stores the trace header information,
+    //! ready to be saved into the output file. The format uses a
+    //! type-length-value encoding to store this information.
+    //! @see https://en.wikipedia.org/wiki/Type-length-value
+    //! The headers are indexed by their tag, which is a single byte, and are
+    //! encoded only when they are saved.
+    Header_Table m_headers;
+
+    //! @brief Ensures that setting the header given by the parameter p_tag
+    //! is allowed in the current context, based on which headers have
+    //! already been set.
+    //! @param p_tag The tag indicating which header is currently being set.
+    //! @exception std::range_error This does not return anything as an
+    //! exception will be thrown if the validation fails.
+    void validate_header(const std::uint8_t p_tag)
+    {
+        // Only allow external clock related values to be set if the
+        // external clock has been explicitly enabled.
+
+        // If this is not an external clock related header then no
+        // validation is required.
+        if (!is_external_clock_header(p_tag))
+        {
+            return;
+        }
+
+        // Tag_External_Clock_Used must be set before setting any other
+        // Tag_External_Clock_* headers
+        if (!header_enabled(Tag_External_Clock_Used))
+        {
+            throw std::range_error("Enable external clock explicitly with "
+                                   "Set_External_Clock_Used()");
+        }
+
+        // Only allow external clock resampler mask to be set if the
+        // external clock has been explicitly enabled.
+
+        // If this is not an external clock resampler mask related header
+        // then no further validation is required.
+        if (Tag_External_Clock_Resampler_Mask != p_tag)
+        {
+            return;
+        }
+
+        // Tag_External_Clock_Resampler_Enabled must be set before setting
+        // Tag_External_Clock_Resampler_Mask
+        if (!header_enabled(Tag_External_Clock_Resampler_Enabled))
+        {
+            throw std::range_error(
+                "Enable external clock resampler explicitly with "
+                "Set_External_Clock_Resampler_Enabled()");
+        }
+    }
+
+    //! @brief Determines whether or not the given boolean header has been
+    //! enabled or not.
+    //! @returns If the header has been set to a value other than 0, true is
+    //! return. If it is unset or set to 0 then false is returned.
+    //! @param p_tag The tag indicating which header to check.
+    //! @warning This was designed for headers with boolean values but it
+    //! can be used on any header which will usually give undesired results.
+    bool header_enabled(const std::uint8_t p_tag) const
+    {
+        // If the header has not been set then it is not enabled
+        if (!m_headers.Contains(p_tag) || 0 == m_headers.Value_Size(p_tag))
+        {
+            return false;
+        }
+
+        // If the header has been set to 0 then it is not enabled
+        return 0 != std::to_integer<bool>(*m_headers.Value(p_tag));
+    }
+
+    //! @brief Determines whether or not the tag given by p_tag is related to
+    //! the external clock. All headers related to the external clock lie
+    //! between 0x61 (Tag_External_Clock_Threshold) and 0x67
+    //! (Tag_External_Clock_Time_Base) inclusive. Expect for
+    //! Tag_External_Clock_Used (0x60) which is considered an exception as
+    //! it enables this range of tags to be used.
+    //! @warning This will return false for 0x60 (Tag_External_Clock_Used)
+    //! :param p_tag The tag to be checked.
+    //! @returns True if p_tag is an external clock header and false if not.
+    constexpr static bool is_external_clock_header(const std::uint8_t p_tag)
+    {
+        return Tag_External_Clock_Threshold <= p_tag &&
+               Tag_External_Clock_Time_Base >= p_tag;
+    }
+};
+
+//! @class Serialiser
+//! @brief This is the main class that is used in order to serialise traces.
+//! Currently it supports saving in the format used by Riscure's inspector
+//! tool.
+//! @see https://www.riscure.com/security-tools/inspector-sca/
+template <typename T_Sample> class Serialiser : public Headers
+{
+    // Ensure that the template type T_Sample is arithmetic.
+    static_assert(std::is_arithmetic<T_Sample>::value,
+                  "Traces must be stored as a number");
+
+private:
+    //! @todo Document
+    std::uint64_t
+        m_number_of_traces;  //!@todo Does this need to be stored? - no -
+                             //! m_traces.size() - Maybe use a macro instead ?
+    std::uint64_t
+        m_samples_per_trace;  //!@todo Does this need to be stored? - no -
+                              //! m_traces.size() - Maybe use a macro
+                              //! instead?
+    const std::uint8_t m_sample_length;
+
+    std::size_t m_longest_trace_length;
+
+    //! A single trace as it is stored. The samples are allocated from the
+    //! memory resource given to the constructor.
+    using Stored_Trace = std::pmr::vector<T_Sample>;
+
+    std::pmr::vector<std::pmr::string> m_extra_data;
+
+    //! This contains the actual side channel analysis traces, stored as
+    //! bytes ready to be saved into the output file.
+    //! @todo Don't store a traces object. This is simply the value to the
+    //! Tag_Trace_Block_Marker.
+    std::pmr::vector<Stored_Trace> m_traces;
+
+    //! The type repeated acquisitions are summed into when averaging.
+    //! Integral samples are summed exactly using a wide integer while floating
+    //! point samples are summed as doubles.
+    using T_Accumulator =
+        typename std::conditional<std::is_integral<T_Sample>::value,
+                                  std::int64_t,
+                                  double>::type;
+
+    //! The maximum number of repeated acquisitions that are averaged into a
+    //! single trace. 0 disables averaging.
+    std::size_t m_repeat_count;
+
+    //! The running sum of the repeated acquisitions that have not yet been
+    //! averaged and stored.
+    std::vector<T_Accumulator> m_repeat_sum;
+
+    //! The number of acquisitions currently summed into m_repeat_sum.
+    std::size_t m_repeats_accumulated;
+
+    //! The extra data shared by all acquisitions in m_repeat_sum.
+    std::string m_repeat_extra_data;
+
+    //! The coefficients of the FIR filter applied to each trace as it is
+    //! added. If this is empty then no FIR filter is applied.
+    std::vector<double> m_fir_coefficients;
+
+    //! @brief The coefficients of a single second order IIR section
+    //! (biquad). These are normalised so that a0 is 1.
+    struct Biquad
+    {
+        double b0;
+        double b1;
+        double b2;
+        double a1;
+        double a2;
+    };
+
+    //! The cascade of biquad sections applied to each trace as it is added.
+    //! If this is empty then no IIR filter is applied.
+    std::vector<Biquad> m_biquads;
+
+public:
+    //! @brief The ways in which the samples within one resampling window can
+    //! be combined into a single sample.
+    enum class Resample_Mode
+    {
+        Sum,
+        Mean,
+        Max
+    };
+
+private:
+    //! The number of input samples combined into each output sample when
+    //! resampling to the external clock. 0 disables resampling.
+    double m_resample_step;
+
+    //! The number of input samples skipped before the first resampling
+    //! window.
+    std::size_t m_resample_phase_shift;
+
+    //! How the samples within each resampling window are combined.
+    Resample_Mode m_resample_mode;
+
+    //! The pattern each trace is aligned against, with its mean subtracted.
+    //! If this is empty then traces are not aligned.
+    std::vector<double> m_alignment_reference;
+
+    //! The Euclidean norm of m_alignment_reference.
+    double m_alignment_reference_norm;
+
+    //! The position in an aligned trace at which the reference pattern
+    //! starts.
+    std::size_t m_alignment_offset;
+
+    //! The largest shift, in either direction, searched when aligning.
+    std::size_t m_alignment_max_shift;
+
+    //! Traces whose best correlation with the reference pattern is below
+    //! this are rejected.
+    double m_alignment_threshold;
+
+    //! Whether the shift applied to each trace is appended to its extra data.
+    bool m_record_alignment_shift;
+
+    //! The number of traces that have been rejected rather than stored.
+    std::size_t m_rejected_trace_count;
+
+public:
+    //! @brief The crossings of the threshold that are treated as events when
+    //! recording sparsely.
+    enum class Trigger_Edge
+    {
+        Rising,
+        Falling,
+        Either
+    };
+
+private:
+    //! The number of samples kept around each event when recording sparsely.
+    //! 0 disables sparse recording.
+    std::size_t m_sparse_window_length;
+
+    //! The number of samples kept before each event.
+    std::size_t m_sparse_pre_trigger;
+
+    //! The level an event must cross.
+    T_Sample m_sparse_threshold;
+
+    //! The crossings of m_sparse_threshold that are events.
+    Trigger_Edge m_sparse_edge;
+
+    //! The position of the first sample of the next trace within the
+    //! continuous recording.
+    std::uint64_t m_sparse_position;
+
+    //! The last sample of the previous trace, so that events on the boundary
+    //! between two traces are still detected.
+    T_Sample m_sparse_previous_sample;
+
+    //! The last m_sparse_pre_trigger samples of the recording, as the window
+    //! of an event near the start of the next trace begins within them.
+    std::vector<T_Sample> m_sparse_history;
+
+    //! The window of an event near the end of a previous trace, waiting for
+    //! the rest of its samples from the next trace.
+    Stored_Trace m_sparse_pending;
+
+    //! The extra data associated with m_sparse_pending.
+    std::string m_sparse_pending_extra_data;
+
+    //! The position within the continuous recording of the end of the last
+    //! window. Events before it are ignored.
+    std::uint64_t m_sparse_window_end;
+
+    //! The length, in bytes, of the signed integers that floating point
+    //! samples are quantised to when saving. 0 disables quantisation.
+    std::uint8_t m_quantised_sample_length;
+
+    //! Whether the quantisation scale and offset are calculated from the
+    //! range of the traces when saving.
+    bool m_quantisation_automatic;
+
+    //! The value of one step of a quantised sample.
+    double m_quantisation_scale;
+
+    //! The value of a quantised sample of 0.
+    double m_quantisation_offset;
+
+    //! The largest difference between a sample and its quantised value in
+    //! the last file saved.
+    double m_quantisation_error;
+
+    //! The samples of the trace being quantised, reused for every trace.
+    //! Which is used depends on m_quantised_sample_length.
+    std::vector<std::int8_t> m_quantised_8_bit;
+    std::vector<std::int16_t> m_quantised_16_bit;
+
+    //! Called every m_save_progress_interval traces while saving.
+    Save_Progress_Callback m_save_progress_callback;
+
+    //! The number of traces written between calls to
+    //! m_save_progress_callback.
+    std::size_t m_save_progress_interval;
+
+    //! Whether the file is flushed to disk at the end of Save().
+    bool m_sync_on_save;
+
+    //! The number of bytes the samples and extra data held in memory may use
+    //! before the oldest traces are spilled to disk. 0 means no limit.
+    std::size_t m_memory_budget;
+
+    //! The number of bytes the samples and extra data held in memory use.
+    std::size_t m_memory_used;
+
+    //! Where traces are spilled to. This is shared between copies of the
+    //! Serialiser, which is safe as it is only ever appended to.
+    std::shared_ptr<Spill_File> m_spill_file;
+
+    //! The offset into m_spill_file and the number of samples of each
+    //! spilled trace. The oldest traces are always spilled first, so these
+    //! are the first m_spilled.size() traces. Their entries in m_traces are
+    //! empty.
+    std::vector<std::pair<std::uint64_t, std::size_t>> m_spilled;
+
+    //! The smallest and largest spilled samples, used by automatic
+    //! quantisation.
+    T_Sample m_spilled_minimum;
+    T_Sample m_spilled_maximum;
+
+    //! The index and original number of samples of each trace that has been
+    //! padded by pad_all_traces(), in order of index. The padding is not
+    //! included in the range used by automatic quantisation.
+    std::vector<std::pair<std::size_t, std::size_t>> m_padded_lengths;
+
+    //! Counters that can be read from another thread with Get_Metrics().
+    Metrics m_metrics;
+
+    //! Held by Save(), Add_Trace(), Add_Traces() and the functions that
+    //! change the settings or headers, so that traces can be added and
+    //! settings changed on one thread while another thread saves. Save() and
+    //! some settings set headers themselves, so this is recursive. It is
+    //! mutable so that getters of what these change can also hold it.
+    mutable Copyable_Mutex m_mutex;
+
+    //! The number of threads long traces are split between, including the
+    //! thread adding them. 0 uses one per hardware thread.
+    std::size_t m_threads;
+
+    //! The worker threads used by parallel_for(), started when first needed.
+    //! Copies of the Serialiser share these.
+    mutable std::shared_ptr<Thread_Pool> m_thread_pool;
+
+    //! @brief Locks m_mutex while a header is set, so that headers wait for
+    //! a save on another thread to finish.
+    //! @returns The lock.
+    std::unique_lock<std::recursive_mutex> lock_headers() override
+    {
+        return std::unique_lock<std::recursive_mutex>{m_mutex};
+    }
+
+    //! @brief Flushes the file at p_file_path to disk, so that it survives a
+    //! power failure once Save() returns. This does nothing on platforms
+    //! without fsync().
+    //! @exception std::ios_base::failure If the file cannot be flushed.
+    static void sync_file(const std::string& p_file_path)
+    {
+#if __has_include(<unistd.h>)
+        const int file_descriptor{::open(p_file_path.c_str(), O_WRONLY)};
+        const bool synced{-1 != file_descriptor &&
+                          0 == ::fsync(file_descriptor)};
+        if (-1 != file_descriptor)
+        {
+            ::close(file_descriptor);
+        }
+        if (!synced)
+        {
+            throw std::ios_base::failure("An error occurred when flushing "
+                                         "the file to disk");
+        }
+#else
+        static_cast<void>(p_file_path);
+#endif
+    }
+
+    //! @brief Converts the data given by the parameter p_data into a series
+    //! of bytes.
+    //! @param p_data The data to be converted to bytes. This uses templates
+    //! so that this function can convert any basic data type and
+    //! std::string to bytes.
+    //! @returns A series of bytes represented using std::vector<std::byte>.
+    //! @todo See if this can all be replaced by std::bitset?
+    template <typename T_Data>
+    static const std::vector<std::byte> convert_to_bytes(const T_Data& p_data)
+    {
+        // A temporary store for the converted bytes.
+        std::vector<std::byte> bytes_vector;
+
+        // Strings need to be handled separately.
+        if constexpr (std::is_same<T_Data, std::string>::value)
+        {
+            // Get a char array from the string and cast it to a byte array
+            // TODO: std::string is a container. Treat it as such using
+            // convert_traces_to_bytes() instead of separate handling here.
+            auto bytes_array =
+                reinterpret_cast<const std::byte*>(p_data.c_str());
+
+            // Convert byte array to byte vector
+            bytes_vector = {bytes_array, bytes_array + p_data.size()};
+        }
+        else
+        {
+            // Cast to a byte array
+            auto bytes_array = reinterpret_cast<const std::byte*>(&p_data);
+
+            // Convert byte array to byte vector
+            bytes_vector = {bytes_array, bytes_array + sizeof(T_Data)};
+        }
+        return bytes_vector;
+    }
+
+    //! @brief Lengthens or shortens the bytes of a single sample to
+    //! p_length. Samples are little endian so bytes are added to or removed
+    //! from the back, with negative integers sign extended.
+    //! @param p_sample The sample.
+    //! @param p_length The length the sample will be resized to.
+    //! @returns The bytes of p_sample, p_length bytes long.
+    static std::vector<std::byte> resize_sample(const T_Sample p_sample,
+                                                const std::uint8_t p_length)
+    {
+        std::vector<std::byte> bytes{convert_to_bytes(p_sample)};
+        std::byte extension{0};
+        if constexpr (std::is_integral<T_Sample>::value &&
+                      std::is_signed<T_Sample>::value)
+        {
+            if (p_sample < 0)
+            {
+                extension = std::byte{0xff};
+            }
+        }
+        bytes.resize(p_length, extension);
+        return bytes;
+    }
+
+    //! @brief Retrieves the length of the longest element in p_data.
+    //! @param p_data The contain from which the length of the longest element
+    //! will be found.
+    //! @tparam T The type of the data to the padded. The type stored in p_data.
+    //! This will work with any type where the operator < is defined.
+    //! @returns The size of the largest element in p_data
+    template <typename T> static std::size_t get_longest(const T& p_data)
+    {
+        return (*std::max_element(
+                    std::begin(p_data),
+                    std::end(p_data),
+                    [](const auto& p_first, const auto& p_second) {
+                        return p_first.size() < p_second.size();
+                    }))
+            .size();
+    }
+
+    //! @brief Pads all of the data in m_traces with 0s to ensure each trace
+    //! is of the same length.
+    //! This is necessary as TRS files require all traces to be of the same
+    //! length.
+    void pad_all_traces()
+    {
+        // If the longest trace length is not yet recorded, so calculate it.
+        if (0 == m_longest_trace_length)
+        {
+            m_longest_trace_length = get_longest(m_traces);
+            for (const auto& spilled : m_spilled)
+            {
+                m_longest_trace_length =
+                    std::max(m_longest_trace_length, spilled.second);
+            }
+        }
+
+        // Spilled traces are padded as they are written instead.
+        for (std::size_t i{m_spilled.size()}; i < m_traces.size(); ++i)
+        {
+            Stored_Trace& trace{m_traces[i]};
+            if (trace.size() < m_longest_trace_length)
+            {
+                // Traces padded by an earlier save keep their original
+                // length.
+                const auto padded{std::lower_bound(
+                    std::begin(m_padded_lengths),
+                    std::end(m_padded_lengths),
+                    std::make_pair(i, std::size_t{0}))};
+                if (std::end(m_padded_lengths) == padded || i != padded->first)
+                {
+                    m_padded_lengths.emplace(padded, i, trace.size());
+                }
+
+                m_memory_used += (m_longest_trace_length - trace.size()) *
+                                 sizeof(T_Sample);
+                trace.resize(m_longest_trace_length, T_Sample{0});
+            }
+        }
+
+        // This may have changed during padding.
+        m_samples_per_trace =
+            m_spilled.empty()
+                ? m_traces.front().size()
+                : std::max(m_spilled.front().second, m_longest_trace_length);
+    }
+
+    //! @param p_index The index of a trace.
+    //! @returns The number of samples in the trace given by p_index before it
+    //! was padded by pad_all_traces().
+    std::size_t unpadded_length(const std::size_t p_index) const
+    {
+        const auto padded{std::lower_bound(std::begin(m_padded_lengths),
+                                           std::end(m_padded_lengths),
+                                           std::make_pair(p_index,
+                                                          std::size_t{0}))};
+        if (std::end(m_padded_lengths) != padded && p_index == padded->first)
+        {
+            return padded->second;
+        }
+        return p_index < m_spilled.size() ? m_spilled[p_index].second
+                                          : m_traces[p_index].size();
+    }
+
+    //! @brief Converts a vector of data given by the parameter p_data into a
+    //! single series of bytes.
+    //! The input can be a nested vector, in which case it will be recursively
+    //! unpacked it and the values inside will be converted to bytes.
+    //! @param p_data A vector or nested vector contained the data to be
+    //! converted to bytes. This uses templates so that this function can
+    //! convert any basic data type and std::string to bytes.
+    //! @param p_sample_length The length each sample should be. This is used to
+    //! pad each individual sample to the correct length.
+    //! @returns A series of bytes represented using std::vector<std::byte>.
+    template <typename T_Traces, typename T_Allocator>
+    static const std::vector<std::byte>
+    convert_traces_to_bytes(const std::vector<T_Traces, T_Allocator>& p_data,
+                            const std::uint8_t p_sample_length)
+    {
+        std::vector<std::byte> bytes_vector;
+
+        // For each value in the vector
+        for (const auto& data : p_data)
+        {
+            const std::vector<std::byte> data_vector{[&]() {
+                // If this is nested container, recursively unpack it until
+                // we get at the values inside.
+                if constexpr (!std::is_same<T_Traces, T_Sample>::value)
+                {
+                    // Check that each sub container is of the same length
+
+                    return convert_traces_to_bytes(data, p_sample_length);
+                }
+                // if this is not a nested container simply convert
+                // each of the values.
+                return resize_sample(data, p_sample_length);
+            }()};
+
+            // Append the converted values onto the end of bytes_vector
+            // ready to be returned.
+            bytes_vector.insert(std::end(bytes_vector),
+                                std::begin(data_vector),
+                                std::end(data_vector));
+        }
+        return bytes_vector;
+    }
+
+    //! @brief A helper function to add all of the headers required to be in
+    //! a trace file. The headers currently required are the number of
+    //! traces, the number of samples per trace and the sample coding. The
+    //! sample coding is not required as an input here as it can be
+    //! calculated based off of the length of one sample.
+    //! @note Although Tag_Trace_Block_Marker (0x5F) is a required header,
+    //! it is not included here as it needs to be the last header printed
+    //! before the traces.
+    //! @param p_number_of_traces The total number of traces.
+    //! @param p_samples_per_trace The number of samples within each trace.
+    //! @param p_sample_length The length of a single sample in bytes.
+    void add_required_headers(const std::uint64_t p_number_of_traces,
+                              const std::uint64_t p_samples_per_trace,
+                              const std::uint8_t p_sample_length)
+    {
+        validate_required_headers(
+            p_number_of_traces, p_samples_per_trace, p_sample_length);
+
+        // Both are known to fit into 32 bits once validated.
+        Add_Header(Tag_Number_Of_Traces,
+                   static_cast<std::uint32_t>(p_number_of_traces));
+        Add_Header(Tag_Number_Of_Samples_Per_Trace,
+                   static_cast<std::uint32_t>(p_samples_per_trace));
+
+        // Calculate the sample coding.
+        // Bits 8-6 are reserved and must be '000'.
+        // Bit 5 corresponds to integer (0) or floating point (1).
+        // Bits 4-1 are the sample length in bytes. This must be 1,2 or 4.
+        const std::uint8_t sample_coding{[&]() -> std::uint8_t {
+            // If the traces are floating point values, set bit 5 to
+            // indicate
+            // this as per the Riscure inspector specification: Table K.2.
+            // Sample coding.
+            // Quantised traces are saved as integers.
+            if (std::is_floating_point<T_Sample>::value &&
+                0 == m_quantised_sample_length)
+            {
+                return p_sample_length | 0b10000;
+            }
+            // If the traces are not floating point then the sample coding is
+            // simply the length of one sample.
+            return p_sample_length;
+        }()};
+
+        Add_Header(Tag_Sample_Coding, sample_coding);
+    }
+
+    //! @brief Ensures that all of the required headers are valid. This does not
+    //! return anything as an exception will be thrown if the validation fails.
+    //! Checks that the sample length is 1, 2 or 4 bytes.
+    //! Checks that the headers indicating the various lengths and sizes are
+    //! correct by checking the amount of traces provided
+    //! @param p_number_of_traces The total number of traces.
+    //! @param p_samples_per_trace The number of samples within each trace.
+    //! @param p_sample_length The length of a single sample in bytes.
+    //! @exception std::range_error If the sample length is an invalid value,
+    //! or if the number of traces or samples per trace do not fit into the 32
+    //! bits the format stores them in, then this exception will be thrown.
+    //! @exception std::domain_error If the sizes and lengths do not match what
+    //! is in m_traces then this is thrown.
+    void validate_required_headers(const std::uint64_t p_number_of_traces,
+                                   const std::uint64_t p_samples_per_trace,
+                                   const std::uint8_t p_sample_length)
+    {
+        if (4 < p_sample_length || 3 == p_sample_length)
+        {
+            throw std::range_error("Sample length must be either 1, 2 or 4");
+        }
+
+        constexpr std::uint64_t max_count{
+            std::numeric_limits<std::uint32_t>::max()};
+        if (max_count < p_number_of_traces)
+        {
+            throw std::range_error(
+                "A TRS file cannot store more than 4294967295 traces. Split "
+                "the traces between multiple Serialisers and files.");
+        }
+        if (max_count < p_samples_per_trace)
+        {
+            throw std::range_error(
+                "A TRS file cannot store more than 4294967295 samples per "
+                "trace");
+        }
+
+        // Spilled traces are padded as they are written, so have no stored
+        // length to check against.
+        const std::uint64_t stored_samples_per_trace{
+            m_spilled.empty() ? m_traces.front().size() : m_samples_per_trace};
+
+        // Neither can exceed 32 bits so this cannot overflow.
+        if (p_number_of_traces * p_samples_per_trace !=
+            static_cast<std::uint64_t>(m_traces.size()) *
+                stored_samples_per_trace)
+        {
+            throw std::domain_error(
+                "Invalid parameters given. Either the number of traces, number "
+                "of samples per trace or the sample length is incorrect.");
+        }
+    }
+
+    //! @brief Checks if all of the extra data within p_extra_data of the
+    //! same length. This does not return anything as an exception will be
+    //! thrown if the validation fails.
+    //! @param p_extra_data The data to be checked
+    //! @exception std::domain_error If they are not all the same length
+    //! then this exception is thrown.
+    template <typename T_Traces, typename T_Allocator>
+    static constexpr void validate_extra_data_length(
+        const std::vector<T_Traces, T_Allocator>& p_extra_data)
+    {
+        if (!check_all_same_length(p_extra_data))
+        {
+            throw std::domain_error("Extra data must all be the same length");
+        }
+    }
+
+    template <typename T, typename T_Allocator>
+    static constexpr bool
+    check_all_same_length(const std::vector<T, T_Allocator>& p_data)
+    {
+        // If everything in p_data is not the same length
+        //
+        // Finds the first occurrence of two adjacent data points that don't
+        // have the same size. If this is the end of the vector then none were
+        // found and they are all the same size.
+        return std::adjacent_find(std::begin(p_data),
+                                  std::end(p_data),
+                                  [](const T& p_data_1, const T& p_data_2) {
+                                      // Check if these two are the same size.
+                                      return p_data_1.size() != p_data_2.size();
+                                  }) == std::end(p_data);
+    }
+
+    bool is_extra_data_digits() const
+    {
+        // There are no digits if there is no extra data. This is needed as
+        // std::all_of() is true for an empty range.
+        if (0 == m_extra_data.size())
+        {
+            return false;
+        }
+
+        // If this is completely numerical then output it as raw
+        // numbers, not ACSII.
+        return std::all_of(std::begin(m_extra_data),
+                           std::end(m_extra_data),
+                           [](const std::pmr::string& string) {
+                               return std::all_of(std::begin(string),
+                                                  std::end(string),
+                                                  ::isxdigit);
+                           });
+    }
+
+    //! @brief Encodes the extra data of a single trace ready to be saved.
+    //! @param p_index The index of the trace.
+    //! @param m_is_digits Whether the extra data is made up entirely of
+    //! hexadecimal digits, in which case each pair of digits is decoded into
+    //! one byte. Otherwise each character is saved as it is.
+    //! @param p_bytes The encoded extra data is appended to this.
+    void encode_extra_data(const std::size_t p_index,
+                           const bool m_is_digits,
+                           std::vector<char>& p_bytes) const
+    {
+        // Skip printing extra data if there is none. This is needed as
+        // traces added without extra data have no entry in m_extra_data.
+        if (0 == m_extra_data.size())
+        {
+            return;
+        }
+
+        // If this is completely numerical then output it as raw
+        // numbers, not ACSII.
+        if (m_is_digits)
+        {
+            // Increment by 2 at a time as 2 characters fit into a byte.
+            for (std::size_t i{0}, size{m_extra_data[p_index].length() - 1};
+                 i < size;
+                 i += 2)
+            {
+                // Get two characters from the string as 2 character make up
+                // 1 byte. Convert them to a number using std::stoi() and
+                // then convert the result to a byte using
+                // convert_to_bytes(). As convert_to_bytes() returns a
+                // vector but in this case it will only contain one byte,
+                // .front() is used to retrieve it from the vector.
+                p_bytes.push_back(static_cast<char>(
+                    convert_to_bytes(
+                        std::stoi(m_extra_data[p_index].substr(i, 2).c_str(),
+                                  nullptr,
+                                  16))
+                        .front()));
+            }
+        }
+        else
+        {
+            p_bytes.insert(std::end(p_bytes),
+                           std::begin(m_extra_data[p_index]),
+                           std::end(m_extra_data[p_index]));
+        }
+    }
+
+    //! @brief Sets the quantisation scale and offset so that the range of
+    //! the samples in m_traces fills the range of the quantised integers, if
+    //! they are calculated automatically. The scale and offset are then
+    //! recorded in Tag_Axis_Scale_Y and Tag_Scope_Offset respectively.
+    void prepare_quantisation()
+    {
+        m_quantisation_error = 0;
+
+        if (m_quantisation_automatic)
+        {
+            T_Sample minimum{std::numeric_limits<T_Sample>::max()};
+            T_Sample maximum{std::numeric_limits<T_Sample>::lowest()};
+            // Only the samples that were added are scanned, not the 0s that
+            // shorter traces have been padded with.
+            for (std::size_t i{m_spilled.size()}; i < m_traces.size(); ++i)
+            {
+                const std::size_t length{unpadded_length(i)};
+                if (0 == length)
+                {
+                    continue;
+                }
+                const auto begin{std::begin(m_traces[i])};
+                const auto range{std::minmax_element(
+                    begin, begin + static_cast<std::ptrdiff_t>(length))};
+                minimum = std::min(minimum, *range.first);
+                maximum = std::max(maximum, *range.second);
+            }
+            if (!m_spilled.empty())
+            {
+                minimum = std::min(minimum, m_spilled_minimum);
+                maximum = std::max(maximum, m_spilled_maximum);
+            }
+
+            // If there are no samples then any scale will do.
+            if (maximum < minimum)
+            {
+                minimum = maximum = T_Sample{0};
+            }
+
+            const double largest{static_cast<double>(
+                (1u << (8 * m_quantised_sample_length - 1)) - 1)};
+            m_quantisation_offset = (static_cast<double>(maximum) +
+                                     static_cast<double>(minimum)) /
+                                    2;
+            m_quantisation_scale =
+                maximum == minimum ? 1.0
+                                   : (static_cast<double>(maximum) -
+                                      static_cast<double>(minimum)) /
+                                         (2 * largest);
+        }
+
+        Set_Axis_Scale_Y(static_cast<float>(m_quantisation_scale));
+        Set_Scope_Offset(static_cast<float>(m_quantisation_offset));
+    }
+
+    //! @brief Quantises p_trace to signed integers of type T_Integer, rounding
+    //! to the nearest value and saturating, and stores their bytes in
+    //! p_bytes. The largest error introduced is recorded in
+    //! m_quantisation_error.
+    //! @tparam T_Integer The integer type the samples are quantised to.
+    //! @param p_trace The trace to be quantised.
+    //! @param p_length The number of samples in p_trace before it was padded.
+    //! The padding is not included in the error.
+    //! @param p_bytes The bytes of the quantised samples, ready to be saved,
+    //! are appended to this.
+    template <typename T_Integer>
+    void quantise_trace(const Stored_Trace& p_trace,
+                        const std::size_t p_length,
+                        std::vector<char>& p_bytes)
+    {
+        constexpr double lowest{std::numeric_limits<T_Integer>::lowest()};
+        constexpr double highest{std::numeric_limits<T_Integer>::max()};
+        // Adding and then subtracting this rounds any value of less than 2^51
+        // to the nearest integer, as std::nearbyint() does.
+        constexpr double rounding{0x1.8p52};
+        const double offset{m_quantisation_offset};
+        const double scale{m_quantisation_scale};
+        const double inverse_scale{1 / scale};
+
+        std::vector<T_Integer>& quantised{[this]() -> auto& {
+            if constexpr (std::is_same<T_Integer, std::int8_t>::value)
+            {
+                return m_quantised_8_bit;
+            }
+            else
+            {
+                return m_quantised_16_bit;
+            }
+        }()};
+        const std::size_t size{p_trace.size()};
+        quantised.resize(size);
+
+        // Plain pointers are used as 8 bit stores could otherwise change the
+        // pointers held by the vectors, as far as the compiler knows.
+        const T_Sample* const samples{p_trace.data()};
+        T_Integer* const output{quantised.data()};
+
+        // Saturating before rounding keeps the rounding exact. GCC only
+        // vectorises this with -O3 -fno-trapping-math, as otherwise the
+        // comparisons of the saturation are not allowed to be made
+        // unconditionally.
+        for (std::size_t i{0}; i < size; ++i)
+        {
+            const double value{std::min(
+                std::max((static_cast<double>(samples[i]) - offset) *
+                             inverse_scale,
+                         lowest),
+                highest)};
+            output[i] = static_cast<T_Integer>((value + rounding) - rounding);
+        }
+
+        // The error is found separately so that the loop above has no
+        // dependencies between samples.
+        double error{m_quantisation_error};
+        for (std::size_t i{0}, length{std::min(p_length, size)}; i < length;
+             ++i)
+        {
+            error = std::max(error,
+                             std::abs(static_cast<double>(samples[i]) -
+                                      (output[i] * scale + offset)));
+        }
+        m_quantisation_error = error;
+
+        // Inspector expects little endian samples, as is the case for
+        // floating point samples.
+        const std::size_t start{p_bytes.size()};
+        p_bytes.resize(start + size * sizeof(T_Integer));
+        std::memcpy(
+            p_bytes.data() + start, quantised.data(), size * sizeof(T_Integer));
+    }
+
+    //! @brief Encodes the samples of a single trace ready to be saved.
+    //! @param p_trace The trace.
+    //! @param p_length The number of samples in p_trace before it was padded.
+    //! @param p_bytes The encoded samples are appended to this.
+    void encode_trace(const Stored_Trace& p_trace,
+                      const std::size_t p_length,
+                      std::vector<char>& p_bytes)
+    {
+        if (0 != m_quantised_sample_length)
+        {
+            if (1 == m_quantised_sample_length)
+            {
+                quantise_trace<std::int8_t>(p_trace, p_length, p_bytes);
+            }
+            else
+            {
+                quantise_trace<std::int16_t>(p_trace, p_length, p_bytes);
+            }
+            return;
+        }
+
+        // Samples stored in their natural length are encoded without
+        // converting each one separately.
+        if (sizeof(T_Sample) == m_sample_length)
+        {
+            Sample_Encoder::Encode(
+                reinterpret_cast<const std::byte*>(p_trace.data()),
+                p_trace.size(),
+                sizeof(T_Sample),
+                p_bytes);
+            return;
+        }
+
+        for (const auto& sample :
+             convert_traces_to_bytes(p_trace, m_sample_length))
+        {
+            p_bytes.push_back(static_cast<char>(sample));
+        }
+    }
+
+    //! @brief Converts p_value to a sample. Integral samples are rounded to
+    //! the nearest value and saturated to the range of T_Sample.
+    //! @param p_value The value to be converted.
+    //! @returns p_value as a T_Sample.
+    static T_Sample to_sample(const double p_value)
+    {
+        if constexpr (std::is_integral<T_Sample>::value)
+        {
+            return static_cast<T_Sample>(std::clamp(
+                std::nearbyint(p_value),
+                static_cast<double>(std::numeric_limits<T_Sample>::lowest()),
+                static_cast<double>(std::numeric_limits<T_Sample>::max())));
+        }
+        else
+        {
+            return static_cast<T_Sample>(p_value);
+        }
+    }
+
+    //! @brief Calls p_function(begin, end) over contiguous blocks of the
+    //! range [0, p_count), sharing the blocks between the threads of
+    //! m_thread_pool and the current thread. If the range is too small to be
+    //! worth splitting into blocks of at least p_minimum_block then
+    //! p_function is simply called once on the current thread.
+    //! @param p_count The size of the range.
+    //! @param p_minimum_block The smallest block worth giving to a thread.
+    //! @param p_function The function to be called on each block. This must
+    //! not throw.
+    template <typename T_Function>
+    void parallel_for(const std::size_t p_count,
+                      const std::size_t p_minimum_block,
+                      const T_Function& p_function) const
+    {
+        const std::size_t threads{
+            0 != m_threads
+                ? m_threads
+                : std::max<std::size_t>(std::thread::hardware_concurrency(),
+                                        1)};
+        const std::size_t block_count{std::min(
+            threads, p_count / std::max<std::size_t>(p_minimum_block, 1))};
+
+        if (1 >= block_count)
+        {
+            p_function(std::size_t{0}, p_count);
+            return;
+        }
+
+        // The pool is only started once a trace is long enough to need it.
+        if (!m_thread_pool)
+        {
+            m_thread_pool = std::make_shared<Thread_Pool>(threads - 1);
+        }
+
+        const std::size_t block{(p_count + block_count - 1) / block_count};
+        m_thread_pool->Run(block_count, [&](const std::size_t p_block) {
+            const std::size_t begin{p_block * block};
+            if (begin < p_count)
+            {
+                p_function(begin, std::min(begin + block, p_count));
+            }
+        });
+    }
+
+    //! @brief Designs a low pass FIR filter using the windowed-sinc method
+    //! with a Hamming window.
+    //! @param p_cutoff The cutoff frequency as a fraction of the sample rate.
+    //! @param p_taps The number of coefficients. This must be odd.
+    //! @returns The filter coefficients, normalised to unity gain at DC.
+    static std::vector<double> design_low_pass_fir(const double p_cutoff,
+                                                   const std::size_t p_taps)
+    {
+        constexpr double pi{3.14159265358979323846};
+
+        std::vector<double> coefficients(p_taps);
+        const double middle{static_cast<double>(p_taps / 2)};
+        double sum{0};
+        for (std::size_t i{0}; i < p_taps; ++i)
+        {
+            const double n{static_cast<double>(i) - middle};
+            const double sinc{0 == n ? 2 * p_cutoff
+                                     : std::sin(2 * pi * p_cutoff * n) /
+                                           (pi * n)};
+            const double window{
+                0.54 - 0.46 * std::cos(2 * pi * static_cast<double>(i) /
+                                       static_cast<double>(p_taps - 1))};
+            coefficients[i] = sinc * window;
+            sum += coefficients[i];
+        }
+
+        for (auto& coefficient : coefficients)
+        {
+            coefficient /= sum;
+        }
+        return coefficients;
+    }
+
+    //! @brief Applies the FIR filter given by m_fir_coefficients to p_trace.
+    //! The filter is centred on each sample so that the linear phase filter
+    //! does not delay the trace. Samples beyond either end of the trace are
+    //! treated as 0.
+    //! @param p_trace The trace to be filtered.
+    //! @returns The filtered trace. This is the same length as p_trace.
+    std::vector<double> apply_fir(const std::vector<double>& p_trace) const
+    {
+        const std::size_t size{p_trace.size()};
+        const std::size_t taps{m_fir_coefficients.size()};
+        const std::size_t middle{taps / 2};
+
+        // Zero pad both ends so that the inner loop needs no bounds checks.
+        std::vector<double> padded(size + taps - 1, 0.0);
+        std::copy(std::begin(p_trace),
+                  std::end(p_trace),
+                  std::begin(padded) + static_cast<std::ptrdiff_t>(middle));
+
+        std::vector<double> filtered(size, 0.0);
+
+        // Long traces are split across threads. Looping over the
+        // coefficients on the outside leaves a simple multiply-add over
+        // contiguous samples on the inside, which GCC vectorises at -O3.
+        parallel_for(size,
+                     (1 << 20) / std::max<std::size_t>(taps, 1),
+                     [&](const std::size_t p_begin, const std::size_t p_end) {
+                         double* const output{filtered.data()};
+                         for (std::size_t k{0}; k < taps; ++k)
+                         {
+                             const double coefficient{m_fir_coefficients[k]};
+                             const double* const input{padded.data() + k};
+                             for (std::size_t i{p_begin}; i < p_end; ++i)
+                             {
+                                 output[i] += coefficient * input[i];
+                             }
+                         }
+                     });
+        return filtered;
+    }
+
+    //! @brief Applies the cascade of biquad sections given by m_biquads to
+    //! p_trace, in place. Each section uses the transposed direct form II.
+    //! @param p_trace The trace to be filtered.
+    void apply_biquads(std::vector<double>& p_trace) const
+    {
+        for (const auto& biquad : m_biquads)
+        {
+            double state_1{0};
+            double state_2{0};
+            for (auto& sample : p_trace)
+            {
+                const double input{sample};
+                sample  = biquad.b0 * input + state_1;
+                state_1 = biquad.b1 * input - biquad.a1 * sample + state_2;
+                state_2 = biquad.b2 * input - biquad.a2 * sample;
+            }
+        }
+    }
+
+    //! @brief Applies the FIR and IIR filters that have been set to p_trace.
+    //! @param p_trace The trace to be filtered.
+    //! @returns The filtered trace.
+    Stored_Trace filter_trace(const Stored_Trace& p_trace) const
+    {
+        std::vector<double> trace(std::begin(p_trace), std::end(p_trace));
+
+        if (!m_fir_coefficients.empty())
+        {
+            trace = apply_fir(trace);
+        }
+        apply_biquads(trace);
+
+        Stored_Trace filtered(trace.size());
+        std::transform(
+            std::begin(trace), std::end(trace), std::begin(filtered), to_sample);
+        return filtered;
+    }
+
+    //! @brief Reduces p_trace to a few samples per clock cycle by combining
+    //! each window of m_resample_step samples, after skipping the first
+    //! m_resample_phase_shift samples, as given by m_resample_mode. Any
+    //! incomplete window at the end of the trace is discarded.
+    //! @param p_trace The trace to be resampled.
+    //! @returns The resampled trace.
+    Stored_Trace resample_trace(const Stored_Trace& p_trace) const
+    {
+        if (p_trace.size() <= m_resample_phase_shift)
+        {
+            return {};
+        }
+
+        const auto output_size{static_cast<std::size_t>(
+            static_cast<double>(p_trace.size() - m_resample_phase_shift) /
+            m_resample_step)};
+        Stored_Trace resampled(output_size);
+
+        const T_Sample* const samples{p_trace.data() + m_resample_phase_shift};
+        for (std::size_t i{0}; i < output_size; ++i)
+        {
+            // Window boundaries are calculated from the start of the trace
+            // each time so that a non integer step does not drift.
+            const auto begin{
+                static_cast<std::size_t>(static_cast<double>(i) *
+                                         m_resample_step)};
+            const auto end{std::max(
+                begin + 1,
+                static_cast<std::size_t>(static_cast<double>(i + 1) *
+                                         m_resample_step))};
+
+            // GCC vectorises these reductions at -O3 for integer samples.
+            // Floating point sums must be kept in order, so those are not.
+            if (Resample_Mode::Max == m_resample_mode)
+            {
+                T_Sample maximum{samples[begin]};
+                for (std::size_t j{begin + 1}; j < end; ++j)
+                {
+                    maximum = std::max(maximum, samples[j]);
+                }
+                resampled[i] = maximum;
+                continue;
+            }
+
+            T_Accumulator sum{0};
+            for (std::size_t j{begin}; j < end; ++j)
+            {
+                sum += static_cast<T_Accumulator>(samples[j]);
+            }
+
+            resampled[i] = to_sample(
+                Resample_Mode::Mean == m_resample_mode
+                    ? static_cast<double>(sum) / static_cast<double>(end - begin)
+                    : static_cast<double>(sum));
+        }
+        return resampled;
+    }
+
+    //! @brief Finds the shift of p_trace that best matches the reference
+    //! pattern given to Set_Alignment(). Every shift within
+    //! m_alignment_max_shift that keeps the pattern inside the trace is
+    //! scored using the normalised cross-correlation.
+    //! @param p_trace The trace to be aligned.
+    //! @returns The best shift and its correlation coefficient. If no shift
+    //! keeps the pattern inside the trace, the correlation is negative
+    //! infinity.
+    std::pair<std::ptrdiff_t, double>
+    find_alignment(const Stored_Trace& p_trace) const
+    {
+        const auto length{
+            static_cast<std::ptrdiff_t>(m_alignment_reference.size())};
+        const auto offset{static_cast<std::ptrdiff_t>(m_alignment_offset)};
+        const auto max_shift{
+            static_cast<std::ptrdiff_t>(m_alignment_max_shift)};
+
+        // The range of shifts that keep the pattern inside the trace.
+        const std::ptrdiff_t first{std::max(-max_shift, -offset)};
+        const std::ptrdiff_t last{
+            std::min(max_shift,
+                     static_cast<std::ptrdiff_t>(p_trace.size()) - length -
+                         offset)};
+        if (first > last)
+        {
+            return {0, -std::numeric_limits<double>::infinity()};
+        }
+
+        // The part of the trace that may be compared with the pattern.
+        const auto shifts{static_cast<std::size_t>(last - first + 1)};
+        const std::vector<double> samples(
+            std::begin(p_trace) + offset + first,
+            std::begin(p_trace) + offset + last + length);
+
+        // Prefix sums give the mean and energy of every window in constant
+        // time.
+        std::vector<double> sum(samples.size() + 1, 0.0);
+        std::vector<double> sum_of_squares(samples.size() + 1, 0.0);
+        for (std::size_t i{0}; i < samples.size(); ++i)
+        {
+            sum[i + 1]            = sum[i] + samples[i];
+            sum_of_squares[i + 1] = sum_of_squares[i] + samples[i] * samples[i];
+        }
+
+        // Looping over the pattern on the outside leaves a multiply-add over
+        // contiguous shifts on the inside, vectorised by GCC at -O3. Large
+        // searches are split across threads.
+        std::vector<double> dot_products(shifts, 0.0);
+        parallel_for(
+            shifts,
+            (1 << 20) / static_cast<std::size_t>(length),
+            [&](const std::size_t p_begin, const std::size_t p_end) {
+                double* const output{dot_products.data()};
+                for (std::ptrdiff_t k{0}; k < length; ++k)
+                {
+                    const double reference{
+                        m_alignment_reference[static_cast<std::size_t>(k)]};
+                    const double* const input{samples.data() + k};
+                    for (std::size_t i{p_begin}; i < p_end; ++i)
+                    {
+                        output[i] += reference * input[i];
+                    }
+                }
+            });
+
+        std::pair<std::ptrdiff_t, double> best{
+            0, -std::numeric_limits<double>::infinity()};
+        for (std::size_t i{0}; i < shifts; ++i)
+        {
+            const double window_sum{sum[i + length] - sum[i]};
+            const double variance{sum_of_squares[i + length] -
+                                  sum_of_squares[i] -
+                                  window_sum * window_sum /
+                                      static_cast<double>(length)};
+
+            // As the reference has zero mean, the dot product is unaffected
+            // by the mean of the window. Flat windows do not correlate.
+            const double correlation{
+                0 < variance && 0 < m_alignment_reference_norm
+                    ? dot_products[i] /
+                          (std::sqrt(variance) * m_alignment_reference_norm)
+                    : 0.0};
+
+            if (correlation > best.second)
+            {
+                best = {first + static_cast<std::ptrdiff_t>(i), correlation};
+            }
+        }
+        return best;
+    }
+
+    //! @brief Aligns p_trace against the reference pattern and, if it is not
+    //! rejected, passes it on to be processed and stored. The shift is
+    //! appended to the extra data as 8 hexadecimal digits, if requested.
+    //! @param p_trace The trace to be aligned.
+    //! @param p_extra_data The extra data associated with this trace.
+    void align_trace(const Stored_Trace& p_trace,
+                     const std::string& p_extra_data)
+    {
+        const auto alignment{find_alignment(p_trace)};
+        if (alignment.second < m_alignment_threshold)
+        {
+            ++m_rejected_trace_count;
+            m_metrics.Trace_Dropped();
+            return;
+        }
+
+        // Move the trace so that the pattern starts at m_alignment_offset,
+        // filling in with 0s at whichever end is exposed.
+        const std::ptrdiff_t shift{alignment.first};
+        const auto size{static_cast<std::ptrdiff_t>(p_trace.size())};
+        Stored_Trace aligned(p_trace.size(), T_Sample{0});
+        std::copy(std::begin(p_trace) + std::max<std::ptrdiff_t>(shift, 0),
+                  std::begin(p_trace) + std::min(size, size + shift),
+                  std::begin(aligned) + std::max<std::ptrdiff_t>(-shift, 0));
+
+        // The shift is not recorded for averaged traces as each acquisition
+        // may have been shifted differently and the extra data is what groups
+        // them.
+        if (!m_record_alignment_shift || 0 != m_repeat_count)
+        {
+            process_and_ingest(aligned, p_extra_data);
+            return;
+        }
+
+        std::ostringstream extra_data;
+        extra_data << p_extra_data << std::hex << std::setfill('0')
+                   << std::setw(8)
+                   << static_cast<std::uint32_t>(static_cast<std::int32_t>(shift));
+        process_and_ingest(aligned, extra_data.str());
+    }
+
+    //! @brief Applies all of the enabled processing stages, in order,
+    //! to p_trace. These are filtering followed by resampling.
+    //! @param p_trace The trace to be processed.
+    //! @returns The processed trace.
+    Stored_Trace process_trace(const Stored_Trace& p_trace) const
+    {
+        if (m_fir_coefficients.empty() && m_biquads.empty())
+        {
+            return resample_trace(p_trace);
+        }
+
+        Stored_Trace trace{filter_trace(p_trace)};
+        if (0 != m_resample_step)
+        {
+            trace = resample_trace(trace);
+        }
+        return trace;
+    }
+
+    //! @brief Finds every event in p_trace and passes a window of samples
+    //! around each one on to be averaged or stored as its own trace. Each
+    //! window is m_sparse_window_length samples long, starting
+    //! m_sparse_pre_trigger samples before the event, or at the start of the
+    //! recording if that is later. A window may begin in a previous trace and
+    //! end in a later one, in which case it is passed on once the trace
+    //! containing its last sample has been added. Events within the previous
+    //! window are ignored. The position of the window within the continuous
+    //! recording is appended to the extra data as 16 hexadecimal digits.
+    //! @param p_trace The part of the continuous recording to be searched.
+    //! @param p_extra_data The extra data associated with this trace.
+    void record_windows(const Stored_Trace& p_trace,
+                        const std::string& p_extra_data)
+    {
+        const std::size_t size{p_trace.size()};
+        if (0 == size)
+        {
+            return;
+        }
+
+        // Finish the window left waiting by a previous trace first.
+        if (!m_sparse_pending.empty())
+        {
+            const std::size_t missing{std::min(
+                m_sparse_window_length - m_sparse_pending.size(), size)};
+            m_sparse_pending.insert(std::end(m_sparse_pending),
+                                    p_trace.data(),
+                                    p_trace.data() + missing);
+            ingest_pending_window();
+        }
+
+        // Mark every crossing first, as this loop has no dependencies between
+        // samples (GCC vectorises it at -O3).
+        std::vector<std::uint8_t> crossings(size);
+        {
+            const T_Sample* const samples{p_trace.data()};
+            const T_Sample threshold{m_sparse_threshold};
+            const bool rising{Trigger_Edge::Falling != m_sparse_edge};
+            const bool falling{Trigger_Edge::Rising != m_sparse_edge};
+
+            crossings[0] = static_cast<std::uint8_t>(
+                (rising && m_sparse_previous_sample < threshold &&
+                 samples[0] >= threshold) ||
+                (falling && m_sparse_previous_sample > threshold &&
+                 samples[0] <= threshold));
+            for (std::size_t i{1}; i < size; ++i)
+            {
+                crossings[i] = static_cast<std::uint8_t>(
+                    (rising & (samples[i - 1] < threshold) &
+                     (samples[i] >= threshold)) |
+                    (falling & (samples[i - 1] > threshold) &
+                     (samples[i] <= threshold)));
+            }
+        }
+
+        const std::size_t length{m_sparse_window_length};
+        for (std::size_t i{0}; i < size; ++i)
+        {
+            const std::uint64_t event{m_sparse_position + i};
+            if (0 == crossings[i] || event < m_sparse_window_end)
+            {
+                continue;
+            }
+
+            const std::uint64_t start{
+                event - std::min<std::uint64_t>(event, m_sparse_pre_trigger)};
+            m_sparse_window_end = start + length;
+
+            std::ostringstream extra_data;
+            extra_data << p_extra_data << std::hex << std::setfill('0')
+                       << std::setw(16) << start;
+
+            // The number of samples of the window within previous traces,
+            // which are all in m_sparse_history, and the first sample of the
+            // window within this one.
+            const std::size_t before{static_cast<std::size_t>(
+                m_sparse_position - std::min(m_sparse_position, start))};
+            const std::size_t first{i - std::min(i, m_sparse_pre_trigger)};
+            const std::size_t available{
+                std::min(length - before, size - first)};
+
+            if (length == available)
+            {
+                ingest_trace(copy_trace(p_trace.data() + first, length),
+                             extra_data.str());
+                continue;
+            }
+
+            m_sparse_pending.assign(std::end(m_sparse_history) -
+                                        static_cast<std::ptrdiff_t>(before),
+                                    std::end(m_sparse_history));
+            m_sparse_pending.insert(std::end(m_sparse_pending),
+                                    p_trace.data() + first,
+                                    p_trace.data() + first + available);
+            m_sparse_pending_extra_data = extra_data.str();
+            ingest_pending_window();
+        }
+
+        // Keep the samples that the window of an event in the next trace may
+        // begin within.
+        const std::size_t kept{std::min(m_sparse_pre_trigger, size)};
+        m_sparse_history.insert(std::end(m_sparse_history),
+                                p_trace.data() + size - kept,
+                                p_trace.data() + size);
+        m_sparse_history.erase(
+            std::begin(m_sparse_history),
+            std::end(m_sparse_history) -
+                static_cast<std::ptrdiff_t>(std::min(
+                    m_sparse_pre_trigger, m_sparse_history.size())));
+
+        m_sparse_position += size;
+        m_sparse_previous_sample = p_trace.back();
+    }
+
+    //! @brief Passes m_sparse_pending on to be averaged or stored as its own
+    //! trace if it has all of its samples.
+    void ingest_pending_window()
+    {
+        if (m_sparse_window_length != m_sparse_pending.size())
+        {
+            return;
+        }
+
+        ingest_trace(copy_trace(m_sparse_pending.data(),
+                                m_sparse_pending.size()),
+                     m_sparse_pending_extra_data);
+        m_sparse_pending.clear();
+    }
+
+    //! @brief Passes p_trace on to be averaged or stored, or, when recording
+    //! sparsely, only the windows around the events within it.
+    //! @param p_trace The trace to be added.
+    //! @param p_extra_data The extra data associated with this trace.
+    template <typename T_Trace>
+    void split_and_ingest(T_Trace&& p_trace, const std::string& p_extra_data)
+    {
+        if (0 != m_sparse_window_length)
+        {
+            record_windows(p_trace, p_extra_data);
+            return;
+        }
+
+        ingest_trace(std::forward<T_Trace>(p_trace), p_extra_data);
+    }
+
+    //! @brief Copies p_size samples starting at p_samples into a new trace,
+    //! allocated from the same memory resource as m_traces.
+    //! polymorphic_allocator constructs each sample separately when a range
+    //! is copied into a container, which is not vectorised, so the samples
+    //! are copied afterwards instead.
+    //! @param p_samples The first sample to be copied.
+    //! @param p_size The number of samples to be copied.
+    //! @returns The copy of the samples.
+    Stored_Trace copy_trace(const T_Sample* const p_samples,
+                            const std::size_t p_size) const
+    {
+        Stored_Trace trace(p_size, m_traces.get_allocator());
+        std::copy_n(p_samples, p_size, trace.data());
+        return trace;
+    }
+
+    //! @brief Adds a single trace, which has already been copied, so can be
+    //! moved into storage. m_mutex must already be held.
+    //! @see Add_Trace()
+    void add_trace(Stored_Trace p_trace,
+                   const std::string& p_extra_data)
+    {
+        m_metrics.Trace_Ingested();
+
+        if (!m_alignment_reference.empty())
+        {
+            align_trace(p_trace, p_extra_data);
+            return;
+        }
+
+        process_and_ingest(std::move(p_trace), p_extra_data);
+    }
+
+    //! @brief Converts p_value to a sample, saturating it to the range of
+    //! T_Sample if it is out of range. Floating point values are rounded to
+    //! the nearest integer when converted to integer samples, and NaN becomes
+    //! 0.
+    //! @tparam T_Value The arithmetic type of p_value.
+    //! @param p_value The value to be converted.
+    //! @returns p_value as a T_Sample.
+    template <typename T_Value>
+    static T_Sample saturate_sample(const T_Value p_value)
+    {
+        constexpr T_Sample lowest{std::numeric_limits<T_Sample>::lowest()};
+        constexpr T_Sample highest{std::numeric_limits<T_Sample>::max()};
+
+        if constexpr (std::is_floating_point<T_Value>::value)
+        {
+            if constexpr (std::is_integral<T_Sample>::value)
+            {
+                // NaN is not equal to itself.
+                return p_value == p_value
+                           ? to_sample(static_cast<double>(p_value))
+                           : T_Sample{0};
+            }
+            else
+            {
+                return static_cast<T_Sample>(std::clamp(
+                    static_cast<long double>(p_value),
+                    static_cast<long double>(lowest),
+                    static_cast<long double>(highest)));
+            }
+        }
+        else if constexpr (std::is_floating_point<T_Sample>::value)
+        {
+            return static_cast<T_Sample>(p_value);
+        }
+        else
+        {
+            // Integers are compared in the widest type of the same
+            // signedness, so that mixed signedness compares correctly.
+            if constexpr (std::is_signed<T_Value>::value)
+            {
+                if (p_value < 0)
+                {
+                    return static_cast<std::intmax_t>(p_value) <
+                                   static_cast<std::intmax_t>(lowest)
+                               ? lowest
+                               : static_cast<T_Sample>(p_value);
+                }
+            }
+            return static_cast<std::uintmax_t>(p_value) >
+                           static_cast<std::uintmax_t>(highest)
+                       ? highest
+                       : static_cast<T_Sample>(p_value);
+        }
+    }
+
+    //! @brief Passes p_trace through the enabled processing stages and then
+    //! on to be averaged or stored.
+    //! @param p_trace The trace to be added.
+    //! @param p_extra_data The extra data associated with this trace.
+    template <typename T_Trace>
+    void process_and_ingest(T_Trace&& p_trace, const std::string& p_extra_data)
+    {
+        if (m_fir_coefficients.empty() && m_biquads.empty() &&
+            0 == m_resample_step)
+        {
+            split_and_ingest(std::forward<T_Trace>(p_trace), p_extra_data);
+            return;
+        }
+
+        split_and_ingest(process_trace(p_trace), p_extra_data);
+    }
+
+    //! @brief Validates and stores the quantisation settings.
+    //! @see Set_Quantisation()
+    void set_quantisation(const std::uint8_t p_sample_length,
+                          const bool p_automatic,
+                          const float p_scale,
+                          const float p_offset)
+    {
+        if (!std::is_floating_point<T_Sample>::value)
+        {
+            throw std::domain_error(
+                "Only floating point traces can be quantised");
+        }
+
+        if (1 != p_sample_length && 2 != p_sample_length)
+        {
+            throw std::range_error(
+                "Quantised sample length must be either 1 or 2");
+        }
+
+        if (!(0 < p_scale))
+        {
+            throw std::range_error("Quantisation scale must be positive");
+        }
+
+        m_quantised_sample_length = p_sample_length;
+        m_quantisation_automatic  = p_automatic;
+        m_quantisation_scale      = p_scale;
+        m_quantisation_offset     = p_offset;
+    }
+
+    //! @brief Sets the filter related headers and stores the filter that
+    //! will be applied to each trace as it is added. Any previous filter is
+    //! replaced.
+    //! @param p_type The type of filter. One of the Filter_Type_* values.
+    //! @param p_frequency The cutoff or centre frequency of the filter.
+    //! @param p_range The width of the pass band, or 0 if not applicable.
+    //! @param p_fir_coefficients The FIR filter, if any.
+    //! @param p_biquads The IIR filter, if any.
+    void set_filter(const std::uint32_t p_type,
+                    const float p_frequency,
+                    const float p_range,
+                    std::vector<double> p_fir_coefficients,
+                    std::vector<Biquad> p_biquads)
+    {
+        m_fir_coefficients = std::move(p_fir_coefficients);
+        m_biquads          = std::move(p_biquads);
+
+        Set_Filter_Type(p_type);
+        Set_Filter_Frequency(p_frequency);
+        Set_Filter_Range(p_range);
+    }
+
+    //! @brief Passes p_trace on to be averaged or stored, depending on
+    //! whether repeat averaging is enabled.
+    //! @param p_trace The trace to be added.
+    //! @param p_extra_data The extra data associated with this trace.
+    template <typename T_Trace>
+    void ingest_trace(T_Trace&& p_trace, const std::string& p_extra_data)
+    {
+        if (0 != m_repeat_count)
+        {
+            accumulate_repeat(p_trace, p_extra_data);
+            return;
+        }
+
+        store_trace(std::forward<T_Trace>(p_trace), p_extra_data);
+    }
+
+    //! @brief Appends a single trace, along with its extra data, to the
+    //! traces that will be saved. This is the final step of Add_Trace() once
+    //! any processing of the trace has taken place.
+    //! @param p_trace The trace to be stored.
+    //! @param p_extra_data The extra data associated with this trace.
+    void store_trace(Stored_Trace p_trace,
+                     const std::string& p_extra_data)
+    {
+        // If this is the first trace provided then m_samples_per_trace needs to
+        // be set.
+        // m_traces can contain 0 as the first element as a side effect of
+        // initialisation.
+        if (m_traces.front().empty() && m_spilled.empty())
+        {
+            m_samples_per_trace = p_trace.size();
+            // If this was an empty trace set, m_traces can contain 0 as the
+            // first element.
+            m_traces[0] = std::move(p_trace);
+
+            // Reset m_number_of_traces as this is the first element. This will
+            // be incremented shortly.
+            m_number_of_traces = 0;
+        }
+        else
+        {
+            m_traces.emplace_back(std::move(p_trace));
+        }
+
+        if (!p_extra_data.empty())
+        {
+            m_extra_data.emplace_back(p_extra_data);
+        }
+
+        m_metrics.Trace_Stored(m_traces.back().size() * m_sample_length);
+
+        // TODO: Does this need to be stored?
+        m_number_of_traces++;
+
+        m_memory_used +=
+            m_traces.back().size() * sizeof(T_Sample) + p_extra_data.size();
+        if (0 != m_memory_budget && m_memory_budget < m_memory_used)
+        {
+            spill();
+        }
+    }
+
+    //! @brief Moves the oldest traces held in memory to m_spill_file until
+    //! the memory used is no more than half of m_memory_budget, so that
+    //! traces are spilled in batches rather than every time one is added.
+    //! Extra data is always kept in memory.
+    void spill()
+    {
+        const std::size_t target{m_memory_budget / 2};
+        for (std::size_t i{m_spilled.size()};
+             i < m_traces.size() && target < m_memory_used;
+             ++i)
+        {
+            Stored_Trace& trace{m_traces[i]};
+            const std::size_t bytes{trace.size() * sizeof(T_Sample)};
+            const std::uint64_t offset{m_spill_file->Append(
+                reinterpret_cast<const char*>(trace.data()), bytes)};
+            m_spilled.emplace_back(offset, trace.size());
+
+            const std::size_t length{unpadded_length(i)};
+            if (0 != length)
+            {
+                const auto range{std::minmax_element(
+                    std::begin(trace),
+                    std::begin(trace) + static_cast<std::ptrdiff_t>(length))};
+                m_spilled_minimum = std::min(m_spilled_minimum, *range.first);
+                m_spilled_maximum = std::max(m_spilled_maximum, *range.second);
+            }
+
+            // Replacing the samples with an empty trace from the same memory
+            // resource frees them.
+            trace = Stored_Trace{m_traces.get_allocator()};
+            m_memory_used -= bytes;
+        }
+    }
+
+    //! @returns Whether spilled traces are saved exactly as they are
+    //! stored, so can be copied straight from m_spill_file.
+    bool spilled_traces_copyable() const
+    {
+        return 0 == m_quantised_sample_length &&
+               sizeof(T_Sample) == m_sample_length;
+    }
+
+    //! @brief Adds p_trace to the running sum of repeated acquisitions. If
+    //! p_extra_data differs from that of the acquisitions already summed, they
+    //! are averaged and stored first. Once m_repeat_count acquisitions have
+    //! been summed they are averaged and stored.
+    //! @param p_trace The repeated acquisition to be added.
+    //! @param p_extra_data The extra data associated with this acquisition.
+    //! @exception std::domain_error If p_trace is not the same length as the
+    //! acquisitions it is being averaged with.
+    void accumulate_repeat(const Stored_Trace& p_trace,
+                           const std::string& p_extra_data)
+    {
+        if (0 != m_repeats_accumulated && p_extra_data != m_repeat_extra_data)
+        {
+            store_average();
+        }
+
+        if (0 == m_repeats_accumulated)
+        {
+            m_repeat_sum.assign(p_trace.size(), T_Accumulator{0});
+            m_repeat_extra_data = p_extra_data;
+        }
+        else if (p_trace.size() != m_repeat_sum.size())
+        {
+            throw std::domain_error(
+                "Repeated acquisitions must all be the same length");
+        }
+
+        // GCC vectorises this accumulation at -O3.
+        const std::size_t size{p_trace.size()};
+        const T_Sample* const samples{p_trace.data()};
+        T_Accumulator* const sum{m_repeat_sum.data()};
+        for (std::size_t i{0}; i < size; ++i)
+        {
+            sum[i] += static_cast<T_Accumulator>(samples[i]);
+        }
+
+        if (++m_repeats_accumulated >= m_repeat_count)
+        {
+            store_average();
+        }
+    }
+
+    //! @brief Averages the repeated acquisitions currently summed in
+    //! m_repeat_sum and stores the result as a single trace. Integral samples
+    //! are rounded to the nearest value. If nothing has been summed then no
+    //! action is taken.
+    void store_average()
+    {
+        if (0 == m_repeats_accumulated)
+        {
+            return;
+        }
+
+        const std::size_t size{m_repeat_sum.size()};
+        Stored_Trace average(size, m_traces.get_allocator());
+        if constexpr (std::is_integral<T_Sample>::value)
+        {
+            const auto count{static_cast<T_Accumulator>(m_repeats_accumulated)};
+            for (std::size_t i{0}; i < size; ++i)
+            {
+                // Round half away from zero.
+                const T_Accumulator sum{m_repeat_sum[i]};
+                average[i] = static_cast<T_Sample>(
+                    (sum + (0 > sum ? -count : count) / 2) / count);
+            }
+        }
+        else
+        {
+            const double scale{1.0 /
+                               static_cast<double>(m_repeats_accumulated)};
+            for (std::size_t i{0}; i < size; ++i)
+            {
+                average[i] = static_cast<T_Sample>(m_repeat_sum[i] * scale);
+            }
+        }
+
+        m_repeats_accumulated = 0;
+        store_trace(std::move(average), m_repeat_extra_data);
+    }
+
+public:
+    // clang-format off
+    // The values of Tag_Filter_Type that are set when traces are filtered by
+    // Set_Low_Pass_Filter() or Set_Band_Pass_Filter().
+    constexpr static std::uint32_t Filter_Type_None                    {0};
+    constexpr static std::uint32_t Filter_Type_Low_Pass                {1};
+    constexpr static std::uint32_t Filter_Type_High_Pass               {2};
+    constexpr static std::uint32_t Filter_Type_Band_Pass               {3};
+    // clang-format on
+
+    //! @brief The ways in which a filter can be implemented.
+    //! FIR filters are windowed-sinc filters that are linear phase and so do
+    //! not shift features within the trace. IIR filters are biquads which are
+    //! far cheaper but introduce a frequency dependant delay.
+    enum class Filter_Design
+    {
+        FIR,
+        IIR
+    };
+
+    //! The number of coefficients used by FIR filters unless specified.
+    constexpr static std::size_t Default_FIR_Taps{63};
+
+    //! @brief Constructs the Serialiser object and adds all of the
+    //! mandatory data. Optional headers can be set later. All traces are
+    //! required to be passed to the constructor.
+    //! @param p_traces All of the traces stored as 2D vector. This is
+    //! interpreted as a vector of traces with each trace being a vector of
+    //! samples.
+    //! @param p_sample_length The length of a trace sample in bytes. This
+    //! can optionally be specified. If not specified then it is assumed to
+    //! be the size of the data type samples are stored as, given by
+    //! T_Sample.
+    // TODO: Add support for cryptographic data to be included in each
+    // trace.
+    Serialiser(const std::vector<std::vector<T_Sample>>& p_traces,
+               const std::uint8_t p_sample_length = sizeof(T_Sample))
+        : Serialiser{{}, p_traces, p_sample_length}
+    {
+    }
+
+    //! @todo Document
+    //! @todo Does p_sample_length ever need to be specified manually? It
+    //! certainly does not for 2d constructors.
+    //! @param p_memory_resource The memory resource that the traces and
+    //! their extra data are allocated from. This must outlive the
+    //! Serialiser. Copies of the Serialiser use the default memory resource.
+    Serialiser(const std::vector<std::string>& p_extra_data,
+               const std::vector<std::vector<T_Sample>>& p_traces,
+               const std::uint8_t p_sample_length = sizeof(T_Sample),
+               std::pmr::memory_resource* const p_memory_resource =
+                   std::pmr::get_default_resource())
+        : Headers{}, m_number_of_traces{p_traces.size()},
+          // Number of samples per trace can be assumed to be the length of
+          // one trace.
+          m_samples_per_trace{p_traces.front().size()},
+          m_sample_length{p_sample_length},
+          // Set longest trace length to 0 for now. It will be changed later
+          m_longest_trace_length{0},
+          m_extra_data{std::begin(p_extra_data),
+                       std::end(p_extra_data),
+                       p_memory_resource},
+          m_traces{p_memory_resource}, m_repeat_count{0}, m_repeat_sum{},
+          m_repeats_accumulated{0}, m_repeat_extra_data{},
+          m_fir_coefficients{}, m_biquads{}, m_resample_step{0},
+          m_resample_phase_shift{0}, m_resample_mode{Resample_Mode::Mean},
+          m_alignment_reference{}, m_alignment_reference_norm{0},
+          m_alignment_offset{0}, m_alignment_max_shift{0},
+          m_alignment_threshold{0}, m_record_alignment_shift{false},
+          m_rejected_trace_count{0}, m_sparse_window_length{0},
+          m_sparse_pre_trigger{0}, m_sparse_threshold{0},
+          m_sparse_edge{Trigger_Edge::Rising}, m_sparse_position{0},
+          m_sparse_previous_sample{0}, m_sparse_history{},
+          m_sparse_pending{p_memory_resource}, m_sparse_pending_extra_data{},
+          m_sparse_window_end{0}, m_quantised_sample_length{0},
+          m_quantisation_automatic{false}, m_quantisation_scale{1},
+          m_quantisation_offset{0}, m_quantisation_error{0},
+          m_quantised_8_bit{}, m_quantised_16_bit{},
+          m_save_progress_callback{}, m_save_progress_interval{0},
+          m_sync_on_save{false}, m_memory_budget{0}, m_memory_used{0},
+          m_spill_file{}, m_spilled{},
+          m_spilled_minimum{std::numeric_limits<T_Sample>::max()},
+          m_spilled_maximum{std::numeric_limits<T_Sample>::lowest()},
+          m_padded_lengths{}, m_metrics{}, m_mutex{}, m_threads{0}, m_thread_pool{}
+    {
+        m_traces.reserve(p_traces.size());
+        for (const auto& trace : p_traces)
+        {
+            m_traces.emplace_back(copy_trace(trace.data(), trace.size()));
+            m_memory_used += trace.size() * sizeof(T_Sample);
+        }
+        for (const auto& extra_data : p_extra_data)
+        {
+            m_memory_used += extra_data.size();
+        }
+    }
+
+    //! @todo Document
+    explicit Serialiser(const std::uint8_t p_sample_length = sizeof(T_Sample))
+        : Serialiser{{{}}, p_sample_length}
+    {
+    }
+
+    // SWIG cannot wrap std::pmr::memory_resource so this is hidden from it.
+#ifndef SWIG
+    //! @brief Constructs an empty Serialiser whose traces and extra data are
+    //! allocated from p_memory_resource, rather than with new. This allows
+    //! large trace sets to be stored in an arena, such as a
+    //! Huge_Page_Arena or a std::pmr::monotonic_buffer_resource, avoiding
+    //! fragmentation and reducing page faults.
+    //! @param p_memory_resource The memory resource that the traces and
+    //! their extra data are allocated from. This must outlive the
+    //! Serialiser.
+    //! @param p_sample_length The length of a trace sample in bytes.
+    //! @note Traces are still copied to temporary storage allocated with
+    //! the default memory resource while they are filtered, resampled or
+    //! aligned.
+    explicit Serialiser(std::pmr::memory_resource* const p_memory_resource,
+                        const std::uint8_t p_sample_length = sizeof(T_Sample))
+        : Serialiser{{}, {{}}, p_sample_length, p_memory_resource}
+    {
+    }
+#endif  // SWIG
+
+    //! @brief Constructs the Serialiser object from traces stored
+    //! contiguously, one after another. This avoids building a 2D vector
+    //! first when the traces are already in a single block of memory, such
+    //! as a NumPy array.
+    //! @param p_samples The first sample of the first trace.
+    //! @param p_number_of_traces The number of traces.
+    //! @param p_samples_per_trace The number of samples in each trace.
+    //! @see Add_Traces()
+    Serialiser(const T_Sample* const p_samples,
+               const std::size_t p_number_of_traces,
+               const std::size_t p_samples_per_trace)
+        : Serialiser{}
+    {
+        Add_Traces(p_samples, p_number_of_traces, p_samples_per_trace);
+    }
+
+    //! @brief This appends a single trace to the end of the list of traces.
+    //! Extra data associated with this trace can also be added using
+    //! p_extra_data. This will also validate the length of this data and
+    //! can throw exceptions if this is of the incorrect length.
+    //! If alignment has been enabled with Set_Alignment() then the trace is
+    //! aligned first, and may be rejected.
+    //! If a filter has been set with Set_Low_Pass_Filter() or
+    //! Set_Band_Pass_Filter() then the trace is then filtered.
+    //! If resampling has been enabled with Set_Clock_Resampling() then the
+    //! trace is then resampled.
+    //! If sparse recording has been enabled with Set_Sparse_Recording() then
+    //! only the windows around events within the trace are kept, each as its
+    //! own trace.
+    //! If repeat averaging has been enabled with Set_Repeat_Averaging() then
+    //! the trace is summed with the other repeated acquisitions and only their
+    //! average is stored.
+    //! @param p_trace The trace to be added.
+    //! @param p_extra_data The extra data with this trace to be added.
+    //! @note This can be called while Save() runs on another thread, in
+    //! which case it waits for the save to finish.
+    void Add_Trace(const std::vector<T_Sample>& p_trace,
+                   const std::string& p_extra_data = std::string{})
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        add_trace(copy_trace(p_trace.data(), p_trace.size()), p_extra_data);
+    }
+
+    //! @brief Appends a single trace of p_size samples starting at
+    //! p_samples. This is the same as the std::vector overload but the
+    //! samples are copied straight into the stored trace, so traces held in
+    //! other containers do not need to be converted to a std::vector first.
+    //! @param p_samples The first sample of the trace to be added.
+    //! @param p_size The number of samples in the trace.
+    //! @param p_extra_data The extra data with this trace to be added.
+    void Add_Trace(const T_Sample* const p_samples,
+                   const std::size_t p_size,
+                   const std::string& p_extra_data = std::string{})
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        add_trace(copy_trace(p_samples, p_size), p_extra_data);
+    }
+
+    // The bindings use the pointer overload instead, so this is hidden from
+    // SWIG.
+#ifndef SWIG
+    //! @brief Appends a single trace held in any contiguous container, such
+    //! as std::array or a buffer from a scope driver, of any arithmetic type
+    //! other than char. Samples of a different type are converted as they
+    //! are copied into storage, saturating any that are out of range and
+    //! rounding floating point values to the nearest integer when the
+    //! samples are integers.
+    //! @tparam T_Range A type for which std::data() and std::size() give
+    //! the samples.
+    //! @param p_trace The trace to be added.
+    //! @param p_extra_data The extra data with this trace to be added.
+    //! @see Add_Trace(const std::vector<T_Sample>&, const std::string&)
+    template <typename T_Range,
+              typename T_Value = std::remove_cv_t<std::remove_pointer_t<
+                  decltype(std::data(std::declval<const T_Range&>()))>>,
+              typename = std::enable_if_t<std::is_arithmetic<T_Value>::value &&
+                                          !std::is_same<T_Value, char>::value>>
+    void Add_Trace(const T_Range& p_trace,
+                   const std::string& p_extra_data = std::string{})
+    {
+        const T_Value* const values{std::data(p_trace)};
+        const std::size_t size{std::size(p_trace)};
+
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        if constexpr (std::is_same<T_Value, T_Sample>::value)
+        {
+            add_trace(copy_trace(values, size), p_extra_data);
+        }
+        else
+        {
+            // GCC vectorises this at -O3 for integer values. Floating point
+            // values are checked for NaN and rounded one at a time.
+            Stored_Trace trace(size, m_traces.get_allocator());
+            for (std::size_t i{0}; i < size; ++i)
+            {
+                trace[i] = saturate_sample(values[i]);
+            }
+            add_trace(std::move(trace), p_extra_data);
+        }
+    }
+#endif  // SWIG
+
+    //! @brief Appends p_number_of_traces traces stored contiguously, one
+    //! after another, starting at p_samples. Each is added as if by
+    //! Add_Trace().
+    //! @param p_samples The first sample of the first trace.
+    //! @param p_number_of_traces The number of traces to be added.
+    //! @param p_samples_per_trace The number of samples in each trace.
+    //! @param p_extra_data The extra data of each trace. This is either
+    //! empty or has one element for every trace.
+    //! @note Like Add_Trace(), this waits for any save on another thread to
+    //! finish.
+    //! @exception std::range_error If p_extra_data is not empty and does not
+    //! have one element for every trace.
+    void Add_Traces(const T_Sample* const p_samples,
+                    const std::size_t p_number_of_traces,
+                    const std::size_t p_samples_per_trace,
+                    const std::vector<std::string>& p_extra_data = {})
+    {
+        if (!p_extra_data.empty() && p_number_of_traces != p_extra_data.size())
+        {
+            throw std::range_error("There must be extra data for every trace "
+                                   "or for none of them");
+        }
+
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        m_traces.reserve(m_traces.size() + p_number_of_traces);
+        m_extra_data.reserve(m_extra_data.size() + p_extra_data.size());
+
+        const std::string no_extra_data{};
+        for (std::size_t i{0}; i < p_number_of_traces; ++i)
+        {
+            const T_Sample* const trace{p_samples + i * p_samples_per_trace};
+            add_trace(copy_trace(trace, p_samples_per_trace),
+                      p_extra_data.empty() ? no_extra_data : p_extra_data[i]);
+        }
+    }
+
+    //! @brief Enables averaging of repeated acquisitions. Consecutive calls
+    //! to Add_Trace() with the same extra data are summed and only their
+    //! average is stored, reducing the number of traces saved by up to a
+    //! factor of p_repeat_count. A group of repeated acquisitions ends when
+    //! p_repeat_count acquisitions have been added or when the extra data
+    //! changes, whichever happens first.
+    //! @param p_repeat_count The maximum number of acquisitions averaged into
+    //! a single trace. 0 or 1 disables averaging.
+    //! @note Any acquisitions that are pending when this is called are
+    //! averaged and stored first.
+    void Set_Repeat_Averaging(const std::size_t p_repeat_count)
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        store_average();
+        m_repeat_count = 1 < p_repeat_count ? p_repeat_count : 0;
+    }
+
+    //! @brief This saves the current state of the headers, along with the
+    //! traces to a file specified by p_file_path.
+    //! @param p_file_path The path of the file to save to.
+    //! @param p_stats If given, this is filled in with the time taken by each
+    //! phase of saving and the amount written.
+    //! @note If the path contains a directory that doesn't exist, it will
+    //! not be created, instead an error file be thrown. New files will be
+    //! created however.
+    //! @note If a progress callback set with Set_Save_Progress_Callback()
+    //! cancels the save, the partially written file is removed and
+    //! p_stats->cancelled is set.
+    //! @note Traces can be added, and settings and headers changed, from
+    //! other threads while this runs. They wait until the save has finished
+    //! and so do not affect the file.
+    //! @exception std::ios_base::failure Throws an exception if creating
+    //! the output stream fails for any reason. For example, directory
+    //! doesn't exist.
+    void Save(const std::string& p_file_path, Save_Stats* const p_stats = nullptr)
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+
+        Save_Stats stats{};
+        const auto save_start{std::chrono::steady_clock::now()};
+        auto phase_start{save_start};
+
+        // Adds the time since the last call to p_phase and returns it.
+        const auto end_phase{[&phase_start](std::chrono::nanoseconds& p_phase) {
+            const auto now{std::chrono::steady_clock::now()};
+            const std::chrono::nanoseconds duration{now - phase_start};
+            p_phase += duration;
+            phase_start = now;
+            return duration;
+        }};
+
+        std::ofstream output_file(p_file_path,
+                                  std::ios::out | std::ios::binary);
+
+        if (!output_file)
+        {
+            throw std::ios_base::failure("An error occurred when preparing "
+                                         "the file to be written to");
+        }
+        end_phase(stats.io);
+
+        // Any repeated acquisitions still being summed form the last trace.
+        store_average();
+
+        // TRS files require all traces to be of the same length.
+        pad_all_traces();
+        end_phase(stats.padding);
+
+        bool is_digits{false};
+
+        // Set this header to match the data that is stored.
+        //! @todo this will override any user set value. Maybe make this a
+        //! private function as a solution?
+        if (m_extra_data.size() > 0)  // Don't do this if not extra data is
+                                      // supplied, it will cause a Segfault.
+        {
+            is_digits = is_extra_data_digits();
+
+            // Digits take up half the space of ASCII.
+            const std::size_t length{is_digits
+                                         ? m_extra_data.front().size() / 2
+                                         : m_extra_data.front().size()};
+            if (std::numeric_limits<std::uint16_t>::max() < length)
+            {
+                throw std::range_error("The extra data of each trace must be "
+                                       "no more than 65535 bytes");
+            }
+            Set_Cryptographic_Data_Length(static_cast<std::uint16_t>(length));
+        }
+
+        end_phase(stats.extra_data_decoding);
+
+        // Ensure information stored will create a valid trs file.
+        //! @todo Group all THREE validation functions in a valid function.
+        validate_extra_data_length(m_extra_data);
+        end_phase(stats.validation);
+
+        // This has to be done after changing the length of cryptographic
+        // data as it is dependant on that information.
+        if (0 != m_quantised_sample_length)
+        {
+            prepare_quantisation();
+        }
+        end_phase(stats.trace_encoding);
+
+        add_required_headers(m_number_of_traces,
+                             m_samples_per_trace,
+                             0 != m_quantised_sample_length
+                                 ? m_quantised_sample_length
+                                 : m_sample_length);
+        end_phase(stats.validation);
+
+        // The headers are only encoded again if they have changed since the
+        // last save.
+        const std::vector<char>& headers{m_headers.Render()};
+        end_phase(stats.header_encoding);
+
+        output_file.write(headers.data(),
+                          static_cast<std::streamsize>(headers.size()));
+        stats.bytes_written += headers.size();
+        end_phase(stats.io);
+
+        // Each trace is encoded into this before being written.
+        std::vector<char> bytes;
+
+        // Spilled traces are either copied straight from the spill file into
+        // this, or read back into spilled_trace and encoded as normal.
+        std::optional<Spill_File::Destination> destination{};
+        if (!m_spilled.empty() && spilled_traces_copyable())
+        {
+            destination.emplace(p_file_path);
+        }
+        Stored_Trace spilled_trace{};
+
+        // For each trace
+        {
+            const std::size_t size{m_traces.size()};
+            stats.traces_to_write = size;
+            for (std::size_t i{0}; i < size; ++i)
+            {
+                bytes.clear();
+                encode_extra_data(i, is_digits, bytes);
+                const auto decode_time{end_phase(stats.extra_data_decoding)};
+
+                // The number of bytes written without passing through bytes.
+                std::size_t copied{0};
+                if (i >= m_spilled.size())
+                {
+                    encode_trace(m_traces[i], unpadded_length(i), bytes);
+                }
+                else if (destination)
+                {
+                    // The extra data is written first so that the samples
+                    // can be copied after it, leaving only the padding.
+                    const auto [offset, samples] = m_spilled[i];
+                    output_file.write(
+                        bytes.data(),
+                        static_cast<std::streamsize>(bytes.size()));
+                    output_file.flush();
+                    copied = bytes.size() + samples * sizeof(T_Sample);
+                    m_spill_file->Copy_To(*destination,
+                                          stats.bytes_written + bytes.size(),
+                                          offset,
+                                          samples * sizeof(T_Sample));
+                    output_file.seekp(
+                        static_cast<std::streamoff>(stats.bytes_written +
+                                                    copied));
+                    bytes.assign((std::max<std::size_t>(m_samples_per_trace,
+                                                        samples) -
+                                  samples) *
+                                     sizeof(T_Sample),
+                                 0);
+                }
+                else
+                {
+                    const auto [offset, samples] = m_spilled[i];
+                    spilled_trace.resize(samples);
+                    m_spill_file->Read(
+                        offset,
+                        reinterpret_cast<char*>(spilled_trace.data()),
+                        samples * sizeof(T_Sample));
+                    spilled_trace.resize(m_samples_per_trace, T_Sample{0});
+                    encode_trace(spilled_trace, unpadded_length(i), bytes);
+                }
+                const auto encode_time{end_phase(stats.trace_encoding)};
+
+                output_file.write(bytes.data(),
+                                  static_cast<std::streamsize>(bytes.size()));
+                stats.bytes_written += copied + bytes.size();
+                ++stats.traces_written;
+                const auto write_time{end_phase(stats.io)};
+
+                m_metrics.Trace_Written(copied + bytes.size(),
+                                        decode_time + encode_time,
+                                        write_time);
+                const double elapsed{
+                    std::chrono::duration<double>(phase_start - save_start)
+                        .count()};
+                if (0 < elapsed)
+                {
+                    m_metrics.Set_Megabytes_Per_Second(
+                        static_cast<double>(stats.bytes_written) / 1e6 /
+                        elapsed);
+                }
+
+                if (m_save_progress_callback &&
+                    0 == stats.traces_written % m_save_progress_interval &&
+                    !m_save_progress_callback(stats))
+                {
+                    stats.cancelled = true;
+                    break;
+                }
+            }
+        }
+
+        output_file.close();
+        end_phase(stats.io);
+
+        if (stats.cancelled)
+        {
+            std::remove(p_file_path.c_str());
+            end_phase(stats.io);
+        }
+        else
+        {
+            if (!output_file)
+            {
+                throw std::ios_base::failure("An error occurred when writing "
+                                             "to the file");
+            }
+
+            if (m_sync_on_save)
+            {
+                sync_file(p_file_path);
+                end_phase(stats.fsync);
+            }
+
+            m_metrics.Save_Completed();
+        }
+
+        stats.total = std::chrono::steady_clock::now() - save_start;
+        const double seconds{
+            std::chrono::duration<double>(stats.total).count()};
+        if (0 < seconds)
+        {
+            stats.megabytes_per_second =
+                static_cast<double>(stats.bytes_written) / 1e6 / seconds;
+            m_metrics.Set_Megabytes_Per_Second(stats.megabytes_per_second);
+        }
+
+        if (nullptr != p_stats)
+        {
+            *p_stats = stats;
+        }
+    }
+
+    //! @brief Sets a callback that Save() calls with its progress every
+    //! p_interval traces written. The callback can return false to cancel the
+    //! save, which removes the partially written file.
+    //! @param p_callback The callback. An empty callback disables this.
+    //! @param p_interval The number of traces written between calls.
+    //! @exception std::range_error If p_interval is 0.
+    void Set_Save_Progress_Callback(Save_Progress_Callback p_callback,
+                                    const std::size_t p_interval = 1000)
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        if (0 == p_interval)
+        {
+            throw std::range_error("The progress interval must be at least 1 "
+                                   "trace");
+        }
+
+        m_save_progress_callback = std::move(p_callback);
+        m_save_progress_interval = p_interval;
+    }
 
-private:
-    //! This is the main container that stores the trace header information,
-    //! ready to be saved into the output file. The format uses a
-    //! type-length-value encoding to store this information.
-    //! @see https://en.wikipedia.org/wiki/Type-length-value
-    //! In this data structure, the headers are indexed by their type in a
-    //! map. The map then contains a pair, which corresponds to the length
-    //! and the value. The tag and length are stored as one or more bytes
-    //! (std::vector<std::byte>).
-    std::map<std::uint8_t,
-             std::pair<std::vector<std::byte>, std::vector<std::byte>>>
-        m_headers;
+    //! @brief Gets the counters describing the work done by this Serialiser.
+    //! These can be read from another thread while traces are being added
+    //! or saved, or periodically written to a file using a Metrics_Dumper.
+    //! @returns The metrics. This reference remains valid for the lifetime
+    //! of this Serialiser.
+    const Metrics& Get_Metrics() const { return m_metrics; }
 
-    //! @todo Document
-    std::uint64_t
-        m_number_of_traces;  //!@todo Does this need to be stored? - no -
-                             //! m_traces.size() - Maybe use a macro instead ?
-    std::uint64_t
-        m_samples_per_trace;  //!@todo Does this need to be stored? - no -
-                              //! m_traces.size() - Maybe use a macro
-                              //! instead?
-    const std::uint8_t m_sample_length;
+    //! @brief Sets whether Save() flushes the file to disk before returning,
+    //! so that it is not lost if the system fails shortly afterwards. This
+    //! is slower, so is disabled by default.
+    //! @param p_sync Whether to flush the file to disk.
+    void Set_Sync_On_Save(const bool p_sync = true)
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        m_sync_on_save = p_sync;
+    }
 
-    std::size_t m_longest_trace_length;
+    //! @brief Limits the memory used by the traces held by this Serialiser.
+    //! Once their samples and extra data use more than p_bytes, the oldest
+    //! traces are moved to an anonymous temporary file until they use no
+    //! more than half of p_bytes. Save() copies them back into the saved
+    //! file, so this can be used to record more traces than fit in memory.
+    //! @param p_bytes The memory budget in bytes. 0 removes the limit,
+    //! although traces that have already been spilled stay on disk.
+    //! @note Extra data is always kept in memory.
+    //! @note Spilled traces that are neither quantised nor saved in a
+    //! different sample length are copied into the saved file by the kernel,
+    //! without passing through this process, where the platform supports it.
+    //! @exception std::domain_error If this platform does not support
+    //! spilling to disk.
+    //! @exception std::ios_base::failure If the temporary file cannot be
+    //! created or written to.
+    void Set_Memory_Budget(const std::size_t p_bytes)
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        if (0 != p_bytes && !m_spill_file)
+        {
+            m_spill_file = std::make_shared<Spill_File>();
+        }
 
-    std::vector<std::string> m_extra_data;
+        m_memory_budget = p_bytes;
+        if (0 != m_memory_budget && m_memory_budget < m_memory_used)
+        {
+            spill();
+        }
+    }
 
-    //! This contains the actual side channel analysis traces, stored as
-    //! bytes ready to be saved into the output file.
-    //! @todo Don't store a traces object. This is simply the value to the
-    //! Tag_Trace_Block_Marker.
-    std::vector<std::vector<T_Sample>> m_traces;
+    //! @returns The number of traces that have been spilled to disk.
+    //! @see Set_Memory_Budget()
+    std::size_t Get_Number_Of_Spilled_Traces() const
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        return m_spilled.size();
+    }
 
-    //! @brief Converts the data given by the parameter p_data into a series
-    //! of bytes.
-    //! @param p_data The data to be converted to bytes. This uses templates
-    //! so that this function can convert any basic data type and
-    //! std::string to bytes.
-    //! @returns A series of bytes represented using std::vector<std::byte>.
-    //! @todo See if this can all be replaced by std::bitset?
-    template <typename T_Data>
-    static const std::vector<std::byte> convert_to_bytes(const T_Data& p_data)
+    //! @brief Sets the number of threads that filtering and aligning long
+    //! traces is split between, including the thread adding the trace. The
+    //! extra threads are started when first needed and are kept until the
+    //! Serialiser is destroyed or this is called again.
+    //! @param p_threads The number of threads. 0, the default, uses one per
+    //! hardware thread and 1 does all of the work on the adding thread.
+    void Set_Threads(const std::size_t p_threads)
     {
-        // A temporary store for the converted bytes.
-        std::vector<std::byte> bytes_vector;
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        m_threads = p_threads;
+        m_thread_pool.reset();
+    }
 
-        // Strings need to be handled separately.
-        if constexpr (std::is_same<T_Data, std::string>::value)
+    //! @brief Low pass filters every trace added with Add_Trace() from this
+    //! point onwards. The filter headers are set to describe the filter.
+    //! @param p_cutoff_frequency The cutoff frequency in Hz.
+    //! @param p_sample_rate The rate the traces were sampled at in Hz.
+    //! @param p_design Whether to use a FIR or IIR filter.
+    //! @param p_taps The number of coefficients used by a FIR filter. Even
+    //! values are rounded up to the next odd value.
+    //! @exception std::range_error If the cutoff frequency is not between 0
+    //! and the Nyquist frequency, or a FIR filter has fewer than 3 taps.
+    void Set_Low_Pass_Filter(const float p_cutoff_frequency,
+                             const float p_sample_rate,
+                             const Filter_Design p_design = Filter_Design::FIR,
+                             const std::size_t p_taps     = Default_FIR_Taps)
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        const double cutoff{static_cast<double>(p_cutoff_frequency) /
+                            static_cast<double>(p_sample_rate)};
+        if (!(0 < cutoff && 0.5 > cutoff))
         {
-            // Get a char array from the string and cast it to a byte array
-            // TODO: std::string is a container. Treat it as such using
-            // convert_traces_to_bytes() instead of separate handling here.
-            auto bytes_array =
-                reinterpret_cast<const std::byte*>(p_data.c_str());
+            throw std::range_error(
+                "Filter frequencies must be between 0 and half the sample rate");
+        }
+        // The window of a FIR filter is not defined for fewer taps.
+        if (Filter_Design::FIR == p_design && 3 > p_taps)
+        {
+            throw std::range_error("FIR filters must have at least 3 taps");
+        }
 
-            // Convert byte array to byte vector
-            bytes_vector = {bytes_array, bytes_array + p_data.size()};
+        if (Filter_Design::FIR == p_design)
+        {
+            set_filter(Filter_Type_Low_Pass,
+                       p_cutoff_frequency,
+                       0,
+                       design_low_pass_fir(cutoff, p_taps | 1),
+                       {});
+            return;
         }
-        else
+
+        // Butterworth response, as per the Audio EQ Cookbook.
+        // https://www.w3.org/TR/audio-eq-cookbook/
+        constexpr double pi{3.14159265358979323846};
+        const double omega{2 * pi * cutoff};
+        const double alpha{std::sin(omega) / std::sqrt(2.0)};
+        const double a0{1 + alpha};
+        const double cos_omega{std::cos(omega)};
+        set_filter(Filter_Type_Low_Pass,
+                   p_cutoff_frequency,
+                   0,
+                   {},
+                   {{(1 - cos_omega) / 2 / a0,
+                     (1 - cos_omega) / a0,
+                     (1 - cos_omega) / 2 / a0,
+                     -2 * cos_omega / a0,
+                     (1 - alpha) / a0}});
+    }
+
+    //! @brief Band pass filters every trace added with Add_Trace() from this
+    //! point onwards. The filter headers are set to describe the filter, with
+    //! the frequency being the centre of the pass band and the range its
+    //! width.
+    //! @param p_low_frequency The lower edge of the pass band in Hz.
+    //! @param p_high_frequency The upper edge of the pass band in Hz.
+    //! @param p_sample_rate The rate the traces were sampled at in Hz.
+    //! @param p_design Whether to use a FIR or IIR filter.
+    //! @param p_taps The number of coefficients used by a FIR filter. Even
+    //! values are rounded up to the next odd value.
+    //! @exception std::range_error If the pass band is empty or not between 0
+    //! and the Nyquist frequency, or a FIR filter has fewer than 3 taps.
+    void Set_Band_Pass_Filter(const float p_low_frequency,
+                              const float p_high_frequency,
+                              const float p_sample_rate,
+                              const Filter_Design p_design = Filter_Design::FIR,
+                              const std::size_t p_taps     = Default_FIR_Taps)
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        const double low{static_cast<double>(p_low_frequency) /
+                         static_cast<double>(p_sample_rate)};
+        const double high{static_cast<double>(p_high_frequency) /
+                          static_cast<double>(p_sample_rate)};
+        if (!(0 < low && low < high && 0.5 > high))
         {
-            // Cast to a byte array
-            auto bytes_array = reinterpret_cast<const std::byte*>(&p_data);
+            throw std::range_error(
+                "Filter frequencies must be between 0 and half the sample rate");
+        }
+        // The window of a FIR filter is not defined for fewer taps.
+        if (Filter_Design::FIR == p_design && 3 > p_taps)
+        {
+            throw std::range_error("FIR filters must have at least 3 taps");
+        }
 
-            // Convert byte array to byte vector
-            bytes_vector = {bytes_array, bytes_array + sizeof(T_Data)};
+        const float range{p_high_frequency - p_low_frequency};
 
-            // TODO:: Should this affect floats only? or strings too?
-            if constexpr (std::is_integral<T_Data>::value)
-            {
-                // Needed to remove trailing 0s
-                bytes_vector.erase(
-                    std::remove_if(bytes_vector.begin(),
-                                   bytes_vector.end(),
-                                   [](const std::byte byte) {
-                                       return 0 ==
-                                              std::to_integer<uint8_t>(byte);
-                                   }),
-                    bytes_vector.end());
-
-                // If bytes_vector is empty then removing trailing 0s has
-                // removed the original value, 0; therefore re-add it.
-                if (bytes_vector.empty())
-                {
-                    bytes_vector.push_back(std::byte{0});
-                }
-            }
+        if (Filter_Design::FIR == p_design)
+        {
+            // A band pass filter is the difference of two low pass filters.
+            std::vector<double> coefficients{
+                design_low_pass_fir(high, p_taps | 1)};
+            const std::vector<double> low_pass{
+                design_low_pass_fir(low, p_taps | 1)};
+            std::transform(std::begin(coefficients),
+                           std::end(coefficients),
+                           std::begin(low_pass),
+                           std::begin(coefficients),
+                           std::minus<double>{});
+
+            set_filter(Filter_Type_Band_Pass,
+                       (p_low_frequency + p_high_frequency) / 2,
+                       range,
+                       std::move(coefficients),
+                       {});
+            return;
         }
-        return bytes_vector;
+
+        // Constant 0 dB peak gain band pass, as per the Audio EQ Cookbook.
+        // https://www.w3.org/TR/audio-eq-cookbook/
+        constexpr double pi{3.14159265358979323846};
+        const double centre{std::sqrt(low * high)};
+        const double omega{2 * pi * centre};
+        const double alpha{std::sin(omega) / (2 * centre / (high - low))};
+        const double a0{1 + alpha};
+        set_filter(Filter_Type_Band_Pass,
+                   static_cast<float>(centre * p_sample_rate),
+                   range,
+                   {},
+                   {{alpha / a0,
+                     0,
+                     -alpha / a0,
+                     -2 * std::cos(omega) / a0,
+                     (1 - alpha) / a0}});
     }
 
-    //! @brief This function is intended to ensure that each item in p_data
-    //! correct length as defined by p_sample_length by padding it with 0s.
-    //! This function will prepend 0s onto the front of p_data.
-    //! If the length of the data is already greater than or equal to
-    //! p_sample_length, no action will be taken. This may result in implicit
-    //! shortening of the value but most modern compilers will pick this up.
-    //! @tparam T The type of the data to the padded. The type stored in p_data.
-    //! This will work with any type where T{0} will successfully construct.
-    //! @param p_data The data to be padded to the correct length as a
-    //! vector of bytes.
-    //! @param p_length The length the data will be padded to.
-    //! @return Returns a copy of the original data vector, padded with 0s to
-    //! the length given by p_sample_length.
-    //! @todo Pass p_data by pointer
-    template <typename T>
-    static const std::vector<T> pad_front(std::vector<T> p_data,
-                                          const std::uint8_t p_length)
-    {
-        while (p_data.size() < p_length)
-        {
-            p_data.insert(std::begin(p_data), T{0});
-        }
-        return p_data;
-    }
-
-    //! @brief This function is intended to ensure that each item in p_data
-    //! correct length as defined by p_sample_length by padding it with 0s.
-    //! This function will append 0s onto the end of p_data.
-    //! If the length of the data is already greater than or equal to
-    //! p_sample_length, no action will be taken. This may result in implicit
-    //! shortening of the value but most modern compilers will pick this up.
-    //! @tparam T The type of the data to the padded. The type stored in p_data.
-    //! This will work with any type where T{0} will successfully construct.
-    //! @param p_data The data to be padded to the correct length as a
-    //! vector of bytes.
-    //! @param p_length The length the data will be padded to.
-    //! @return Returns a copy of the original data vector, padded with 0s to
-    //! the length given by p_sample_length.
-    //! @todo Pass p_data by pointer
-    template <typename T>
-    static const std::vector<T> pad_back(std::vector<T> p_data,
-                                         const std::size_t p_length)
+    //! @brief Stops filtering traces as they are added and removes the
+    //! filter headers.
+    void Clear_Filter()
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        m_fir_coefficients.clear();
+        m_biquads.clear();
+
+        m_headers.Erase(Tag_Filter_Type);
+        m_headers.Erase(Tag_Filter_Frequency);
+        m_headers.Erase(Tag_Filter_Range);
+    }
+
+    //! @brief Resamples every trace added with Add_Trace() from this point
+    //! onwards to p_multiplier samples per cycle of the target's clock. Each
+    //! output sample combines the input samples within its fraction of a clock
+    //! cycle, as given by p_mode. The external clock headers are set to
+    //! describe the resampling and the X axis scale is set to the new
+    //! sample period.
+    //! @param p_sample_rate The rate the traces were sampled at in Hz.
+    //! @param p_clock_frequency The frequency of the target's clock in Hz.
+    //! @param p_mode How the samples within each window are combined.
+    //! Summing integral samples saturates at the largest value of T_Sample.
+    //! @param p_multiplier The number of samples kept per clock cycle.
+    //! @param p_phase_shift The number of samples at the start of each trace
+    //! before the first clock cycle begins. These are discarded.
+    //! @exception std::range_error If the clock frequency or multiplier is
+    //! not greater than 0, the number of samples per clock cycle is not
+    //! finite, or this would not reduce the number of samples.
+    void Set_Clock_Resampling(const float p_sample_rate,
+                              const float p_clock_frequency,
+                              const Resample_Mode p_mode = Resample_Mode::Mean,
+                              const std::uint32_t p_multiplier  = 1,
+                              const std::uint32_t p_phase_shift = 0)
     {
-        while (p_data.size() < p_length)
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        const double step{static_cast<double>(p_sample_rate) /
+                          static_cast<double>(p_clock_frequency) /
+                          static_cast<double>(p_multiplier)};
+        if (!(0 < p_clock_frequency) || 0 == p_multiplier ||
+            !std::isfinite(step))
+        {
+            throw std::range_error("The clock frequency and multiplier must be "
+                                   "greater than 0 and the sample rate finite");
+        }
+        if (!(1 <= step))
         {
-            p_data.emplace_back(0);
+            throw std::range_error("The sample rate must be at least the "
+                                   "clock frequency times the multiplier");
         }
-        return p_data;
+
+        m_resample_step        = step;
+        m_resample_phase_shift = p_phase_shift;
+        m_resample_mode        = p_mode;
+
+        Set_External_Clock_Used();
+        Set_External_Clock_Frequency(p_clock_frequency);
+        Set_External_Clock_Multiplier(p_multiplier);
+        Set_External_Clock_Phase_Shift(p_phase_shift);
+        Set_Axis_Scale_X(1 / (p_clock_frequency * p_multiplier));
     }
 
-    //! @brief Retrieves the length of the longest element in p_data.
-    //! @param p_data The contain from which the length of the longest element
-    //! will be found.
-    //! @tparam T The type of the data to the padded. The type stored in p_data.
-    //! This will work with any type where the operator < is defined.
-    //! @returns The size of the largest element in p_data
-    template <typename T> static std::size_t get_longest(const T& p_data)
+    //! @brief Stops resampling traces as they are added and removes the
+    //! headers set by Set_Clock_Resampling().
+    void Clear_Clock_Resampling()
     {
-        return (*std::max_element(
-                    std::begin(p_data),
-                    std::end(p_data),
-                    [](const auto& p_first, const auto& p_second) {
-                        return p_first.size() < p_second.size();
-                    }))
-            .size();
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        m_resample_step = 0;
+
+        m_headers.Erase(Tag_External_Clock_Used);
+        m_headers.Erase(Tag_External_Clock_Frequency);
+        m_headers.Erase(Tag_External_Clock_Multiplier);
+        m_headers.Erase(Tag_External_Clock_Phase_Shift);
+        m_headers.Erase(Tag_Axis_Scale_X);
     }
 
-    //! @brief Pads all of the data in m_traces to ensure each trace is of the
-    //! same length using pad_back().
-    //! This is necessary as TRS files require all traces to be of the same
-    //! length.
-    void pad_all_traces()
+    //! @brief Aligns every trace added with Add_Trace() from this point
+    //! onwards against a reference pattern, removing trigger jitter before
+    //! the traces are stored. The shift with the highest normalised
+    //! cross-correlation is found and the trace is moved so that the pattern
+    //! starts at p_reference_offset. Samples moved in from beyond either end
+    //! of the trace are 0.
+    //! @param p_reference The pattern to align traces against.
+    //! @param p_reference_offset The position in an aligned trace at which
+    //! the pattern starts.
+    //! @param p_max_shift The largest shift, in either direction, to search.
+    //! @param p_threshold Traces are rejected if their best correlation is
+    //! below this. The default only rejects traces too short to be aligned.
+    //! @param p_record_shift Whether the shift applied to each trace is
+    //! appended to its extra data, as 8 hexadecimal digits of a 32 bit two's
+    //! complement value. This is not done when averaging repeats.
+    //! @exception std::domain_error If the reference pattern is empty or
+    //! constant, as a constant pattern does not correlate with anything.
+    void Set_Alignment(const std::vector<T_Sample>& p_reference,
+                       const std::size_t p_reference_offset,
+                       const std::size_t p_max_shift,
+                       const double p_threshold    = -1,
+                       const bool p_record_shift = true)
     {
-        // If the longest trace length is not yet recorded, so calculate it.
-        if (0 == m_longest_trace_length)
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        if (p_reference.empty())
         {
-            m_longest_trace_length = get_longest(m_traces);
+            throw std::domain_error("The reference pattern must not be empty");
         }
-        for (auto& trace : m_traces)
+
+        std::vector<double> reference(std::begin(p_reference),
+                                      std::end(p_reference));
+
+        // Removing the mean makes the correlation independent of any DC
+        // offset between the pattern and the traces.
+        const double mean{
+            std::accumulate(std::begin(reference), std::end(reference), 0.0) /
+            static_cast<double>(reference.size())};
+        double sum_of_squares{0};
+        for (auto& sample : reference)
         {
-            trace = pad_back(trace, m_longest_trace_length);
+            sample -= mean;
+            sum_of_squares += sample * sample;
         }
 
-        // This may have changed during padding.
-        m_samples_per_trace = m_traces.front().size();
+        if (!(0 < sum_of_squares))
+        {
+            throw std::domain_error("The reference pattern must not be "
+                                    "constant");
+        }
+
+        m_alignment_reference      = std::move(reference);
+        m_alignment_reference_norm = std::sqrt(sum_of_squares);
+        m_alignment_offset         = p_reference_offset;
+        m_alignment_max_shift      = p_max_shift;
+        m_alignment_threshold      = p_threshold;
+        m_record_alignment_shift   = p_record_shift;
     }
 
-    //! @brief Converts a vector of data given by the parameter p_data into a
-    //! single series of bytes.
-    //! The input can be a nested vector, in which case it will be recursively
-    //! unpacked it and the values inside will be converted to bytes.
-    //! @param p_data A vector or nested vector contained the data to be
-    //! converted to bytes. This uses templates so that this function can
-    //! convert any basic data type and std::string to bytes.
-    //! @param p_sample_length The length each sample should be. This is used to
-    //! pad each individual sample to the correct length.
-    //! @returns A series of bytes represented using std::vector<std::byte>.
-    template <typename T_Traces>
-    static const std::vector<std::byte>
-    convert_traces_to_bytes(const std::vector<T_Traces>& p_data,
-                            const std::uint8_t p_sample_length)
+    //! @brief Stops aligning traces as they are added.
+    void Clear_Alignment()
     {
-        std::vector<std::byte> bytes_vector;
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        m_alignment_reference.clear();
+    }
 
-        // For each value in the vector
-        for (const auto& data : p_data)
+    //! @brief Retrieves the number of traces that have been rejected rather
+    //! than stored, for example because they could not be aligned.
+    //! @returns The number of rejected traces.
+    std::size_t Get_Rejected_Trace_Count() const
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        return m_rejected_trace_count;
+    }
+
+    //! @brief Records only short windows around events from this point
+    //! onwards, keeping long continuous recordings affordable. Each trace
+    //! added with Add_Trace() is treated as the next part of a continuous
+    //! recording and searched for crossings of p_threshold. A window of
+    //! samples around each one, which may span several of the traces added,
+    //! is stored as its own trace, with its position within the recording
+    //! appended to its extra data as 16 hexadecimal digits.
+    //! @param p_threshold The level an event must cross.
+    //! @param p_window_length The number of samples kept for each event.
+    //! Events within the window of a previous event are ignored.
+    //! @param p_pre_trigger The number of samples kept before each event.
+    //! @param p_edge The direction of crossing that counts as an event.
+    //! @exception std::range_error If the window is empty or does not
+    //! include the event.
+    void Set_Sparse_Recording(const T_Sample p_threshold,
+                              const std::size_t p_window_length,
+                              const std::size_t p_pre_trigger = 0,
+                              const Trigger_Edge p_edge = Trigger_Edge::Rising)
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        if (p_pre_trigger >= p_window_length)
         {
-            const std::vector<std::byte> data_vector{[&]() {
-                // If this is nested container, recursively unpack it until
-                // we get at the values inside.
-                if constexpr (!std::is_same<std::vector<T_Traces>,
-                                            std::vector<T_Sample>>::value)
-                {
-                    // Check that each sub container is of the same length
+            throw std::range_error(
+                "The window must be longer than the pre-trigger");
+        }
 
-                    return convert_traces_to_bytes(data, p_sample_length);
-                }
-                // if this is not a nested container simply convert
-                // each of the values.
-                return pad_front(convert_to_bytes(data), p_sample_length);
-            }()};
+        m_sparse_threshold       = p_threshold;
+        m_sparse_window_length   = p_window_length;
+        m_sparse_pre_trigger     = p_pre_trigger;
+        m_sparse_edge            = p_edge;
+        m_sparse_position        = 0;
+        m_sparse_previous_sample = p_threshold;
+        m_sparse_window_end      = 0;
+        m_sparse_history.clear();
+        m_sparse_pending.clear();
+    }
 
-            // Append the converted values onto the end of bytes_vector
-            // ready to be returned.
-            bytes_vector.insert(std::end(bytes_vector),
-                                std::begin(data_vector),
-                                std::end(data_vector));
-        }
-        return bytes_vector;
+    //! @brief Stops recording sparsely so every trace added is stored whole.
+    //! A window still waiting for samples from the next trace is discarded.
+    void Clear_Sparse_Recording()
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        m_sparse_window_length = 0;
+        m_sparse_pending.clear();
     }
 
-    //! @brief A helper function to add all of the headers required to be in
-    //! a trace file. The headers currently required are the number of
-    //! traces, the number of samples per trace and the sample coding. The
-    //! sample coding is not required as an input here as it can be
-    //! calculated based off of the length of one sample.
-    //! @note Although Tag_Trace_Block_Marker (0x5F) is a required header,
-    //! it is not included here as it needs to be the last header printed
-    //! before the traces.
-    //! @param p_number_of_traces The total number of traces.
-    //! @param p_samples_per_trace The number of samples within each trace.
-    //! @param p_sample_length The length of a single sample in bytes.
-    void add_required_headers(const std::uint32_t p_number_of_traces,
-                              const std::uint32_t p_samples_per_trace,
-                              const std::uint8_t p_sample_length)
+    //! @brief Quantises floating point samples to signed integers when
+    //! saving, reducing the file size and time taken to write it. The scale
+    //! and offset are chosen so that the range of the traces fills the range
+    //! of the integers. They are recorded in Tag_Axis_Scale_Y and
+    //! Tag_Scope_Offset respectively, such that a sample is approximately
+    //! quantised sample * scale + offset.
+    //! @param p_sample_length The length of the integers in bytes. This must
+    //! be 1 or 2.
+    //! @exception std::domain_error If the samples are not floating point.
+    //! @exception std::range_error If the sample length is not 1 or 2.
+    //! @see Get_Quantisation_Error()
+    void Set_Quantisation(const std::uint8_t p_sample_length)
     {
-        validate_required_headers(
-            p_number_of_traces, p_samples_per_trace, p_sample_length);
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        set_quantisation(p_sample_length, true, 1, 0);
+    }
 
-        Add_Header(Tag_Number_Of_Traces, p_number_of_traces);
-        Add_Header(Tag_Number_Of_Samples_Per_Trace, p_samples_per_trace);
+    //! @brief Quantises floating point samples to signed integers when
+    //! saving, using the scale and offset given. These are recorded in
+    //! Tag_Axis_Scale_Y and Tag_Scope_Offset respectively, such that a sample
+    //! is approximately quantised sample * p_scale + p_offset. Samples beyond
+    //! the range of the integers are saturated.
+    //! @param p_sample_length The length of the integers in bytes. This must
+    //! be 1 or 2.
+    //! @param p_scale The value of one step of a quantised sample.
+    //! @param p_offset The value of a quantised sample of 0.
+    //! @exception std::domain_error If the samples are not floating point.
+    //! @exception std::range_error If the sample length is not 1 or 2, or
+    //! the scale is not positive.
+    //! @see Get_Quantisation_Error()
+    void Set_Quantisation(const std::uint8_t p_sample_length,
+                          const float p_scale,
+                          const float p_offset)
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        set_quantisation(p_sample_length, false, p_scale, p_offset);
+    }
 
-        // Calculate the sample coding.
-        // Bits 8-6 are reserved and must be '000'.
-        // Bit 5 corresponds to integer (0) or floating point (1).
-        // Bits 4-1 are the sample length in bytes. This must be 1,2 or 4.
-        const std::uint8_t sample_coding{[&p_sample_length]() -> std::uint8_t {
-            // If the traces are floating point values, set bit 5 to
-            // indicate
-            // this as per the Riscure inspector specification: Table K.2.
-            // Sample coding.
-            if constexpr (std::is_floating_point<T_Sample>::value)
-            {
-                return p_sample_length | 0b10000;
-            }
-            // If the traces are not floating point then the sample coding is
-            // simply the length of one sample.
-            return p_sample_length;
-        }()};
+    //! @brief Saves floating point samples as they are, without
+    //! quantisation.
+    void Clear_Quantisation()
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        m_quantised_sample_length = 0;
+    }
 
-        Add_Header(Tag_Sample_Coding, sample_coding);
+    //! @brief Retrieves the largest difference between a sample and the
+    //! value represented by its quantised sample in the last file saved.
+    //! Unless samples were saturated, this is at most half of the scale.
+    //! @returns The largest quantisation error.
+    double Get_Quantisation_Error() const { return m_quantisation_error; }
+};
+
+//! @class Fixed_Serialiser
+//! @brief Stores and saves traces whose number of samples and length of extra
+//! data are known at compile time, such as those from a production rig. As
+//! every trace is the same length by construction, adding and saving traces
+//! needs none of the validation or padding of Serialiser, and the encoding
+//! loops are compiled for the exact sizes.
+//! @code
+//! Traces_Serialiser::Fixed_Serialiser<std::uint8_t, 5000, 16> serialiser{};
+//! serialiser.Add_Trace(samples, plaintext);
+//! serialiser.Save("capture.trs");
+//! @endcode
+//! @tparam T_Sample The type of the samples.
+//! @tparam Samples The number of samples in every trace.
+//! @tparam Extra_Data_Length The number of bytes of extra data with every
+//! trace.
+//! @note Unlike Serialiser, the traces are not processed in any way and extra
+//! data is given as raw bytes rather than hexadecimal strings.
+template <typename T_Sample,
+          std::size_t Samples,
+          std::uint16_t Extra_Data_Length>
+class Fixed_Serialiser : public Headers
+{
+    static_assert(std::is_arithmetic<T_Sample>::value,
+                  "Samples must be an arithmetic type");
+    static_assert(1 == sizeof(T_Sample) || 2 == sizeof(T_Sample) ||
+                      4 == sizeof(T_Sample),
+                  "Sample length must be either 1, 2 or 4");
+    static_assert(0 < Samples &&
+                      Samples <= std::numeric_limits<std::uint32_t>::max(),
+                  "A TRS file must store between 1 and 4294967295 samples "
+                  "per trace");
+
+public:
+    //! @brief A single trace, as stored.
+    struct Trace
+    {
+        std::array<std::uint8_t, Extra_Data_Length> extra_data;
+        std::array<T_Sample, Samples> samples;
+    };
+
+    Fixed_Serialiser() : Headers{}, m_traces{} {}
+
+    //! @brief Appends a single trace.
+    //! @param p_samples The samples of the trace.
+    //! @param p_extra_data The raw bytes of extra data with this trace.
+    void Add_Trace(const std::array<T_Sample, Samples>& p_samples,
+                   const std::array<std::uint8_t, Extra_Data_Length>&
+                       p_extra_data = {})
+    {
+        m_traces.push_back(Trace{p_extra_data, p_samples});
     }
 
-    //! @brief Ensures that all of the required headers are valid. This does not
-    //! return anything as an exception will be thrown if the validation fails.
-    //! Checks that the sample length is 1, 2 or 4 bytes.
-    //! Checks that the headers indicating the various lengths and sizes are
-    //! correct by checking the amount of traces provided
-    //! @param p_number_of_traces The total number of traces.
-    //! @param p_samples_per_trace The number of samples within each trace.
-    //! @param p_sample_length The length of a single sample in bytes.
-    //! @exception std::range_error If the sample length is an invalid value
-    //! then this exception will be thrown.
-    //! @exception std::domain_error If the sizes and lengths do not match what
-    //! is in m_traces then this is thrown.
-    constexpr void
-    validate_required_headers(const std::uint32_t p_number_of_traces,
-                              const std::uint32_t p_samples_per_trace,
-                              const std::uint8_t p_sample_length)
+    //! @brief Reserves space for p_number_of_traces traces in total, so that
+    //! adding them does not reallocate.
+    //! @param p_number_of_traces The number of traces to reserve space for.
+    void Reserve(const std::size_t p_number_of_traces)
     {
-        if (4 < p_sample_length || 3 == p_sample_length)
+        m_traces.reserve(p_number_of_traces);
+    }
+
+    //! @brief Saves the headers and traces to the file at p_file_path.
+    //! @param p_file_path The path of the file to save to.
+    //! @param p_stats If given, this is filled in with the time taken by each
+    //! phase of saving and the amount written.
+    //! @exception std::range_error If there are more traces than fit into the
+    //! 32 bits the format stores them in.
+    //! @exception std::ios_base::failure If the file cannot be written.
+    void Save(const std::string& p_file_path,
+              Save_Stats* const p_stats = nullptr)
+    {
+        if (std::numeric_limits<std::uint32_t>::max() < m_traces.size())
         {
-            throw std::range_error("Sample length must be either 1, 2 or 4");
+            throw std::range_error(
+                "A TRS file cannot store more than 4294967295 traces. Split "
+                "the traces between multiple Serialisers and files.");
         }
 
-        if (p_number_of_traces * p_samples_per_trace !=
-            m_traces.size() * m_traces.front().size())
+        Save_Stats stats{};
+        const auto start{std::chrono::steady_clock::now()};
+
+        Add_Header(Tag_Number_Of_Traces,
+                   static_cast<std::uint32_t>(m_traces.size()));
+        Add_Header(Tag_Number_Of_Samples_Per_Trace,
+                   static_cast<std::uint32_t>(Samples));
+        Add_Header(Tag_Sample_Coding, sample_coding);
+        if constexpr (0 != Extra_Data_Length)
         {
-            throw std::domain_error(
-                "Invalid parameters given. Either the number of traces, number "
-                "of samples per trace or the sample length is incorrect.");
+            Set_Cryptographic_Data_Length(Extra_Data_Length);
+        }
+        const std::vector<char>& headers{m_headers.Render()};
+        auto phase_start{std::chrono::steady_clock::now()};
+        stats.header_encoding = phase_start - start;
+
+        std::ofstream output_file(p_file_path,
+                                  std::ios::out | std::ios::binary);
+
+        if (!output_file)
+        {
+            throw std::ios_base::failure("An error occurred when preparing "
+                                         "the file to be written to");
+        }
+        output_file.write(headers.data(),
+                          static_cast<std::streamsize>(headers.size()));
+
+        if constexpr (stored_as_saved)
+        {
+            // The traces are already exactly as they are saved.
+            output_file.write(
+                reinterpret_cast<const char*>(m_traces.data()),
+                static_cast<std::streamsize>(m_traces.size() * trace_size));
+        }
+        else
+        {
+            // The traces are encoded in blocks, each written at once.
+            constexpr std::size_t traces_per_block{
+                std::max<std::size_t>(1, (1 << 20) / trace_size)};
+            std::vector<char> bytes;
+            bytes.reserve(traces_per_block * trace_size);
+            for (std::size_t first{0}; first < m_traces.size();
+                 first += traces_per_block)
+            {
+                const std::size_t last{
+                    std::min(m_traces.size(), first + traces_per_block)};
+                bytes.clear();
+                for (std::size_t i{first}; i < last; ++i)
+                {
+                    const auto extra_data{reinterpret_cast<const char*>(
+                        m_traces[i].extra_data.data())};
+                    bytes.insert(std::end(bytes),
+                                 extra_data,
+                                 extra_data + Extra_Data_Length);
+                    Sample_Encoder::Encode(
+                        reinterpret_cast<const std::byte*>(
+                            m_traces[i].samples.data()),
+                        Samples,
+                        sizeof(T_Sample),
+                        bytes);
+                }
+                const auto encoded{std::chrono::steady_clock::now()};
+                stats.trace_encoding += encoded - phase_start;
+
+                output_file.write(bytes.data(),
+                                  static_cast<std::streamsize>(bytes.size()));
+                phase_start = std::chrono::steady_clock::now();
+                stats.io += phase_start - encoded;
+            }
+        }
+
+        output_file.close();
+        if (!output_file)
+        {
+            throw std::ios_base::failure("An error occurred when writing "
+                                         "the file");
+        }
+
+        const auto end{std::chrono::steady_clock::now()};
+        stats.io += end - phase_start;
+        stats.total           = end - start;
+        stats.bytes_written   = headers.size() + m_traces.size() * trace_size;
+        stats.traces_to_write = m_traces.size();
+        stats.traces_written  = m_traces.size();
+        const double seconds{
+            std::chrono::duration<double>(stats.total).count()};
+        stats.megabytes_per_second =
+            0 < seconds ? static_cast<double>(stats.bytes_written) / 1e6 /
+                              seconds
+                        : 0;
+        if (nullptr != p_stats)
+        {
+            *p_stats = stats;
         }
     }
 
-    //! @brief Checks if all of the extra data within p_extra_data of the
-    //! same length. This does not return anything as an exception will be
-    //! thrown if the validation fails.
-    //! @param p_extra_data The data to be checked
-    //! @exception std::domain_error If they are not all the same length
-    //! then this exception is thrown.
-    template <typename T_Traces>
-    static constexpr void
-    validate_extra_data_length(const std::vector<T_Traces>& p_extra_data)
+    //! @returns The number of traces added so far.
+    std::size_t Get_Number_Of_Traces() const { return m_traces.size(); }
+
+    //! @returns The traces added so far.
+    const std::vector<Trace>& Get_Traces() const { return m_traces; }
+
+private:
+    //! The size of a single trace, including its extra data, once saved.
+    constexpr static std::size_t trace_size{Extra_Data_Length +
+                                            Samples * sizeof(T_Sample)};
+
+    //! Bit 5 of the sample coding indicates floating point samples.
+    constexpr static std::uint8_t sample_coding{static_cast<std::uint8_t>(
+        std::is_floating_point<T_Sample>::value ? sizeof(T_Sample) | 0b10000
+                                                : sizeof(T_Sample))};
+
+    //! Whether m_traces can be written as it is. This is the case when
+    //! Trace has no padding.
+    constexpr static bool stored_as_saved{sizeof(Trace) == trace_size};
+
+    //! The traces, one after another.
+    std::vector<Trace> m_traces;
+};
+
+//! @class Header_Editor
+//! @brief Edits the headers of an existing TRS file without loading its
+//! traces. The headers are read when constructed, can be changed using the
+//! same functions as Serialiser and are written back by Save().
+//! @code
+//! Traces_Serialiser::Header_Editor editor{"capture.trs"};
+//! editor.Set_Trace_Title("Corrected title");
+//! editor.Save();
+//! @endcode
+//! @note The headers describing the layout of the traces (the number of
+//! traces, samples per trace, sample coding and length of cryptographic
+//! data) cannot be changed.
+class Header_Editor : public Headers
+{
+public:
+    //! @brief How Save() rewrote the file.
+    enum class Save_Method
     {
-        if (!check_all_same_length(p_extra_data))
+        //! The headers were the same size, so were overwritten in place.
+        In_Place,
+        //! The traces were moved within the file using fallocate().
+        Shifted,
+        //! The file was copied to a new file, which replaced it.
+        Copied
+    };
+
+    //! @brief Reads the headers of the TRS file at p_file_path.
+    //! @param p_file_path The path of the file to edit.
+    //! @exception std::ios_base::failure If the file cannot be opened or
+    //! does not start with valid headers.
+    explicit Header_Editor(const std::string& p_file_path)
+        : Headers{}, m_file_path{p_file_path}, m_data_offset{0}, m_layout{},
+          m_mutex{}
+    {
+        std::ifstream file{m_file_path, std::ios::in | std::ios::binary};
+        if (!file)
         {
-            throw std::domain_error("Extra data must all be the same length");
+            throw std::ios_base::failure("An error occurred when opening "
+                                         "the file to be edited");
         }
-    }
 
-    template <typename T>
-    static constexpr bool check_all_same_length(const std::vector<T>& p_data)
-    {
-        // If everything in p_data is not the same length
-        //
-        // Finds the first occurrence of two adjacent data points that don't
-        // have the same size. If this is the end of the vector then none were
-        // found and they are all the same size.
-        return std::adjacent_find(std::begin(p_data),
-                                  std::end(p_data),
-                                  [](const T& p_data_1, const T& p_data_2) {
-                                      // Check if these two are the same size.
-                                      return p_data_1.size() != p_data_2.size();
-                                  }) == std::end(p_data);
+        // Other tools may encode the headers differently, so the traces are
+        // found from what was read rather than from the headers rendered
+        // again.
+        m_data_offset = m_headers.Read(file);
+        m_layout = read_layout();
     }
 
-    //! @brief Ensures that setting the header given by the parameter p_tag
-    //! is allowed in the current context, based on which headers have
-    //! already been set.
-    //! @param p_tag The tag indicating which header is currently being set.
-    //! @exception std::range_error This does not return anything as an
-    //! exception will be thrown if the validation fails.
-    constexpr void validate_header(const std::uint8_t p_tag)
+    //! @brief Writes the headers back to the file. If their encoded size has
+    //! not changed then they are overwritten in place. Otherwise the traces
+    //! are moved using fallocate() where the file system supports it and the
+    //! change in size is a multiple of its block size, and if not the file
+    //! is copied.
+    //! @returns How the file was rewritten.
+    //! @exception std::domain_error If a header describing the layout of the
+    //! traces has been changed.
+    //! @exception std::ios_base::failure If writing to the file fails.
+    Save_Method Save()
     {
-        // Only allow external clock related values to be set if the
-        // external clock has been explicitly enabled.
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        validate_layout();
+        const std::vector<char>& headers{m_headers.Render()};
 
-        // If this is not an external clock related header then no
-        // validation is required.
-        if (!is_external_clock_header(p_tag))
+        Save_Method method{Save_Method::Copied};
+        if (headers.size() == m_data_offset)
         {
-            return;
+            write_headers(headers);
+            method = Save_Method::In_Place;
         }
-
-        // Tag_External_Clock_Used must be set before setting any other
-        // Tag_External_Clock_* headers
-        if (!header_enabled(Tag_External_Clock_Used))
+        else if (shift_traces(headers.size()))
         {
-            throw std::range_error("Enable external clock explicitly with "
-                                   "Set_External_Clock_Used()");
+            write_headers(headers);
+            method = Save_Method::Shifted;
+        }
+        else
+        {
+            copy_with_headers(headers);
         }
 
-        // Only allow external clock resampler mask to be set if the
-        // external clock has been explicitly enabled.
+        m_data_offset = headers.size();
+        return method;
+    }
 
-        // If this is not an external clock resampler mask related header
-        // then no further validation is required.
-        if (Tag_External_Clock_Resampler_Mask != p_tag)
+private:
+    //! The headers describing the layout of the traces.
+    constexpr static std::array<std::uint8_t, 4> layout_tags{
+        Tag_Number_Of_Traces,
+        Tag_Number_Of_Samples_Per_Trace,
+        Tag_Sample_Coding,
+        Tag_Length_Of_Cryptographic_Data};
+
+    //! @brief Reads the values of the headers in layout_tags. These are
+    //! little endian integers, however many bytes they are encoded in.
+    //! @returns The value of each header, or 0 for any that are not set.
+    std::array<std::uint64_t, layout_tags.size()> read_layout() const
+    {
+        std::array<std::uint64_t, layout_tags.size()> layout{};
+        for (std::size_t i{0}; i < layout_tags.size(); ++i)
         {
-            return;
+            if (m_headers.Contains(layout_tags[i]))
+            {
+                // Only little endian platforms are supported.
+                std::memcpy(&layout[i],
+                            m_headers.Value(layout_tags[i]),
+                            std::min(sizeof(std::uint64_t),
+                                     m_headers.Value_Size(layout_tags[i])));
+            }
         }
+        return layout;
+    }
 
-        // Tag_External_Clock_Resampler_Enabled must be set before setting
-        // Tag_External_Clock_Resampler_Mask
-        if (!header_enabled(Tag_External_Clock_Resampler_Enabled))
+    //! @brief Ensures that the headers describing the layout of the traces
+    //! have the same values as when the file was read, so that the traces
+    //! are still read correctly.
+    //! @exception std::domain_error If any of these headers have changed.
+    void validate_layout() const
+    {
+        if (read_layout() != m_layout)
         {
-            throw std::range_error(
-                "Enable external clock resampler explicitly with "
-                "Set_External_Clock_Resampler_Enabled()");
+            throw std::domain_error(
+                "The number of traces, samples per trace, sample coding and "
+                "length of cryptographic data cannot be changed");
         }
     }
 
-    //! @brief Determines whether or not the given boolean header has been
-    //! enabled or not.
-    //! @returns If the header has been set to a value other than 0, true is
-    //! return. If it is unset or set to 0 then false is returned.
-    //! @param p_tag The tag indicating which header to check.
-    //! @warning This was designed for headers with boolean values but it
-    //! can be used on any header which will usually give undesired results.
-    constexpr bool header_enabled(const std::uint8_t p_tag) const
+    //! @brief Overwrites the start of the file with p_headers.
+    void write_headers(const std::vector<char>& p_headers) const
     {
-        // If the header has not been set then it is not enabled
-        if (m_headers.end() == m_headers.find(p_tag))
+        std::fstream file{m_file_path,
+                          std::ios::in | std::ios::out | std::ios::binary};
+        file.write(p_headers.data(),
+                   static_cast<std::streamsize>(p_headers.size()));
+        file.close();
+        if (!file)
         {
-            return false;
+            throw std::ios_base::failure("An error occurred when writing the "
+                                         "headers");
         }
-
-        // If the header has been set to 0 then it is not enabled
-        return 0 != std::to_integer<bool>(m_headers.at(p_tag).second.front());
     }
 
-    //! @brief Determines whether or not the tag given by p_tag is related to
-    //! the external clock. All headers related to the external clock lie
-    //! between 0x61 (Tag_External_Clock_Threshold) and 0x67
-    //! (Tag_External_Clock_Time_Base) inclusive. Expect for
-    //! Tag_External_Clock_Used (0x60) which is considered an exception as
-    //! it enables this range of tags to be used.
-    //! @warning This will return false for 0x60 (Tag_External_Clock_Used)
-    //! :param p_tag The tag to be checked.
-    //! @returns True if p_tag is an external clock header and false if not.
-    constexpr static bool is_external_clock_header(const std::uint8_t p_tag)
+    //! @brief Moves the traces so that they start at p_size bytes, using
+    //! fallocate() to insert or remove space before them without copying.
+    //! @returns Whether the traces were moved. This is false if fallocate()
+    //! is unavailable, unsupported by the file system or the change in size
+    //! is not a multiple of the file system block size.
+    bool shift_traces(const std::size_t p_size) const
     {
-        return Tag_External_Clock_Threshold <= p_tag &&
-               Tag_External_Clock_Time_Base >= p_tag;
+#if defined(__linux__) && defined(FALLOC_FL_INSERT_RANGE) && \
+    defined(FALLOC_FL_COLLAPSE_RANGE)
+        const int file_descriptor{::open(m_file_path.c_str(), O_RDWR)};
+        if (-1 == file_descriptor)
+        {
+            return false;
+        }
+
+        struct stat status{};
+        bool shifted{false};
+        if (0 == ::fstat(file_descriptor, &status) && 0 < status.st_blksize)
+        {
+            const auto block_size{static_cast<std::size_t>(status.st_blksize)};
+            const std::size_t difference{p_size > m_data_offset
+                                             ? p_size - m_data_offset
+                                             : m_data_offset - p_size};
+
+            // The space is inserted at, or removed from, the start of the
+            // file. Both must be whole blocks.
+            if (0 == difference % block_size)
+            {
+                const int mode{p_size > m_data_offset
+                                   ? FALLOC_FL_INSERT_RANGE
+                                   : FALLOC_FL_COLLAPSE_RANGE};
+                shifted = 0 == ::fallocate(file_descriptor,
+                                           mode,
+                                           0,
+                                           static_cast<off_t>(difference));
+            }
+        }
+        ::close(file_descriptor);
+        return shifted;
+#else
+        static_cast<void>(p_size);
+        return false;
+#endif
     }
 
-    //! @todo: document
-    void save_headers(std::ofstream& m_output_file) const
+    //! @brief Writes p_headers followed by the traces to a new file, which
+    //! then replaces the original file.
+    void copy_with_headers(const std::vector<char>& p_headers) const
     {
-        // TODO: If all of the samples are smaller than the sample length
-        // then the sample length can be reduced, saving a lot of file size.
-
-        // Output each header
-        // // TODO: Split this into multiple functions
-        for (const auto& header : m_headers)
+        const std::string temporary_path{m_file_path + ".tmp"};
         {
-            // Output tag
-            m_output_file << header.first;
+            std::ifstream input{m_file_path, std::ios::in | std::ios::binary};
+            std::ofstream output{temporary_path,
+                                 std::ios::out | std::ios::binary};
+            if (!input || !output)
+            {
+                throw std::ios_base::failure("An error occurred when copying "
+                                             "the file");
+            }
 
-            // Output length
-            for (const auto& length_byte : header.second.first)
+            output.write(p_headers.data(),
+                         static_cast<std::streamsize>(p_headers.size()));
+
+            // Copy the traces in blocks, so that files larger than memory
+            // can be edited.
+            input.seekg(static_cast<std::streamoff>(m_data_offset));
+            std::vector<char> buffer(1 << 20);
+            while (input)
             {
-                m_output_file << std::to_integer<uint8_t>(length_byte);
+                input.read(buffer.data(),
+                           static_cast<std::streamsize>(buffer.size()));
+                output.write(buffer.data(), input.gcount());
             }
 
-            // Output value
-            for (const auto& value_byte : header.second.second)
+            output.close();
+            if (!output)
             {
-                m_output_file << std::to_integer<uint8_t>(value_byte);
+                std::remove(temporary_path.c_str());
+                throw std::ios_base::failure("An error occurred when copying "
+                                             "the file");
             }
         }
 
-        // The start of traces is marked by a Trace Block Marker tag.
-        m_output_file << Tag_Trace_Block_Marker;
+        if (0 != std::rename(temporary_path.c_str(), m_file_path.c_str()))
+        {
+            std::remove(temporary_path.c_str());
+            throw std::ios_base::failure("An error occurred when replacing "
+                                         "the file");
+        }
+    }
+
+    //! The file being edited.
+    std::string m_file_path;
+
+    //! The size of the headers, including the Trace Block Marker, as they
+    //! currently are in the file. The traces start here.
+    std::size_t m_data_offset;
 
-        // The length of the Trace Block Marker (always 0) is still
-        // required.
-        m_output_file.put(0x00);
+    //! The values of the headers in layout_tags when the file was read.
+    std::array<std::uint64_t, layout_tags.size()> m_layout;
+
+    //! Held by Save() and while a header is set, so that headers can be set
+    //! on one thread while another thread saves.
+    Copyable_Mutex m_mutex;
+
+    //! @brief Locks m_mutex while a header is set.
+    //! @returns The lock.
+    std::unique_lock<std::recursive_mutex> lock_headers() override
+    {
+        return std::unique_lock<std::recursive_mutex>{m_mutex};
     }
+};
 
-    bool is_extra_data_digits() const
+//! @class Stream_Writer
+//! @brief Writes traces to a TRS file as they are appended, rather than
+//! holding them all in memory until saved, so that any number of traces can
+//! be recorded in constant memory. Headers can be set using the same
+//! functions as Serialiser.
+//! @code
+//! Traces_Serialiser::Stream_Writer<std::uint8_t> writer{"capture.trs", 5000};
+//! writer.Set_Trace_Title("Capture");
+//! writer.Append(samples, number_of_traces * 5000);
+//! writer.Close();
+//! @endcode
+//! @note Unlike Serialiser, the traces are not processed in any way and extra
+//! data is given as raw bytes rather than hexadecimal strings.
+//! @tparam T_Sample The type of the samples.
+template <typename T_Sample> class Stream_Writer : public Headers
+{
+    static_assert(1 == sizeof(T_Sample) || 2 == sizeof(T_Sample) ||
+                      4 == sizeof(T_Sample),
+                  "Sample length must be either 1, 2 or 4");
+
+public:
+    //! @brief Creates the file at p_file_path, replacing any existing file.
+    //! @param p_file_path The path of the file to write to.
+    //! @param p_samples_per_trace The number of samples in every trace.
+    //! @param p_extra_data_length The number of bytes of extra data with
+    //! every trace.
+    //! @exception std::ios_base::failure If the file cannot be created.
+    //! @exception std::range_error If p_samples_per_trace does not fit into
+    //! the 32 bits the format stores it in.
+    Stream_Writer(const std::string& p_file_path,
+                  const std::size_t p_samples_per_trace,
+                  const std::uint16_t p_extra_data_length = 0)
+        : Headers{}, m_file{p_file_path, std::ios::out | std::ios::binary},
+          m_samples_per_trace{p_samples_per_trace},
+          m_extra_data_length{p_extra_data_length}, m_number_of_traces{0},
+          m_header_size{0}, m_bytes{}, m_mutex{}
     {
-        // Skip printing extra data if there is none. TODO: Is this even
-        // needed?
-        if (0 == m_extra_data.size())
+        if (!m_file)
         {
-            return false;
+            throw std::ios_base::failure("An error occurred when preparing "
+                                         "the file to be written to");
         }
 
-        // If this is completely numerical then output it as raw
-        // numbers, not ACSII.
-        return std::all_of(std::begin(m_extra_data),
-                           std::end(m_extra_data),
-                           [](const std::string& string) {
-                               return std::all_of(std::begin(string),
-                                                  std::end(string),
-                                                  ::isxdigit);
-                           });
-    }
+        if (std::numeric_limits<std::uint32_t>::max() < p_samples_per_trace)
+        {
+            throw std::range_error("A TRS file cannot store more than "
+                                   "4294967295 samples per trace");
+        }
 
-    //! @todo: document
-    void save_extra_data(std::ofstream& m_output_file,
-                         const std::size_t p_index,
-                         const bool m_is_digits) const
-    {
-        // Skip printing extra data if there is none. TODO: Is this even
-        // needed?
-        if (0 == m_extra_data.size())
+        // Bit 5 of the sample coding indicates floating point samples.
+        const std::uint8_t sample_coding{static_cast<std::uint8_t>(
+            std::is_floating_point<T_Sample>::value ? sizeof(T_Sample) | 0b10000
+                                                    : sizeof(T_Sample))};
+
+        Add_Header(Tag_Number_Of_Samples_Per_Trace,
+                   static_cast<std::uint32_t>(p_samples_per_trace));
+        Add_Header(Tag_Sample_Coding, sample_coding);
+        if (0 != p_extra_data_length)
         {
-            return;
+            Set_Cryptographic_Data_Length(p_extra_data_length);
         }
+        set_number_of_traces();
+    }
 
-        // If this is completely numerical then output it as raw
-        // numbers, not ACSII.
-        if (m_is_digits)
+    Stream_Writer(const Stream_Writer&) = delete;
+    Stream_Writer& operator=(const Stream_Writer&) = delete;
+
+    //! @brief Closes the file, if not already closed. Any error is ignored,
+    //! so Close() should be called to find out whether the file was written
+    //! successfully.
+    ~Stream_Writer()
+    {
+        try
         {
-            // Increment by 2 at a time as 2 characters fit into a byte.
-            for (std::size_t i{0}, size{m_extra_data[p_index].length() - 1};
-                 i < size;
-                 i += 2)
-            {
-                // Get two characters from the string as 2 character make up
-                // 1 byte. Convert them to a number using std::stoi() and
-                // then convert the result to a byte using
-                // convert_to_bytes(). As convert_to_bytes() returns a
-                // vector but in this case it will only contain one byte,
-                // .front() is used to retrieve it from the vector. This is
-                // then converted to a std::uint8_t to allow the << operator
-                // to stream the result.
-                m_output_file << std::to_integer<std::uint8_t>(
-                    convert_to_bytes(
-                        std::stoi(m_extra_data[p_index].substr(i, 2).c_str(),
-                                  nullptr,
-                                  16))
-                        .front());
-            }
+            Close();
         }
-        else
+        catch (...)
         {
-            for (const auto& character : m_extra_data[p_index])
-            {
-                m_output_file << character;
-            }
         }
     }
 
-    //! @todo: document
-    void save_trace(std::ofstream& m_output_file,
-                    const std::size_t p_index) const
+    //! @brief Writes one or more traces to the end of the file. The headers
+    //! are written before the first trace, so should be set before then.
+    //! @param p_samples The samples of each trace, one trace after another.
+    //! @param p_number_of_samples The total number of samples. This must be
+    //! a multiple of the number of samples per trace.
+    //! @param p_extra_data The extra data of each trace, one after another.
+    //! @param p_extra_data_size The total number of bytes of extra data.
+    //! @exception std::domain_error If the samples or extra data are not a
+    //! whole number of traces, or the writer has been closed.
+    //! @exception std::range_error If the number of traces would not fit
+    //! into the 32 bits the format stores it in.
+    //! @exception std::ios_base::failure If writing to the file fails.
+    void Append(const T_Sample* const p_samples,
+                const std::size_t p_number_of_samples,
+                const std::uint8_t* const p_extra_data = nullptr,
+                const std::size_t p_extra_data_size = 0)
     {
-        for (const auto& sample :
-             convert_traces_to_bytes(m_traces[p_index], m_sample_length))
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        if (!m_file.is_open())
         {
-            m_output_file << std::to_integer<std::uint8_t>(sample);
+            throw std::domain_error("Traces cannot be appended once the "
+                                    "writer has been closed");
         }
-    }
 
-public:
-    // These variables are intended to improve readability and nothing more.
-    // Public so user can write code like this:
-    // Add_Header(Tag_Number_Of_Traces, 4);
-    // clang-format off
-    constexpr static std::uint8_t Tag_Number_Of_Traces                 {0x41};
-    constexpr static std::uint8_t Tag_Number_Of_Samples_Per_Trace      {0x42};
-    constexpr static std::uint8_t Tag_Sample_Coding                    {0x43};
-    constexpr static std::uint8_t Tag_Length_Of_Cryptographic_Data     {0x44};
-    constexpr static std::uint8_t Tag_Title_Space_Per_Trace            {0x45};
-    constexpr static std::uint8_t Tag_Trace_Title                      {0x46};
-    constexpr static std::uint8_t Tag_Description                      {0x47};
-    constexpr static std::uint8_t Tag_Axis_Offset_X                    {0x48};
-    constexpr static std::uint8_t Tag_Axis_Label_X                     {0x49};
-    constexpr static std::uint8_t Tag_Axis_Label_Y                     {0x4A};
-    constexpr static std::uint8_t Tag_Axis_Scale_X                     {0x4B};
-    constexpr static std::uint8_t Tag_Axis_Scale_Y                     {0x4C};
-    constexpr static std::uint8_t Tag_Trace_Offset                     {0x4D};
-    constexpr static std::uint8_t Tag_Logarithmic_Scale                {0x4E};
-    // 0x4F - 0x54 Reserved for future use.
-    constexpr static std::uint8_t Tag_Scope_Range                      {0x55};
-    constexpr static std::uint8_t Tag_Scope_Coupling                   {0x56};
-    constexpr static std::uint8_t Tag_Scope_Offset                     {0x57};
-    constexpr static std::uint8_t Tag_Scope_Input_Impedance            {0x58};
-    constexpr static std::uint8_t Tag_Scope_ID                         {0x59};
-    constexpr static std::uint8_t Tag_Filter_Type                      {0x5A};
-    constexpr static std::uint8_t Tag_Filter_Frequency                 {0x5B};
-    constexpr static std::uint8_t Tag_Filter_Range                     {0x5C};
-    // 0x5D - 0x5E Undocumented.
-    constexpr static std::uint8_t Tag_Trace_Block_Marker               {0x5F};
-    constexpr static std::uint8_t Tag_External_Clock_Used              {0x60};
-    constexpr static std::uint8_t Tag_External_Clock_Threshold         {0x61};
-    constexpr static std::uint8_t Tag_External_Clock_Multiplier        {0x62};
-    constexpr static std::uint8_t Tag_External_Clock_Phase_Shift       {0x63};
-    constexpr static std::uint8_t Tag_External_Clock_Resampler_Mask    {0x64};
-    constexpr static std::uint8_t Tag_External_Clock_Resampler_Enabled {0x65};
-    constexpr static std::uint8_t Tag_External_Clock_Frequency         {0x66};
-    constexpr static std::uint8_t Tag_External_Clock_Time_Base         {0x67};
-    // clang-format on
+        const std::size_t number_of_traces{
+            0 == m_samples_per_trace ? 0
+                                     : p_number_of_samples / m_samples_per_trace};
+        if (number_of_traces * m_samples_per_trace != p_number_of_samples ||
+            number_of_traces * m_extra_data_length != p_extra_data_size)
+        {
+            throw std::domain_error(
+                "Every trace must have " + std::to_string(m_samples_per_trace) +
+                " samples and " + std::to_string(m_extra_data_length) +
+                " bytes of extra data");
+        }
 
-    //! @brief Constructs the Serialiser object and adds all of the
-    //! mandatory data. Optional headers can be set later. All traces are
-    //! required to be passed to the constructor.
-    //! @param p_traces All of the traces stored as 2D vector. This is
-    //! interpreted as a vector of traces with each trace being a vector of
-    //! samples.
-    //! @param p_sample_length The length of a trace sample in bytes. This
-    //! can optionally be specified. If not specified then it is assumed to
-    //! be the size of the data type samples are stored as, given by
-    //! T_Sample.
-    // TODO: Add support for cryptographic data to be included in each
-    // trace.
-    Serialiser(const std::vector<std::vector<T_Sample>>& p_traces,
-               const std::uint8_t p_sample_length = sizeof(T_Sample))
-        : Serialiser{{}, p_traces, p_sample_length}
-    {
-    }
+        if (std::numeric_limits<std::uint32_t>::max() - m_number_of_traces <
+            number_of_traces)
+        {
+            throw std::range_error(
+                "A TRS file cannot store more than 4294967295 traces. Split "
+                "the traces between multiple files.");
+        }
 
-    //! @todo Document
-    //! @todo Does p_sample_length ever need to be specified manually? It
-    //! certainly does not for 2d constructors.
-    Serialiser(const std::vector<std::string>& p_extra_data,
-               const std::vector<std::vector<T_Sample>>& p_traces,
-               const std::uint8_t p_sample_length = sizeof(T_Sample))
-        : m_headers{}, m_number_of_traces{p_traces.size()},
-          // Number of samples per trace can be assumed to be the length of
-          // one trace.
-          m_samples_per_trace{p_traces.front().size()},
-          m_sample_length{p_sample_length},
-          // Set longest trace length to 0 for now. It will be changed later
-          m_longest_trace_length{0}, m_extra_data{p_extra_data}, m_traces{
-                                                                     p_traces}
-    {
-    }
+        if (0 == m_header_size)
+        {
+            const std::vector<char>& headers{m_headers.Render()};
+            m_header_size = headers.size();
+            m_file.write(headers.data(),
+                         static_cast<std::streamsize>(headers.size()));
+        }
 
-    //! @todo Document
-    explicit Serialiser(const std::uint8_t p_sample_length = sizeof(T_Sample))
-        : Serialiser{{{}}, p_sample_length}
+        // The traces are encoded together so that they are written at once.
+        m_bytes.clear();
+        m_bytes.reserve(p_extra_data_size +
+                        p_number_of_samples * sizeof(T_Sample));
+        for (std::size_t i{0}; i < number_of_traces; ++i)
+        {
+            const auto extra_data{reinterpret_cast<const char*>(p_extra_data) +
+                                  i * m_extra_data_length};
+            m_bytes.insert(std::end(m_bytes),
+                           extra_data,
+                           extra_data + m_extra_data_length);
+            Sample_Encoder::Encode(
+                reinterpret_cast<const std::byte*>(p_samples +
+                                                   i * m_samples_per_trace),
+                m_samples_per_trace,
+                sizeof(T_Sample),
+                m_bytes);
+        }
+
+        m_file.write(m_bytes.data(),
+                     static_cast<std::streamsize>(m_bytes.size()));
+        if (!m_file)
+        {
+            throw std::ios_base::failure("An error occurred when writing "
+                                         "the traces");
+        }
+        m_number_of_traces += number_of_traces;
+    }
+
+    //! @brief Writes a single trace to the end of the file.
+    //! @param p_trace The trace to be written.
+    //! @param p_extra_data The raw bytes of extra data with this trace.
+    //! @see Append(const T_Sample*, std::size_t, const std::uint8_t*,
+    //! std::size_t)
+    void Append(const std::vector<T_Sample>& p_trace,
+                const std::string& p_extra_data = std::string{})
     {
+        Append(p_trace.data(),
+               p_trace.size(),
+               reinterpret_cast<const std::uint8_t*>(p_extra_data.data()),
+               p_extra_data.size());
     }
 
-    //! @brief This appends a single trace to the end of the list of traces.
-    //! Extra data associated with this trace can also be added using
-    //! p_extra_data. This will also validate the length of this data and
-    //! can throw exceptions if this is of the incorrect length.
-    //! @param p_trace The trace to be added.
-    //! @param p_extra_data The extra data with this trace to be added.
-    void Add_Trace(const std::vector<T_Sample>& p_trace,
-                   const std::string& p_extra_data = std::string{})
+    //! @brief Fills in the number of traces and closes the file. Headers
+    //! changed since the first trace was appended are also written, provided
+    //! that their size has not changed. This does nothing if already closed.
+    //! @exception std::domain_error If the size of the headers has changed.
+    //! @exception std::ios_base::failure If writing to the file fails.
+    void Close()
     {
-        // If this is the first trace provided then m_samples_per_trace needs to
-        // be set.
-        // m_traces can contain 0 as the first element as a side effect of
-        // initialisation.
-        if (m_traces.front().empty())
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
+        if (!m_file.is_open())
         {
-            m_samples_per_trace = p_trace.size();
-            // If this was an empty trace set, m_traces can contain 0 as the
-            // first element.
-            m_traces[0] = p_trace;
-
-            // Reset m_number_of_traces as this is the first element. This will
-            // be incremented shortly.
-            m_number_of_traces = 0;
+            return;
         }
-        else
+
+        set_number_of_traces();
+        const std::vector<char>& headers{m_headers.Render()};
+        if (0 != m_header_size && headers.size() != m_header_size)
         {
-            m_traces.emplace_back(p_trace);
+            m_file.close();
+            throw std::domain_error("Headers cannot change size once traces "
+                                    "have been appended");
         }
 
-        if (!p_extra_data.empty())
+        m_file.seekp(0);
+        m_file.write(headers.data(),
+                     static_cast<std::streamsize>(headers.size()));
+        m_file.close();
+        if (!m_file)
         {
-            m_extra_data.emplace_back(p_extra_data);
+            throw std::ios_base::failure("An error occurred when writing "
+                                         "the headers");
         }
-
-        // TODO: Does this need to be stored?
-        m_number_of_traces++;
     }
 
-    //! @brief This is this function that adds headers to the list of
-    //! headers to be saved. This is called by all other functions that add
-    //! headers as it is the only place headers are added.
-    //! @param p_tag The tag representing which header is currently being
-    //! set.
-    //! @param p_data The data that should be assigned to the header given
-    //! by p_tag.
-    //! @note This is public to allow user to add new headers that may not
-    //! have functions
-    template <typename T_Data>
-    void Add_Header(const std::uint8_t& p_tag, const T_Data& p_data)
+    //! @returns The number of traces appended so far.
+    std::size_t Get_Number_Of_Traces() const { return m_number_of_traces; }
+
+private:
+    //! @brief Sets Tag_Number_Of_Traces to m_number_of_traces. This is always
+    //! stored in 4 bytes, so that the headers do not change size as traces
+    //! are appended.
+    void set_number_of_traces()
     {
-        // TODO: Handle case where bit 8 (msb) is set to '0' in object
-        // length. See inspector manual for details.
+        const auto number_of_traces{
+            static_cast<std::uint32_t>(m_number_of_traces)};
+        std::array<std::byte, sizeof(number_of_traces)> value{};
+        std::memcpy(value.data(), &number_of_traces, value.size());
+        m_headers.Set(Tag_Number_Of_Traces, value.data(), value.size());
+    }
 
-        validate_header(p_tag);
+    //! The file being written to.
+    std::ofstream m_file;
+
+    //! The number of samples in every trace.
+    std::size_t m_samples_per_trace;
+
+    //! The number of bytes of extra data with every trace.
+    std::uint16_t m_extra_data_length;
+
+    //! The number of traces appended so far.
+    std::size_t m_number_of_traces;
+
+    //! The size of the headers once written, or 0 if not yet written.
+    std::size_t m_header_size;
+
+    //! Each batch of traces is encoded into this before being written.
+    std::vector<char> m_bytes;
 
-        // A temporary variable to convert p_data to bytes.
-        const std::vector<std::byte> value{convert_to_bytes(p_data)};
+    //! Held by Append(), Close() and while a header is set, so that headers
+    //! can be set on one thread while another thread writes.
+    std::recursive_mutex m_mutex;
 
-        std::vector<std::byte> length = convert_to_bytes(value.size());
+    //! @brief Locks m_mutex while a header is set.
+    //! @returns The lock.
+    std::unique_lock<std::recursive_mutex> lock_headers() override
+    {
+        return std::unique_lock<std::recursive_mutex>{m_mutex};
+    }
+};
 
-        // If the length doesn't fit into 7 bits then the 8th bit is set
-        // indicating that more than one byte is used to store the length
-        // and that the first byte is the length of the length.
-        if (0b01111111 < value.size())
+//! @class Raw_Serialiser
+//! @brief Stores traces given as raw bytes, with the type of their samples
+//! given at run time by a sample coding, and saves them to a TRS file. This
+//! suits sources whose sample type is only known at run time, such as a
+//! scope driver or a NumPy array, without a Serialiser for each type. Each
+//! trace is encoded once as it is added, so saving only writes them out.
+//! @code
+//! // 16 bit integer samples, as configured on the scope.
+//! Traces_Serialiser::Raw_Serialiser serialiser{0x02};
+//! serialiser.Add_Trace(buffer, buffer_size);
+//! serialiser.Save("capture.trs");
+//! @endcode
+//! @note Unlike Serialiser, the traces are not processed in any way, every
+//! trace must be the same length and extra data is given as raw bytes rather
+//! than hexadecimal strings.
+class Raw_Serialiser : public Headers
+{
+public:
+    //! @brief Creates an empty set of traces.
+    //! @param p_sample_coding The sample coding, as stored in
+    //! Tag_Sample_Coding. Bits 4-1 are the sample length in bytes, which must
+    //! be 1, 2 or 4, and bit 5 is set for floating point samples.
+    //! @exception std::range_error If p_sample_coding is invalid.
+    explicit Raw_Serialiser(const std::uint8_t p_sample_coding)
+        : Headers{}, m_sample_coding{p_sample_coding}, m_samples_per_trace{0},
+          m_extra_data_length{0}, m_number_of_traces{0}, m_traces{},
+          m_mutex{}
+    {
+        const std::size_t sample_length{Get_Sample_Length()};
+        if (0 != (0b11100000 & p_sample_coding) ||
+            (1 != sample_length && 2 != sample_length && 4 != sample_length))
         {
-            // TODO: If the length is longer than 65025 bytes (65KB) then
-            // the resulting file will be incorrect. Does this need to be
-            // accounted for?
-            length.insert(length.begin(),
-                          std::byte(0b10000000 | length.size()));
+            throw std::range_error("Sample length must be either 1, 2 or 4");
         }
-
-        // Add it to the map of headers.
-        m_headers[p_tag] = std::make_pair(length, value);
     }
 
-    //! @brief This saves the current state of the headers, along with the
-    //! traces to a file specified by p_file_path.
-    //! @param p_file_path The path of the file to save to.
-    //! @note If the path contains a directory that doesn't exist, it will
-    //! not be created, instead an error file be thrown. New files will be
-    //! created however.
-    //! @exception std::ios_base::failure Throws an exception if creating
-    //! the output stream fails for any reason. For example, directory
-    //! doesn't exist.
-    void Save(const std::string& p_file_path)
+    //! @brief Appends a single trace. The first trace added sets the length
+    //! of every trace and of its extra data.
+    //! @param p_samples The bytes of the samples, in native byte order.
+    //! @param p_size The size of the samples in bytes.
+    //! @param p_extra_data The raw bytes of extra data with this trace.
+    //! @param p_extra_data_size The number of bytes of extra data.
+    //! @exception std::domain_error If the trace or its extra data is not
+    //! the same length as the first trace.
+    //! @exception std::range_error If there would be more traces or samples
+    //! than fit into the 32 bits the format stores them in.
+    void Add_Trace(const void* const p_samples,
+                   const std::size_t p_size,
+                   const std::uint8_t* const p_extra_data = nullptr,
+                   const std::size_t p_extra_data_size = 0)
     {
-        std::ofstream output_file(p_file_path,
-                                  std::ios::out | std::ios::binary);
+        Add_Traces(p_samples, 1, p_size, p_extra_data, p_extra_data_size);
+    }
 
-        if (!output_file)
+    //! @brief Appends traces stored contiguously, one after another.
+    //! @param p_samples The bytes of the samples, in native byte order.
+    //! @param p_number_of_traces The number of traces.
+    //! @param p_trace_size The size of the samples of each trace in bytes.
+    //! @param p_extra_data The raw bytes of extra data with each trace, one
+    //! after another.
+    //! @param p_extra_data_size The total number of bytes of extra data.
+    //! @exception std::domain_error If the traces or their extra data are not
+    //! the same length as the first trace.
+    //! @exception std::range_error If there would be more traces or samples
+    //! than fit into the 32 bits the format stores them in.
+    void Add_Traces(const void* const p_samples,
+                    const std::size_t p_number_of_traces,
+                    const std::size_t p_trace_size,
+                    const std::uint8_t* const p_extra_data = nullptr,
+                    const std::size_t p_extra_data_size = 0)
+    {
+        if (0 == p_number_of_traces)
         {
-            throw std::ios_base::failure("An error occurred when preparing "
-                                         "the file to be written to");
+            return;
         }
 
-        // TRS files require all traces to be of the same length.
-        pad_all_traces();
-
-        bool is_digits{false};
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
 
-        // Set this header to match the data that is stored.
-        //! @todo this will override any user set value. Maybe make this a
-        //! private function as a solution?
-        if (m_extra_data.size() > 0)  // Don't do this if not extra data is
-                                      // supplied, it will cause a Segfault.
+        const std::size_t sample_length{Get_Sample_Length()};
+        const std::size_t extra_data_length{p_extra_data_size /
+                                            p_number_of_traces};
+        if (0 != p_trace_size % sample_length ||
+            extra_data_length * p_number_of_traces != p_extra_data_size)
         {
-            Set_Cryptographic_Data_Length(m_extra_data.front().size());
-            is_digits = is_extra_data_digits();
+            throw std::domain_error("Traces must be whole samples with the "
+                                    "same amount of extra data each");
+        }
 
-            if (is_digits)
+        if (0 == m_number_of_traces)
+        {
+            constexpr std::size_t max_count{
+                std::numeric_limits<std::uint32_t>::max()};
+            if (max_count < p_trace_size / sample_length)
+            {
+                throw std::range_error("A TRS file cannot store more than "
+                                       "4294967295 samples per trace");
+            }
+            if (std::numeric_limits<std::uint16_t>::max() < extra_data_length)
             {
-                // Digits take up half the space of ASCII.
-                // So retrieve the current value, half it and save it back.
-                Add_Header(Tag_Length_Of_Cryptographic_Data,
-                           std::to_integer<std::uint8_t>(
-                               m_headers[Tag_Length_Of_Cryptographic_Data]
-                                   .second.front()) /
-                               2);
+                throw std::range_error("The extra data of each trace must be "
+                                       "no more than 65535 bytes");
             }
+            m_samples_per_trace = p_trace_size / sample_length;
+            m_extra_data_length = extra_data_length;
+        }
+        else if (m_samples_per_trace * sample_length != p_trace_size ||
+                 m_extra_data_length != extra_data_length)
+        {
+            throw std::domain_error("Every trace and its extra data must be "
+                                    "the same length as the first trace");
         }
 
-        // Ensure information stored will create a valid trs file.
-        //! @todo Group all THREE validation functions in a valid function.
-        validate_extra_data_length(m_extra_data);
+        if (std::numeric_limits<std::uint32_t>::max() - m_number_of_traces <
+            p_number_of_traces)
+        {
+            throw std::range_error(
+                "A TRS file cannot store more than 4294967295 traces. Split "
+                "the traces between multiple Serialisers and files.");
+        }
 
-        // This has to be done after changing the length of cryptographic
-        // data as it is dependant on that information.
-        add_required_headers(
-            m_number_of_traces, m_samples_per_trace, m_sample_length);
+        const auto samples{static_cast<const std::byte*>(p_samples)};
+        const auto extra_data{reinterpret_cast<const char*>(p_extra_data)};
+        m_traces.reserve(m_traces.size() +
+                         p_number_of_traces *
+                             (m_extra_data_length + p_trace_size));
+        for (std::size_t i{0}; i < p_number_of_traces; ++i)
+        {
+            m_traces.insert(std::end(m_traces),
+                            extra_data + i * m_extra_data_length,
+                            extra_data + (i + 1) * m_extra_data_length);
+            Sample_Encoder::Encode(samples + i * p_trace_size,
+                                   m_samples_per_trace,
+                                   sample_length,
+                                   m_traces);
+        }
+        m_number_of_traces += p_number_of_traces;
+    }
 
-        save_headers(output_file);
+    //! @brief Saves the headers and traces to the file at p_file_path.
+    //! @param p_file_path The path of the file to save to.
+    //! @param p_stats If given, this is filled in with the time taken by each
+    //! phase of saving and the amount written.
+    //! @note Traces can be added from other threads while this runs. They
+    //! wait until the save has finished and so are not included in the file.
+    //! @exception std::ios_base::failure If the file cannot be written.
+    void Save(const std::string& p_file_path,
+              Save_Stats* const p_stats = nullptr)
+    {
+        const std::lock_guard<std::recursive_mutex> lock{m_mutex};
 
-        // For each trace
+        Save_Stats stats{};
+        const auto start{std::chrono::steady_clock::now()};
+
+        Add_Header(Tag_Number_Of_Traces,
+                   static_cast<std::uint32_t>(m_number_of_traces));
+        Add_Header(Tag_Number_Of_Samples_Per_Trace,
+                   static_cast<std::uint32_t>(m_samples_per_trace));
+        Add_Header(Tag_Sample_Coding, m_sample_coding);
+        if (0 != m_extra_data_length)
         {
-            const std::size_t size{m_traces.size()};
-            for (std::size_t i{0}; i < size; ++i)
-            {
-                save_extra_data(output_file, i, is_digits);
-                save_trace(output_file, i);
-            }
+            Set_Cryptographic_Data_Length(
+                static_cast<std::uint16_t>(m_extra_data_length));
         }
+        const std::vector<char>& headers{m_headers.Render()};
+        const auto encoded{std::chrono::steady_clock::now()};
+        stats.header_encoding = encoded - start;
 
+        std::ofstream output_file(p_file_path,
+                                  std::ios::out | std::ios::binary);
+        output_file.write(headers.data(),
+                          static_cast<std::streamsize>(headers.size()));
+        output_file.write(m_traces.data(),
+                          static_cast<std::streamsize>(m_traces.size()));
         output_file.close();
+        if (!output_file)
+        {
+            throw std::ios_base::failure("An error occurred when writing "
+                                         "the file");
+        }
+
+        stats.io              = std::chrono::steady_clock::now() - encoded;
+        stats.total           = stats.header_encoding + stats.io;
+        stats.bytes_written   = headers.size() + m_traces.size();
+        stats.traces_to_write = m_number_of_traces;
+        stats.traces_written  = m_number_of_traces;
+        const double seconds{
+            std::chrono::duration<double>(stats.total).count()};
+        stats.megabytes_per_second =
+            0 < seconds ? static_cast<double>(stats.bytes_written) / 1e6 /
+                              seconds
+                        : 0;
+        if (nullptr != p_stats)
+        {
+            *p_stats = stats;
+        }
     }
 
-    // Beyond this point there are only functions designed to simplify the
-    // usage of the Add_Header function.
-    // The default parameters in the following functions are copied from the
-    // Riscure inspector documentation.
+    //! @returns The number of traces added so far.
+    std::size_t Get_Number_Of_Traces() const { return m_number_of_traces; }
 
-    // TODO: Rename
-    // https://wandbox.org/permlink/TiG2k4xzQUojzfdO
-    void Set_Cryptographic_Data_Length(const std::uint16_t p_length = 0)
-    {
-        Add_Header(Tag_Length_Of_Cryptographic_Data, p_length);
-    }
+    //! @returns The number of samples in each trace, or 0 if no traces have
+    //! been added.
+    std::size_t Get_Samples_Per_Trace() const { return m_samples_per_trace; }
 
-    // TODO: Implement this.
-    void Set_Title_Space_Per_Trace(const std::uint8_t p_length = 0)
-    {
-        Add_Header(Tag_Title_Space_Per_Trace, p_length);
-    }
+    //! @returns The sample coding given when constructed.
+    std::uint8_t Get_Sample_Coding() const { return m_sample_coding; }
 
-    void Set_Trace_Title(const std::string& p_title = "trace")
-    {
-        Add_Header(Tag_Trace_Title, p_title);
-    }
+    //! @returns The length of a single sample in bytes.
+    std::size_t Get_Sample_Length() const { return 0b1111 & m_sample_coding; }
 
-    void Set_Trace_Description(const std::string& p_description)
-    {
-        Add_Header(Tag_Description, p_description);
-    }
+    //! @returns Whether the samples are floating point.
+    bool Is_Floating_Point() const { return 0 != (0b10000 & m_sample_coding); }
 
-    void Set_Axis_Offset_X(const std::uint32_t p_offset = 0)
-    {
-        Add_Header(Tag_Axis_Offset_X, p_offset);
-    }
+private:
+    //! The sample coding of every trace.
+    std::uint8_t m_sample_coding;
 
-    void Set_Axis_Label_X(const std::string& p_label)
-    {
-        Add_Header(Tag_Axis_Label_X, p_label);
-    }
+    //! The number of samples in each trace.
+    std::size_t m_samples_per_trace;
 
-    void Set_Axis_Label_Y(const std::string& p_label)
-    {
-        Add_Header(Tag_Axis_Label_Y, p_label);
-    }
+    //! The number of bytes of extra data with each trace.
+    std::size_t m_extra_data_length;
 
-    void Set_Axis_Scale_X(const float p_scale = 1)
-    {
-        Add_Header(Tag_Axis_Scale_X, p_scale);
-    }
+    //! The number of traces added so far.
+    std::size_t m_number_of_traces;
 
-    void Set_Axis_Scale_Y(const float p_scale = 1)
-    {
-        Add_Header(Tag_Axis_Scale_Y, p_scale);
-    }
+    //! The encoded traces, each preceded by its extra data, ready to be
+    //! saved.
+    std::vector<char> m_traces;
 
-    void Set_Trace_Offset(const std::uint32_t p_offset = 0)
+    //! Held by Save(), Add_Traces() and while a header is set, so that
+    //! traces can be added and headers set on one thread while another
+    //! thread saves. Save() sets headers itself, so this is recursive.
+    std::recursive_mutex m_mutex;
+
+    //! @brief Locks m_mutex while a header is set.
+    //! @returns The lock.
+    std::unique_lock<std::recursive_mutex> lock_headers() override
     {
-        Add_Header(Tag_Trace_Offset, p_offset);
+        return std::unique_lock<std::recursive_mutex>{m_mutex};
     }
+};
 
-    // TODO: Calling this with a float argument works. Validate to ensure
-    // that this does not work.
-    void Set_Logarithmic_Scale(const std::uint8_t p_scale = 0)
+//! @class Reader
+//! @brief Reads the headers of a TRS file and describes where its traces are,
+//! without loading them. The traces can then be read in blocks with
+//! Read_Traces(), or memory mapped.
+//! @code
+//! const Traces_Serialiser::Reader reader{"capture.trs"};
+//! std::vector<char> trace(reader.Get_Trace_Size());
+//! reader.Read_Traces(0, 1, trace.data(), trace.size());
+//! @endcode
+class Reader
+{
+public:
+    //! @brief Reads the headers of the TRS file at p_file_path.
+    //! @param p_file_path The path of the file to read.
+    //! @exception std::ios_base::failure If the file cannot be opened, its
+    //! headers are invalid or it is too short to hold the traces they
+    //! describe.
+    explicit Reader(const std::string& p_file_path)
+        : m_file_path{p_file_path}, m_headers{}, m_data_offset{0},
+          m_number_of_traces{0}, m_samples_per_trace{0}, m_sample_coding{0},
+          m_extra_data_length{0}
     {
-        Add_Header(Tag_Logarithmic_Scale, p_scale);
-    }
+        std::ifstream file{m_file_path, std::ios::in | std::ios::binary};
+        if (!file)
+        {
+            throw std::ios_base::failure("An error occurred when opening "
+                                         "the file to be read");
+        }
 
-    // 0x4F - 0x54 Reserved for future use.
+        m_data_offset = m_headers.Read(file);
 
-    void Set_Scope_Range(const float p_range = 0)
-    {
-        Add_Header(Tag_Scope_Range, p_range);
-    }
+        if (!m_headers.Contains(Headers::Tag_Number_Of_Traces) ||
+            !m_headers.Contains(Headers::Tag_Number_Of_Samples_Per_Trace) ||
+            !m_headers.Contains(Headers::Tag_Sample_Coding))
+        {
+            throw std::ios_base::failure("The file is missing the number of "
+                                         "traces, samples per trace or "
+                                         "sample coding");
+        }
+        m_number_of_traces  = read_integer(Headers::Tag_Number_Of_Traces);
+        m_samples_per_trace =
+            read_integer(Headers::Tag_Number_Of_Samples_Per_Trace);
+        m_sample_coding =
+            static_cast<std::uint8_t>(read_integer(Headers::Tag_Sample_Coding));
+        m_extra_data_length =
+            read_integer(Headers::Tag_Length_Of_Cryptographic_Data);
 
-    void Set_Scope_Coupling(const std::uint32_t p_coupling = 0)
-    {
-        Add_Header(Tag_Scope_Coupling, p_coupling);
-    }
+        // Bits 8-6 are reserved and the sample length must be 1, 2 or 4.
+        const std::size_t sample_length{Get_Sample_Length()};
+        if (0 != (0b11100000 & m_sample_coding) ||
+            (1 != sample_length && 2 != sample_length && 4 != sample_length))
+        {
+            throw std::ios_base::failure("The sample coding of the file is "
+                                         "not supported");
+        }
 
-    void Set_Scope_Offset(const float p_offset = 0)
-    {
-        Add_Header(Tag_Scope_Offset, p_offset);
+        file.seekg(0, std::ios::end);
+        const auto file_size{static_cast<std::uint64_t>(file.tellg())};
+        if (file_size - m_data_offset <
+            static_cast<std::uint64_t>(m_number_of_traces) * Get_Trace_Size())
+        {
+            throw std::ios_base::failure("The file is shorter than its "
+                                         "headers describe");
+        }
     }
 
-    void Set_Scope_Input_Impedance(const float p_impedance = 0)
-    {
-        Add_Header(Tag_Scope_Input_Impedance, p_impedance);
-    }
+    //! @returns The number of traces in the file.
+    std::size_t Get_Number_Of_Traces() const { return m_number_of_traces; }
 
-    // TODO: Should this be a string?
-    void Set_Scope_ID(const std::string& p_id)
-    {
-        Add_Header(Tag_Scope_ID, p_id);
-    }
+    //! @returns The number of samples in each trace.
+    std::size_t Get_Samples_Per_Trace() const { return m_samples_per_trace; }
 
-    void Set_Filter_Type(const std::uint32_t p_type = 0)
-    {
-        Add_Header(Tag_Filter_Type, p_type);
-    }
+    //! @returns The sample coding, as stored in Tag_Sample_Coding.
+    std::uint8_t Get_Sample_Coding() const { return m_sample_coding; }
 
-    void Set_Filter_Frequency(const float p_frequency = 0)
-    {
-        Add_Header(Tag_Filter_Frequency, p_frequency);
-    }
+    //! @returns The length of a single sample in bytes.
+    std::size_t Get_Sample_Length() const { return 0b1111 & m_sample_coding; }
 
-    void Set_Filter_Range(const float p_range = 0)
-    {
-        Add_Header(Tag_Filter_Range, p_range);
-    }
+    //! @returns Whether the samples are floating point.
+    bool Is_Floating_Point() const { return 0 != (0b10000 & m_sample_coding); }
 
-    // 0x5D - 0x5E Undocumented
-    // 0x5F Marks header end
+    //! @returns The number of bytes of extra data with each trace.
+    std::size_t Get_Extra_Data_Length() const { return m_extra_data_length; }
 
-    void Set_External_Clock_Used(const bool p_used = true)
-    {
-        Add_Header(Tag_External_Clock_Used, p_used);
-    }
+    //! @returns The offset of the first trace from the start of the file.
+    std::size_t Get_Data_Offset() const { return m_data_offset; }
 
-    void Set_External_Clock_Threshold(const float p_threshold = 0)
+    //! @returns The size of a single trace, including its extra data, in
+    //! bytes.
+    std::size_t Get_Trace_Size() const
     {
-        Add_Header(Tag_External_Clock_Threshold, p_threshold);
+        return m_extra_data_length + m_samples_per_trace * Get_Sample_Length();
     }
 
-    void Set_External_Clock_Multiplier(const std::uint32_t p_multiplier = 0)
+    //! @param p_tag The tag of the header.
+    //! @returns Whether the file has the header given by p_tag.
+    bool Has_Header(const std::uint8_t p_tag) const
     {
-        Add_Header(Tag_External_Clock_Multiplier, p_multiplier);
+        return m_headers.Contains(p_tag);
     }
 
-    void Set_External_Clock_Phase_Shift(const std::uint32_t p_phase_shift = 0)
+    //! @param p_tag The tag of the header.
+    //! @returns The raw bytes of the header given by p_tag, or an empty
+    //! string if the file does not have this header.
+    std::string Get_Header(const std::uint8_t p_tag) const
     {
-        Add_Header(Tag_External_Clock_Phase_Shift, p_phase_shift);
+        const auto value{reinterpret_cast<const char*>(m_headers.Value(p_tag))};
+        return std::string(value, value + m_headers.Value_Size(p_tag));
     }
 
-    void
-    Set_External_Clock_Resampler_Mask(const std::uint32_t p_resampler_mask = 0)
+    //! @brief Reads p_number_of_traces traces, each including its extra data,
+    //! starting at p_first_trace into p_buffer.
+    //! @param p_first_trace The index of the first trace to read.
+    //! @param p_number_of_traces The number of traces to read.
+    //! @param p_buffer The buffer to read the traces into.
+    //! @param p_buffer_size The size of p_buffer in bytes. This must be
+    //! exactly p_number_of_traces * Get_Trace_Size().
+    //! @exception std::range_error If the traces are not all in the file.
+    //! @exception std::length_error If p_buffer_size is not the size of the
+    //! traces.
+    //! @exception std::ios_base::failure If reading the file fails.
+    void Read_Traces(const std::size_t p_first_trace,
+                     const std::size_t p_number_of_traces,
+                     char* const p_buffer,
+                     const std::size_t p_buffer_size) const
     {
-        Add_Header(Tag_External_Clock_Resampler_Mask, p_resampler_mask);
-    }
+        if (p_first_trace > m_number_of_traces ||
+            p_number_of_traces > m_number_of_traces - p_first_trace)
+        {
+            throw std::range_error("The file only has " +
+                                   std::to_string(m_number_of_traces) +
+                                   " traces");
+        }
+        if (p_number_of_traces * Get_Trace_Size() != p_buffer_size)
+        {
+            throw std::length_error("The buffer must be the size of the "
+                                    "traces being read");
+        }
 
-    void
-    Set_External_Clock_Resampler_Enabled(const bool p_resampler_enabled = true)
-    {
-        Add_Header(Tag_External_Clock_Resampler_Enabled, p_resampler_enabled);
+        std::ifstream file{m_file_path, std::ios::in | std::ios::binary};
+        file.seekg(static_cast<std::streamoff>(
+            m_data_offset + p_first_trace * Get_Trace_Size()));
+        file.read(p_buffer, static_cast<std::streamsize>(p_buffer_size));
+        if (!file)
+        {
+            throw std::ios_base::failure("An error occurred when reading "
+                                         "the traces");
+        }
     }
 
-    void Set_External_Clock_Frequency(const float p_frequency = 0)
+private:
+    //! @brief Reads the little endian integer header given by p_tag.
+    //! @returns The value of the header, or 0 if the file does not have it.
+    //! @exception std::ios_base::failure If the value is more than 4 bytes.
+    std::uint32_t read_integer(const std::uint8_t p_tag) const
     {
-        Add_Header(Tag_External_Clock_Frequency, p_frequency);
-    }
+        const std::size_t size{m_headers.Value_Size(p_tag)};
+        if (sizeof(std::uint32_t) < size)
+        {
+            throw std::ios_base::failure("An integer header of the file is "
+                                         "more than 4 bytes long");
+        }
 
-    // TODO: All int headers are unsigned, Change them to signed?
-    void Set_External_Clock_Time_Base(const std::uint32_t p_time_base = 0)
-    {
-        Add_Header(Tag_External_Clock_Time_Base, p_time_base);
+        // Only little endian platforms are supported.
+        std::uint32_t value{0};
+        std::memcpy(&value, m_headers.Value(p_tag), size);
+        return value;
     }
+
+    //! The file being read.
+    std::string m_file_path;
+
+    //! The headers of the file.
+    Header_Table m_headers;
+
+    //! The offset of the first trace from the start of the file.
+    std::size_t m_data_offset;
+
+    //! The number of traces in the file.
+    std::size_t m_number_of_traces;
+
+    //! The number of samples in each trace.
+    std::size_t m_samples_per_trace;
+
+    //! The sample coding of the file.
+    std::uint8_t m_sample_coding;
+
+    //! The number of bytes of extra data with each trace.
+    std::size_t m_extra_data_length;
 };
+
+// When linking against the compiled library these are instantiated once
+// within it, rather than in every translation unit that uses them.
+#ifdef TRACES_SERIALISER_EXTERN_TEMPLATES
+extern template class Serialiser<std::uint8_t>;
+extern template class Serialiser<std::uint16_t>;
+extern template class Serialiser<std::uint32_t>;
+extern template class Serialiser<float>;
+extern template class Stream_Writer<std::uint8_t>;
+extern template class Stream_Writer<std::uint16_t>;
+extern template class Stream_Writer<std::uint32_t>;
+extern template class Stream_Writer<float>;
+#endif  // TRACES_SERIALISER_EXTERN_TEMPLATES
 }  // namespace Traces_Serialiser
 #endif  // SRC_TRACES_SERIALISER_HPP
@@ -0,0 +1,58 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Traces_Serialiser_Fwd.hpp
+ *  @brief Declares the classes of Traces_Serialiser without defining them.
+ *  Headers that only refer to a Serialiser by pointer or reference can
+ *  include this rather than Traces_Serialiser.hpp, which is far larger.
+ *  @author Scott Egerton
+ *  @date 2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#ifndef SRC_TRACES_SERIALISER_FWD_HPP
+#define SRC_TRACES_SERIALISER_FWD_HPP
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint16_t
+
+namespace Traces_Serialiser
+{
+struct Save_Stats;
+class Latency_Histogram;
+class Metrics;
+class Metrics_Dumper;
+class Header_Table;
+template <std::size_t Capacity, std::size_t Max_Headers = 32>
+class Static_Headers;
+class Sample_Encoder;
+class Spill_File;
+class Thread_Pool;
+class Huge_Page_Arena;
+class Headers;
+template <typename T_Sample = float> class Serialiser;
+template <typename T_Sample,
+          std::size_t Samples,
+          std::uint16_t Extra_Data_Length = 0>
+class Fixed_Serialiser;
+class Header_Editor;
+template <typename T_Sample = float> class Stream_Writer;
+class Raw_Serialiser;
+class Reader;
+}  // namespace Traces_Serialiser
+#endif  // SRC_TRACES_SERIALISER_FWD_HPP
@@ -24,8 +24,11 @@
  *  @copyright GNU Affero General Public License Version 3+
  */
 
+#include <array>    // for array
+#include <cmath>    // for NAN
 #include <cstdint>  // for uint8_t, uint16_t, uint32_t
 #include <cstring>  // for memcmp
+#include <thread>   // for thread
 
 #include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
 
@@ -180,4 +183,217 @@ TEST_CASE("Adding traces extra"
         REQUIRE(std::string(std::begin(expected_result),
                             std::end(expected_result)) == actual_result);
     }
+
+    SECTION("Adding contiguous traces")
+    {
+        // Two traces stored one after another, as in a 2D array.
+        const std::uint16_t samples[]{0x0102, 0x0304, 0x0506, 0x0708};
+        Traces_Serialiser::Serialiser<std::uint16_t> serialiser{samples, 1, 2};
+        REQUIRE_NOTHROW(serialiser.Add_Trace(samples + 2, 2));
+        serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result{load_file(file_path)};
+
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x02,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x02,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x02,  // Start of trace 1
+            0x01,
+            0x04,
+            0x03,
+            0x06,  // Start of trace 2
+            0x05,
+            0x08,
+            0x07};
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string(std::begin(expected_result),
+                            std::end(expected_result)) == actual_result);
+    }
+
+    SECTION("Adding contiguous traces with extra data")
+    {
+        const std::uint8_t samples[]{1, 2, 3, 4, 5, 6};
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        REQUIRE_THROWS_AS(serialiser.Add_Traces(samples, 2, 3, {"ab"}),
+                          std::range_error);
+        REQUIRE_NOTHROW(serialiser.Add_Traces(samples, 2, 3, {"ab", "cd"}));
+        serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result{load_file(file_path)};
+
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x44,  // Cryptographic data Length
+            0x01,  // Length
+            0x01,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0xab,  // Start of trace 1 extra data
+            0x01,  // Start of trace 1
+            0x02,
+            0x03,
+            0xcd,  // Start of trace 2 extra data
+            0x04,  // Start of trace 2
+            0x05,
+            0x06};
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string(std::begin(expected_result),
+                            std::end(expected_result)) == actual_result);
+    }
+
+    SECTION("Adding traces while saving")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        const std::vector<std::uint8_t> trace(1000, 1);
+        for (std::size_t i{0}; i < 1000; ++i)
+        {
+            serialiser.Add_Trace(trace);
+        }
+
+        // Each trace is either in the file saved on the other thread, or
+        // waits for that save to finish.
+        std::thread saving{[&serialiser] { serialiser.Save(file_path); }};
+        for (std::size_t i{0}; i < 1000; ++i)
+        {
+            serialiser.Add_Trace(trace);
+        }
+        saving.join();
+
+        serialiser.Save(file_path);
+        REQUIRE(2000 == serialiser.Get_Metrics().Get_Traces_Ingested());
+
+        // 13 bytes of headers, followed by every trace.
+        REQUIRE(13 + 2000 * 1000 == load_file(file_path).size());
+    }
+
+    SECTION("Changing settings and headers while saving")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        const std::vector<std::uint8_t> trace(1000, 1);
+        for (std::size_t i{0}; i < 1000; ++i)
+        {
+            serialiser.Add_Trace(trace);
+        }
+
+        // Each change waits for the save on the other thread to finish.
+        std::thread saving{[&serialiser] { serialiser.Save(file_path); }};
+        for (std::size_t i{0}; i < 100; ++i)
+        {
+            serialiser.Set_Repeat_Averaging(0);
+            serialiser.Set_Sync_On_Save(false);
+            serialiser.Clear_Filter();
+            serialiser.Set_Trace_Title("Title");
+        }
+        saving.join();
+
+        // 13 bytes of headers, the 7 byte title, followed by every trace.
+        serialiser.Save(file_path);
+        REQUIRE(13 + 7 + 1000 * 1000 == load_file(file_path).size());
+    }
+
+    SECTION("Adding traces of other types")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+
+        // Samples of the same type are copied as they are.
+        REQUIRE_NOTHROW(
+            serialiser.Add_Trace(std::array<std::uint8_t, 4>{1, 2, 3, 4}));
+
+        // Out of range samples are saturated.
+        REQUIRE_NOTHROW(
+            serialiser.Add_Trace(std::vector<int>{-5, 100, 255, 300}));
+
+        // Floating point samples are rounded to the nearest integer.
+        const double samples[]{1.4, 2.6, -1.0, NAN};
+        REQUIRE_NOTHROW(serialiser.Add_Trace(samples));
+        serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result{load_file(file_path)};
+
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x03,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x04,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x01,  // Start of trace 1
+            0x02,
+            0x03,
+            0x04,
+            0x00,  // Start of trace 2
+            0x64,
+            0xff,
+            0xff,
+            0x01,  // Start of trace 3
+            0x03,
+            0x00,
+            0x00};
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string(std::begin(expected_result),
+                            std::end(expected_result)) == actual_result);
+    }
+
+    SECTION("Adding integer traces to floating point traces")
+    {
+        Traces_Serialiser::Serialiser<float> serialiser{};
+        REQUIRE_NOTHROW(
+            serialiser.Add_Trace(std::array<std::int16_t, 2>{-2, 3}));
+        REQUIRE_NOTHROW(serialiser.Add_Trace(std::vector<double>{1e300, 0.5}));
+        serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result{load_file(file_path)};
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x02,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x14,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x00, 0x00, 0x00, 0xc0,  // Start of trace 1 (-2.0)
+            0x00, 0x00, 0x40, 0x40,  // 3.0
+            0xff, 0xff, 0x7f, 0x7f,  // Start of trace 2 (saturated to max)
+            0x00, 0x00, 0x00, 0x3f}; // 0.5
+        // clang-format on
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string(std::begin(expected_result),
+                            std::end(expected_result)) == actual_result);
+    }
 }
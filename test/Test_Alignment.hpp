@@ -0,0 +1,156 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Test_Alignment.hpp
+ *  @brief Contains the tests for aligning traces as they are added.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>  // for uint8_t
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser
+
+TEST_CASE("Aligning traces"
+          "[!throws][traces][alignment]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    SECTION("Traces are shifted to the reference and the shift recorded")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        serialiser.Set_Alignment({1, 9, 1}, 2, 2);
+
+        serialiser.Add_Trace({0, 0, 0, 1, 9, 1, 0}, "ab");
+        serialiser.Add_Trace({1, 9, 1, 0, 0, 0, 0}, "cd");
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x07,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x44,  // Cryptographic data Length
+            0x01,  // Length
+            0x05,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0xab,  // Start of trace 1 extra data
+            0x00,  // Shift of +1
+            0x00,
+            0x00,
+            0x01,
+            0x00,  // Start of trace 1
+            0x00,
+            0x01,
+            0x09,
+            0x01,
+            0x00,
+            0x00,  // Filled in
+            0xcd,  // Start of trace 2 extra data
+            0xff,  // Shift of -2
+            0xff,
+            0xff,
+            0xfe,
+            0x00,  // Start of trace 2 (Filled in)
+            0x00,
+            0x01,
+            0x09,
+            0x01,
+            0x00,
+            0x00};
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+        REQUIRE(0 == serialiser.Get_Rejected_Trace_Count());
+    }
+
+    SECTION("Traces below the threshold are rejected")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        serialiser.Set_Alignment({1, 9, 1}, 2, 2, 0.9, false);
+
+        serialiser.Add_Trace({0, 0, 0, 1, 9, 1, 0});
+        serialiser.Add_Trace({5, 5, 5, 5, 5, 5, 5});
+        serialiser.Add_Trace({1, 2});
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x01,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x07,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x00,  // Start of trace 1
+            0x00,
+            0x01,
+            0x09,
+            0x01,
+            0x00,
+            0x00};
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+        REQUIRE(2 == serialiser.Get_Rejected_Trace_Count());
+    }
+
+    SECTION("Empty reference")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        REQUIRE_THROWS_AS(serialiser.Set_Alignment({}, 0, 0),
+                          std::domain_error);
+    }
+
+    SECTION("Constant reference")
+    {
+        // Traces would be aligned against a pattern of 0 after removing its
+        // mean, which does not correlate with anything.
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        REQUIRE_THROWS_AS(serialiser.Set_Alignment({5, 5, 5}, 0, 0),
+                          std::domain_error);
+
+        // Alignment is still disabled, so the trace is stored unchanged.
+        serialiser.Add_Trace({1, 2, 3});
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+        REQUIRE("\x01\x02\x03" ==
+                actual_result.substr(actual_result.size() - 3));
+        REQUIRE(0 == serialiser.Get_Rejected_Trace_Count());
+    }
+}
@@ -0,0 +1,164 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Test_Averaging.hpp
+ *  @brief Contains the tests for averaging repeated acquisitions as they are
+ *  added.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>  // for uint8_t
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser
+
+TEST_CASE("Averaging repeated acquisitions"
+          "[!throws][traces][averaging]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    SECTION("Repeats are averaged into a single trace")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        serialiser.Set_Repeat_Averaging(4);
+
+        REQUIRE_NOTHROW(serialiser.Add_Trace({1, 2, 3}));
+        REQUIRE_NOTHROW(serialiser.Add_Trace({3, 4, 5}));
+        REQUIRE_NOTHROW(serialiser.Add_Trace({1, 2, 3}));
+        REQUIRE_NOTHROW(serialiser.Add_Trace({3, 4, 6}));
+        REQUIRE_NOTHROW(serialiser.Add_Trace({7, 8, 9}));
+        serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result{load_file(file_path)};
+
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x02,  // Start of trace 1 (average of the first 4)
+            0x03,
+            0x04,  // 4.25 rounds down
+            0x07,  // Start of trace 2 (the pending fifth trace)
+            0x08,
+            0x09};
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+    }
+
+    SECTION("Changing extra data ends a group of repeats")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        serialiser.Set_Repeat_Averaging(16);
+
+        serialiser.Add_Trace({1, 2, 3}, "ab");
+        serialiser.Add_Trace({2, 3, 4}, "ab");
+        serialiser.Add_Trace({4, 5, 6}, "cd");
+        serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result{load_file(file_path)};
+
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x44,  // Cryptographic data Length
+            0x01,  // Length
+            0x01,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0xab,  // Start of trace 1 extra data
+            0x02,  // Start of trace 1 (1.5, 2.5, 3.5 round up)
+            0x03,
+            0x04,
+            0xcd,  // Start of trace 2 extra data
+            0x04,  // Start of trace 2
+            0x05,
+            0x06};
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+    }
+
+    SECTION("Float repeats are averaged")
+    {
+        Traces_Serialiser::Serialiser<float> serialiser{};
+        serialiser.Set_Repeat_Averaging(2);
+
+        serialiser.Add_Trace({1.0f, 2.0f});
+        serialiser.Add_Trace({2.0f, 4.0f});
+        serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result{load_file(file_path)};
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x01,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x02,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x14,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x00, 0x00, 0xc0, 0x3f,  // Start of trace 1 (1.5)
+            0x00, 0x00, 0x40, 0x40}; // 3.0
+        // clang-format on
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+    }
+
+    SECTION("Repeats of different lengths")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        serialiser.Set_Repeat_Averaging(4);
+
+        serialiser.Add_Trace({1, 2, 3});
+        REQUIRE_THROWS_WITH(
+            serialiser.Add_Trace({1, 2}),
+            Catch::Contains(
+                "Repeated acquisitions must all be the same length"));
+    }
+}
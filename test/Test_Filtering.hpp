@@ -0,0 +1,215 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Test_Filtering.hpp
+ *  @brief Contains the tests for filtering traces as they are added.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cmath>    // for abs
+#include <cstdint>  // for uint8_t
+#include <cstring>  // for memcpy
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser
+
+TEST_CASE("Filtering traces"
+          "[!throws][traces][filtering]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    // The headers written when a trace of 201 samples is low pass filtered at
+    // 1 kHz.
+    // clang-format off
+    const std::vector<std::uint8_t> expected_headers{
+        0x41,  // Number of traces
+        0x01,  // Length
+        0x01,  // Value
+        0x42,  // Number of Samples per Trace
+        0x01,  // Length
+        0xc9,  // Value
+        0x43,  // Sample Coding
+        0x01,  // Length
+        0x01,  // Value
+        0x5a,  // Filter type
+        0x01,  // Length
+        0x01,  // Value (Low pass)
+        0x5b,  // Filter frequency
+        0x04,  // Length
+        0x00, 0x00, 0x7a, 0x44,  // Value (1000.0f)
+        0x5c,  // Filter range
+        0x04,  // Length
+        0x00, 0x00, 0x00, 0x00,  // Value (0.0f)
+        0x5f,  // Trace Block Marker
+        0x00}; // Length (Always 0)
+    // clang-format on
+
+    SECTION("FIR low pass filter passes DC")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        serialiser.Set_Low_Pass_Filter(1000, 10000);
+
+        serialiser.Add_Trace(std::vector<std::uint8_t>(201, 100));
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        REQUIRE(expected_headers.size() + 201 == actual_result.size());
+        REQUIRE(std::string{std::begin(expected_headers),
+                            std::end(expected_headers)} ==
+                actual_result.substr(0, expected_headers.size()));
+
+        // Away from the edges the filter has unity gain at DC.
+        REQUIRE(100 == static_cast<std::uint8_t>(
+                           actual_result[expected_headers.size() + 100]));
+
+        // At the edges the samples beyond the trace are treated as 0.
+        REQUIRE(100 > static_cast<std::uint8_t>(
+                          actual_result[expected_headers.size()]));
+    }
+
+    SECTION("IIR low pass filter passes DC")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        serialiser.Set_Low_Pass_Filter(
+            1000,
+            10000,
+            Traces_Serialiser::Serialiser<std::uint8_t>::Filter_Design::IIR);
+
+        serialiser.Add_Trace(std::vector<std::uint8_t>(201, 100));
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        REQUIRE(std::string{std::begin(expected_headers),
+                            std::end(expected_headers)} ==
+                actual_result.substr(0, expected_headers.size()));
+
+        // The filter has settled by the end of the trace.
+        REQUIRE(100 == static_cast<std::uint8_t>(actual_result.back()));
+    }
+
+    SECTION("Band pass filter removes DC")
+    {
+        Traces_Serialiser::Serialiser<float> serialiser{};
+        serialiser.Set_Band_Pass_Filter(1000, 2000, 10000);
+
+        serialiser.Add_Trace(std::vector<float>(201, 100.0f));
+        serialiser.Add_Trace(std::vector<float>(201, 50.0f));
+
+        REQUIRE_NOTHROW(serialiser.Save(file_path));
+
+        const std::string actual_result{load_file(file_path)};
+
+        // Second trace, middle sample.
+        float sample{};
+        std::memcpy(&sample,
+                    actual_result.data() + actual_result.size() - 4 * 101,
+                    sizeof(sample));
+        REQUIRE(0.01f > std::abs(sample));
+    }
+
+    SECTION("Clearing the filter")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        serialiser.Set_Low_Pass_Filter(1000, 10000);
+        serialiser.Clear_Filter();
+
+        serialiser.Add_Trace({1, 2, 3});
+        serialiser.Save(file_path);
+
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x01,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x01,  // Start of trace 1
+            0x02,
+            0x03};
+
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == load_file(file_path));
+    }
+
+    SECTION("Long traces are filtered on several threads")
+    {
+        // Long enough to be split into 4 blocks.
+        std::vector<float> trace(100000);
+        for (std::size_t i{0}; i < trace.size(); ++i)
+        {
+            trace[i] = static_cast<float>(i % 7);
+        }
+
+        Traces_Serialiser::Serialiser<float> expected{};
+        expected.Set_Threads(1);
+        expected.Set_Low_Pass_Filter(1000, 10000);
+        expected.Add_Trace(trace);
+        expected.Add_Trace(trace);
+        expected.Save(file_path);
+        const std::string expected_result{load_file(file_path)};
+
+        // The same threads are used for every trace.
+        Traces_Serialiser::Serialiser<float> serialiser{};
+        serialiser.Set_Threads(4);
+        serialiser.Set_Low_Pass_Filter(1000, 10000);
+        serialiser.Add_Trace(trace);
+        serialiser.Add_Trace(trace);
+        serialiser.Save(file_path);
+
+        REQUIRE(expected_result == load_file(file_path));
+    }
+
+    SECTION("Frequencies above Nyquist")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        REQUIRE_THROWS_AS(serialiser.Set_Low_Pass_Filter(6000, 10000),
+                          std::range_error);
+        REQUIRE_THROWS_AS(serialiser.Set_Band_Pass_Filter(2000, 1000, 10000),
+                          std::range_error);
+    }
+
+    SECTION("Too few taps")
+    {
+        using Serialiser = Traces_Serialiser::Serialiser<std::uint8_t>;
+        using Design     = Serialiser::Filter_Design;
+
+        Serialiser serialiser{};
+        REQUIRE_THROWS_AS(
+            serialiser.Set_Low_Pass_Filter(100, 1000, Design::FIR, 0),
+            std::range_error);
+        REQUIRE_THROWS_AS(
+            serialiser.Set_Band_Pass_Filter(100, 200, 1000, Design::FIR, 1),
+            std::range_error);
+
+        // IIR filters do not use the number of taps.
+        REQUIRE_NOTHROW(
+            serialiser.Set_Low_Pass_Filter(100, 1000, Design::IIR, 0));
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Test_Fixed_Serialiser.hpp
+ *  @brief Contains the tests for saving traces whose lengths are fixed at
+ *  compile time.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <array>    // for array
+#include <cstdint>  // for uint8_t, uint16_t
+#include <ios>      // for ios_base::failure
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Fixed_Serialiser, Serialiser
+
+TEST_CASE("Fixed length traces"
+          "[!throws][traces][fixed]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    SECTION("8 bit traces with extra data")
+    {
+        Traces_Serialiser::Fixed_Serialiser<std::uint8_t, 3, 2> serialiser{};
+        serialiser.Set_Trace_Title("A");
+
+        serialiser.Add_Trace({1, 2, 3}, {0xab, 0xcd});
+        serialiser.Add_Trace({4, 5, 6}, {0x01, 0x23});
+        REQUIRE(2 == serialiser.Get_Number_Of_Traces());
+        serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result{load_file(file_path)};
+
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x44,  // Cryptographic data Length
+            0x01,  // Length
+            0x02,  // Value
+            0x46,  // Trace Title
+            0x01,  // Length
+            0x41,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0xab,  // Start of trace 1 extra data
+            0xcd,
+            0x01,  // Start of trace 1
+            0x02,
+            0x03,
+            0x01,  // Start of trace 2 extra data
+            0x23,
+            0x04,  // Start of trace 2
+            0x05,
+            0x06};
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+    }
+
+    SECTION("Output is identical to Serialiser")
+    {
+        Traces_Serialiser::Fixed_Serialiser<std::uint16_t, 4, 1> fixed{};
+        Traces_Serialiser::Serialiser<std::uint16_t> serialiser{};
+
+        fixed.Add_Trace({0x0102, 0x0300, 0x0004, 0}, {0x7f});
+        serialiser.Add_Trace({0x0102, 0x0300, 0x0004, 0}, "7f");
+        fixed.Add_Trace({0xffff, 1, 2, 3}, {0x00});
+        serialiser.Add_Trace({0xffff, 1, 2, 3}, "00");
+
+        fixed.Save(file_path);
+        const std::string actual_result{load_file(file_path)};
+        serialiser.Save(file_path);
+        const std::string expected_result{load_file(file_path)};
+
+        REQUIRE(expected_result == actual_result);
+    }
+
+    SECTION("Float traces are written as they are stored")
+    {
+        Traces_Serialiser::Fixed_Serialiser<float, 2> fixed{};
+        Traces_Serialiser::Serialiser<float> serialiser{};
+
+        fixed.Reserve(2);
+        fixed.Add_Trace({1.5f, -2.0f});
+        serialiser.Add_Trace({1.5f, -2.0f});
+        fixed.Add_Trace({0.0f, 3.25f});
+        serialiser.Add_Trace({0.0f, 3.25f});
+
+        Traces_Serialiser::Save_Stats stats{};
+        fixed.Save(file_path, &stats);
+        const std::string actual_result{load_file(file_path)};
+        serialiser.Save(file_path);
+        const std::string expected_result{load_file(file_path)};
+
+        REQUIRE(expected_result == actual_result);
+        REQUIRE(actual_result.size() == stats.bytes_written);
+        REQUIRE(2 == stats.traces_written);
+    }
+
+    SECTION("Saving to a path that cannot be written to")
+    {
+        Traces_Serialiser::Fixed_Serialiser<std::uint8_t, 2> serialiser{};
+        serialiser.Add_Trace({1, 2});
+
+        REQUIRE_THROWS_AS(serialiser.Save("Missing_Directory/Test_Traces.trs"),
+                          std::ios_base::failure);
+        REQUIRE_THROWS_WITH(
+            serialiser.Save("Missing_Directory/Test_Traces.trs"),
+            Catch::Contains("preparing the file to be written to"));
+    }
+}
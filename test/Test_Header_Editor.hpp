@@ -0,0 +1,220 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*!
+ *  @file Test_Header_Editor.hpp
+ *  @brief Contains the tests for editing the headers of existing files.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>    // for uint8_t, uint32_t
+#include <fstream>    // for ofstream
+#include <ios>        // for ios_base::failure
+#include <stdexcept>  // for domain_error
+#include <string>     // for string
+#include <vector>     // for vector
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser, Header_Editor, Reader
+
+TEST_CASE("Editing the headers of existing files"
+          "[!throws][headers][editor]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+    serialiser.Add_Trace({1, 2, 3});
+    serialiser.Add_Trace({4, 5, 6});
+    serialiser.Set_Trace_Title("abc");
+    serialiser.Save(file_path);
+
+    SECTION("Headers of the same size are overwritten in place")
+    {
+        Traces_Serialiser::Header_Editor editor{file_path};
+        editor.Set_Trace_Title("xyz");
+        REQUIRE(Traces_Serialiser::Header_Editor::Save_Method::In_Place ==
+                editor.Save());
+
+        // The result is the same as if the file had been saved with the new
+        // title.
+        serialiser.Set_Trace_Title("xyz");
+        serialiser.Save("Test_Traces_Expected.trs");
+        REQUIRE(load_file("Test_Traces_Expected.trs") == load_file(file_path));
+        std::remove("Test_Traces_Expected.trs");
+    }
+
+    SECTION("Headers of a different size move the traces")
+    {
+        Traces_Serialiser::Header_Editor editor{file_path};
+        editor.Set_Trace_Title("longer");
+        editor.Set_Axis_Offset_X(0x1234);
+
+        // The change in size is not a whole block, so the file is copied.
+        REQUIRE(Traces_Serialiser::Header_Editor::Save_Method::Copied ==
+                editor.Save());
+
+        // Load the trs file into a string
+        const std::string actual_result{load_file(file_path)};
+
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x46,  // Trace Title
+            0x06,  // Length
+            'l',   // Value
+            'o',
+            'n',
+            'g',
+            'e',
+            'r',
+            0x48,  // Axis Offset X
+            0x02,  // Length
+            0x34,  // Value
+            0x12,
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x01,  // Start of trace 1
+            0x02,
+            0x03,
+            0x04,  // Start of trace 2
+            0x05,
+            0x06};
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+
+        // The edited file can be edited again.
+        Traces_Serialiser::Header_Editor second_editor{file_path};
+        second_editor.Set_Trace_Title("abc");
+        second_editor.Set_Axis_Offset_X(0);
+        REQUIRE(Traces_Serialiser::Header_Editor::Save_Method::Copied ==
+                second_editor.Save());
+        REQUIRE(actual_result.size() - 4 == load_file(file_path).size());
+    }
+
+    SECTION("Changing the layout of the traces")
+    {
+        Traces_Serialiser::Header_Editor editor{file_path};
+        editor.Add_Header(Traces_Serialiser::Headers::Tag_Number_Of_Traces,
+                          std::uint32_t{5});
+        REQUIRE_THROWS_AS(editor.Save(), std::domain_error);
+
+        Traces_Serialiser::Header_Editor crypto_editor{file_path};
+        crypto_editor.Set_Cryptographic_Data_Length(4);
+        REQUIRE_THROWS_AS(crypto_editor.Save(), std::domain_error);
+
+        // The file is unchanged.
+        Traces_Serialiser::Serialiser<std::uint8_t> expected{};
+        expected.Add_Trace({1, 2, 3});
+        expected.Add_Trace({4, 5, 6});
+        expected.Set_Trace_Title("abc");
+        expected.Save("Test_Traces_Expected.trs");
+        REQUIRE(load_file("Test_Traces_Expected.trs") == load_file(file_path));
+        std::remove("Test_Traces_Expected.trs");
+    }
+
+    SECTION("Headers encoded differently by other tools")
+    {
+        // clang-format off
+        const std::vector<std::uint8_t> original{
+            0x41,                    // Number of traces
+            0x04,                    // Length (more than is needed)
+            0x02, 0x00, 0x00, 0x00,  // Value
+            0x42,                    // Number of Samples per Trace
+            0x01,                    // Length
+            0x03,                    // Value
+            0x43,                    // Sample Coding
+            0x01,                    // Length
+            0x01,                    // Value
+            0x46,                    // Trace Title
+            0x81, 0x03,              // Length (long form where short would do)
+            'a', 'b', 'c',           // Value
+            0x5f,                    // Trace Block Marker
+            0x00,                    // Length (Always 0)
+            0x01, 0x02, 0x03,        // Start of trace 1
+            0x04, 0x05, 0x06};       // Start of trace 2
+        // clang-format on
+        {
+            std::ofstream file{file_path, std::ios::binary};
+            file.write(reinterpret_cast<const char*>(original.data()),
+                       static_cast<std::streamsize>(original.size()));
+        }
+
+        // The headers are shorter once rendered again, so the traces must be
+        // moved even though the title is the same size.
+        Traces_Serialiser::Header_Editor editor{file_path};
+        editor.Set_Trace_Title("xyz");
+        editor.Add_Header(Traces_Serialiser::Headers::Tag_Number_Of_Traces,
+                          std::uint32_t{2});
+        REQUIRE(Traces_Serialiser::Header_Editor::Save_Method::Copied ==
+                editor.Save());
+
+        const std::string actual_result{load_file(file_path)};
+        REQUIRE(original.size() - 4 == actual_result.size());
+
+        // The traces are unchanged.
+        REQUIRE("\x01\x02\x03\x04\x05\x06" ==
+                actual_result.substr(actual_result.size() - 6));
+        const Traces_Serialiser::Reader reader{file_path};
+        REQUIRE(actual_result.size() - 6 == reader.Get_Data_Offset());
+        REQUIRE("xyz" ==
+                reader.Get_Header(Traces_Serialiser::Headers::Tag_Trace_Title));
+    }
+
+    SECTION("Adding headers with tags before the layout headers")
+    {
+        Traces_Serialiser::Header_Editor editor{file_path};
+        editor.Add_Header(0x20, std::uint8_t{7});
+        REQUIRE_NOTHROW(editor.Save());
+
+        const Traces_Serialiser::Reader reader{file_path};
+        REQUIRE(2 == reader.Get_Number_Of_Traces());
+        REQUIRE(3 == reader.Get_Samples_Per_Trace());
+        REQUIRE("\x07" == reader.Get_Header(0x20));
+
+        std::vector<char> traces(2 * reader.Get_Trace_Size());
+        reader.Read_Traces(0, 2, traces.data(), traces.size());
+        REQUIRE("\x01\x02\x03\x04\x05\x06" ==
+                std::string(std::begin(traces), std::end(traces)));
+    }
+
+    SECTION("Editing a file that is not a trs file")
+    {
+        REQUIRE_THROWS_AS(
+            Traces_Serialiser::Header_Editor{"Test_Missing_File.trs"},
+            std::ios_base::failure);
+
+        {
+            std::ofstream file{file_path, std::ios::binary};
+            file << "\x41\x01";
+        }
+        REQUIRE_THROWS_AS(Traces_Serialiser::Header_Editor{file_path},
+                          std::ios_base::failure);
+    }
+}
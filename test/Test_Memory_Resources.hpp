@@ -0,0 +1,137 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Test_Memory_Resources.hpp
+ *  @brief Contains the tests for storing traces in a memory resource other
+ *  than the default.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstddef>          // for size_t
+#include <cstdint>          // for uint8_t, uint16_t
+#include <memory_resource>  // for memory_resource, new_delete_resource
+#include <string>           // for string
+#include <vector>           // for vector
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser, Huge_Page_Arena
+
+namespace
+{
+//! @brief Forwards every allocation to new and delete, counting the number of
+//! bytes currently allocated.
+class Counting_Resource : public std::pmr::memory_resource
+{
+public:
+    std::size_t bytes_in_use{0};
+
+private:
+    void* do_allocate(const std::size_t p_bytes,
+                      const std::size_t p_alignment) override
+    {
+        bytes_in_use += p_bytes;
+        return std::pmr::new_delete_resource()->allocate(p_bytes, p_alignment);
+    }
+
+    void do_deallocate(void* const p_pointer,
+                       const std::size_t p_bytes,
+                       const std::size_t p_alignment) override
+    {
+        bytes_in_use -= p_bytes;
+        std::pmr::new_delete_resource()->deallocate(
+            p_pointer, p_bytes, p_alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& p_other) const
+        noexcept override
+    {
+        return this == &p_other;
+    }
+};
+}  // namespace
+
+TEST_CASE("Storing traces in a memory resource"
+          "[!throws][traces][memory]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    // The same traces saved with the default memory resource.
+    Traces_Serialiser::Serialiser<std::uint16_t> expected{};
+    expected.Add_Trace({1, 2, 3}, "ab");
+    expected.Add_Trace({0x0400, 5}, "cd");
+    expected.Save(file_path);
+    const std::string expected_result{load_file(file_path)};
+
+    SECTION("Traces are allocated from the memory resource")
+    {
+        Counting_Resource resource{};
+        {
+            Traces_Serialiser::Serialiser<std::uint16_t> serialiser{
+                &resource};
+            serialiser.Add_Trace({1, 2, 3}, "ab");
+            REQUIRE(3 * sizeof(std::uint16_t) <= resource.bytes_in_use);
+
+            serialiser.Add_Trace({0x0400, 5}, "cd");
+            serialiser.Save(file_path);
+            REQUIRE(expected_result == load_file(file_path));
+        }
+        REQUIRE(0 == resource.bytes_in_use);
+    }
+
+    SECTION("Processed traces are copied into the memory resource")
+    {
+        Counting_Resource resource{};
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{&resource};
+        serialiser.Set_Repeat_Averaging(2);
+
+        serialiser.Add_Trace({1, 2, 3});
+        serialiser.Add_Trace({3, 4, 5});
+        const std::size_t bytes_in_use{resource.bytes_in_use};
+        serialiser.Add_Trace(std::vector<std::uint8_t>(1000, 7));
+        serialiser.Add_Trace(std::vector<std::uint8_t>(1000, 9));
+        REQUIRE(bytes_in_use + 1000 <= resource.bytes_in_use);
+    }
+
+    SECTION("Huge page arena")
+    {
+        Traces_Serialiser::Huge_Page_Arena arena{
+            Traces_Serialiser::Huge_Page_Arena::Huge_Page_Size, true};
+        REQUIRE(0 == arena.Get_Mapped_Size());
+
+        {
+            Traces_Serialiser::Serialiser<std::uint16_t> serialiser{&arena};
+            serialiser.Add_Trace({1, 2, 3}, "ab");
+            serialiser.Add_Trace({0x0400, 5}, "cd");
+            serialiser.Save(file_path);
+            REQUIRE(expected_result == load_file(file_path));
+            REQUIRE(Traces_Serialiser::Huge_Page_Arena::Huge_Page_Size ==
+                    arena.Get_Mapped_Size());
+
+            // Larger than the next block so one is mapped to fit it.
+            serialiser.Add_Trace(std::vector<std::uint16_t>(1 << 21));
+            REQUIRE(Traces_Serialiser::Huge_Page_Arena::Huge_Page_Size * 3 <=
+                    arena.Get_Mapped_Size());
+        }
+
+        arena.Release();
+        REQUIRE(0 == arena.Get_Mapped_Size());
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*!
+ *  @file Test_Metrics.hpp
+ *  @brief Contains the tests for the live metrics of a Serialiser.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <chrono>      // for milliseconds
+#include <cstdint>     // for uint8_t
+#include <cstdio>      // for remove
+#include <filesystem>  // for temp_directory_path, exists
+#include <sstream>     // for ostringstream
+#include <string>      // for string
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser, Metrics, Metrics_Dumper
+
+TEST_CASE("Live metrics"
+          "[metrics]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+    serialiser.Add_Trace({1, 2, 3});
+    serialiser.Add_Trace({4, 5, 6});
+
+    SECTION("Ingested traces are pending until saved")
+    {
+        const auto& metrics{serialiser.Get_Metrics()};
+        REQUIRE(2 == metrics.Get_Traces_Ingested());
+        REQUIRE(0 == metrics.Get_Traces_Dropped());
+        REQUIRE(2 == metrics.Get_Queue_Depth());
+        REQUIRE(6 == metrics.Get_Bytes_Pending());
+
+        serialiser.Save(file_path);
+
+        REQUIRE(0 == metrics.Get_Queue_Depth());
+        REQUIRE(0 == metrics.Get_Bytes_Pending());
+        // 11 bytes of headers are not counted as they are not per trace.
+        REQUIRE(6 == metrics.Get_Bytes_Written());
+        REQUIRE(2 == metrics.Get_Encode_Latency().Get_Count());
+        REQUIRE(2 == metrics.Get_Write_Latency().Get_Count());
+    }
+
+    SECTION("Rejected traces are dropped")
+    {
+        serialiser.Set_Alignment({1, 2, 3}, 0, 0, 0.5f);
+        serialiser.Add_Trace({3, 2, 1});
+
+        REQUIRE(3 == serialiser.Get_Metrics().Get_Traces_Ingested());
+        REQUIRE(1 == serialiser.Get_Metrics().Get_Traces_Dropped());
+        REQUIRE(2 == serialiser.Get_Metrics().Get_Queue_Depth());
+    }
+
+    SECTION("Metrics are written in the Prometheus format")
+    {
+        std::ostringstream stream;
+        serialiser.Get_Metrics().Write_Prometheus(stream);
+        const std::string text{stream.str()};
+
+        REQUIRE_THAT(text,
+                     Catch::Contains("# TYPE traces_serialiser_traces_"
+                                     "ingested_total counter\n"
+                                     "traces_serialiser_traces_ingested_"
+                                     "total 2\n"));
+        REQUIRE_THAT(text,
+                     Catch::Contains("traces_serialiser_encode_latency_"
+                                     "seconds_bucket{le=\"+Inf\"} 0\n"));
+    }
+
+    SECTION("Metrics are dumped to a file")
+    {
+        const std::string metrics_path{
+            (std::filesystem::temp_directory_path() / "Test_Metrics.prom")
+                .string()};
+        {
+            Traces_Serialiser::Metrics_Dumper dumper{
+                serialiser.Get_Metrics(),
+                metrics_path,
+                std::chrono::milliseconds{10}};
+        }
+
+        const std::string metrics{load_file(metrics_path)};
+        std::remove(metrics_path.c_str());
+        REQUIRE_THAT(metrics,
+                     Catch::Contains("traces_serialiser_queue_depth 2\n"));
+
+        // The file is written to a temporary file first, which is renamed
+        // over it.
+        REQUIRE_FALSE(std::filesystem::exists(metrics_path + ".tmp"));
+    }
+}
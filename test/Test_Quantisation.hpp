@@ -0,0 +1,178 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Test_Quantisation.hpp
+ *  @brief Contains the tests for quantising floating point traces to integers
+ *  when saving.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>  // for uint8_t
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser
+
+TEST_CASE("Quantising traces"
+          "[!throws][saving][quantisation]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    SECTION("Scale calculated from the traces")
+    {
+        Traces_Serialiser::Serialiser<float> serialiser(
+            {{-1.0f, 0.0f, 1.0f}, {0.5f, -0.5f, 0.0f}});
+        serialiser.Set_Quantisation(1);
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value (1 byte integer)
+            0x4c,  // Scale value of Y axis
+            0x04,  // Length
+            0x04, 0x02, 0x01, 0x3c,  // Value (1 / 127)
+            0x57,  // Scope offset
+            0x04,  // Length
+            0x00, 0x00, 0x00, 0x00,  // Value (0.0f)
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x81,  // Start of trace 1 (-127)
+            0x00,
+            0x7f,
+            0x40,  // Start of trace 2 (63.5 rounds to even)
+            0xc0,
+            0x00};
+        // clang-format on
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+        REQUIRE(0.5 / 127 >= serialiser.Get_Quantisation_Error());
+    }
+
+    SECTION("Scale calculated from traces of different lengths")
+    {
+        // The padding of the shorter trace is not part of the range.
+        Traces_Serialiser::Serialiser<float> serialiser(
+            {{10.0f, 20.0f, 15.0f}, {12.0f, 18.0f}});
+        serialiser.Set_Quantisation(1);
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value (1 byte integer)
+            0x4c,  // Scale value of Y axis
+            0x04,  // Length
+            0x85, 0x42, 0x21, 0x3d,  // Value (10 / 254)
+            0x57,  // Scope offset
+            0x04,  // Length
+            0x00, 0x00, 0x70, 0x41,  // Value (15.0f)
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x81,  // Start of trace 1 (-127)
+            0x7f,
+            0x00,
+            0xb4,  // Start of trace 2 (-76)
+            0x4c,
+            0x80};  // Padding, saturated (-128)
+        // clang-format on
+
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+        REQUIRE(5.0 / 254 >= serialiser.Get_Quantisation_Error());
+
+        // The padding added by the first save is still not part of the range
+        // once the traces have been spilled to disk.
+        serialiser.Set_Memory_Budget(1);
+        REQUIRE(2 == serialiser.Get_Number_Of_Spilled_Traces());
+        serialiser.Save(file_path);
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == load_file(file_path));
+        REQUIRE(5.0 / 254 >= serialiser.Get_Quantisation_Error());
+    }
+
+    SECTION("Scale given by the user saturates")
+    {
+        Traces_Serialiser::Serialiser<float> serialiser({{1.0f, 1000.0f}});
+        serialiser.Set_Quantisation(2, 0.01f, 0);
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x01,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x02,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x02,  // Value (2 byte integer)
+            0x4c,  // Scale value of Y axis
+            0x04,  // Length
+            0x0a, 0xd7, 0x23, 0x3c,  // Value (0.01f)
+            0x57,  // Scope offset
+            0x04,  // Length
+            0x00, 0x00, 0x00, 0x00,  // Value (0.0f)
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x64, 0x00,  // Start of trace 1 (100)
+            0xff, 0x7f}; // Saturated
+        // clang-format on
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+        REQUIRE(600 < serialiser.Get_Quantisation_Error());
+    }
+
+    SECTION("Invalid quantisation")
+    {
+        Traces_Serialiser::Serialiser<float> serialiser({{1.0f, 2.0f}});
+        REQUIRE_THROWS_AS(serialiser.Set_Quantisation(4), std::range_error);
+        REQUIRE_THROWS_AS(serialiser.Set_Quantisation(1, 0, 0),
+                          std::range_error);
+
+        Traces_Serialiser::Serialiser<std::uint8_t> integers({{1, 2}});
+        REQUIRE_THROWS_AS(integers.Set_Quantisation(1), std::domain_error);
+    }
+}
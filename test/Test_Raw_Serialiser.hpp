@@ -0,0 +1,118 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*!
+ *  @file Test_Raw_Serialiser.hpp
+ *  @brief Contains the tests for serialising traces whose sample type is
+ *  given at run time.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>    // for uint8_t, uint16_t
+#include <stdexcept>  // for domain_error, range_error
+#include <string>     // for string
+#include <vector>     // for vector
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Raw_Serialiser, Serialiser
+
+TEST_CASE("Serialising raw traces"
+          "[!throws][traces][raw]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    SECTION("Raw integer traces are saved the same as Serialiser")
+    {
+        const std::uint16_t samples[]{0x0102, 0x0001, 0x0300, 0x0000};
+        const std::uint8_t extra_data[]{0xab, 0xcd};
+
+        Traces_Serialiser::Raw_Serialiser raw{0x02};
+        raw.Set_Trace_Title("Raw");
+        REQUIRE_NOTHROW(
+            raw.Add_Traces(samples, 2, 2 * sizeof(std::uint16_t), extra_data, 2));
+        REQUIRE(2 == raw.Get_Number_Of_Traces());
+        REQUIRE(2 == raw.Get_Samples_Per_Trace());
+        raw.Save(file_path);
+        const std::string raw_result{load_file(file_path)};
+
+        Traces_Serialiser::Serialiser<std::uint16_t> serialiser{
+            {"ab", "cd"}, {{0x0102, 0x0001}, {0x0300, 0x0000}}};
+        serialiser.Set_Trace_Title("Raw");
+        serialiser.Save(file_path);
+
+        REQUIRE(load_file(file_path) == raw_result);
+    }
+
+    SECTION("Raw floating point traces")
+    {
+        const float samples[]{1.0f, 2.0f};
+
+        Traces_Serialiser::Raw_Serialiser raw{0x14};
+        REQUIRE(raw.Is_Floating_Point());
+        REQUIRE(4 == raw.Get_Sample_Length());
+        raw.Add_Trace(samples, sizeof(samples));
+        raw.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result{load_file(file_path)};
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x01,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x02,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x14,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x00, 0x00, 0x80, 0x3f,  // Start of trace 1 (1.0)
+            0x00, 0x00, 0x00, 0x40}; // 2.0
+        // clang-format on
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+    }
+
+    SECTION("Invalid raw traces")
+    {
+        REQUIRE_THROWS_AS(Traces_Serialiser::Raw_Serialiser{0x03},
+                          std::range_error);
+        REQUIRE_THROWS_AS(Traces_Serialiser::Raw_Serialiser{0x24},
+                          std::range_error);
+
+        const std::uint8_t samples[]{1, 2, 3, 4, 5, 6};
+        Traces_Serialiser::Raw_Serialiser raw{0x02};
+
+        // Half a sample.
+        REQUIRE_THROWS_AS(raw.Add_Trace(samples, 3), std::domain_error);
+
+        REQUIRE_NOTHROW(raw.Add_Trace(samples, 4));
+        REQUIRE_THROWS_AS(raw.Add_Trace(samples, 6), std::domain_error);
+        REQUIRE_THROWS_AS(raw.Add_Trace(samples, 4, samples, 1),
+                          std::domain_error);
+        REQUIRE(1 == raw.Get_Number_Of_Traces());
+    }
+}
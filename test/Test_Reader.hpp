@@ -0,0 +1,155 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*!
+ *  @file Test_Reader.hpp
+ *  @brief Contains the tests for reading the headers and traces of existing
+ *  files.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>    // for uint8_t, uint16_t
+#include <fstream>    // for ofstream
+#include <ios>        // for ios_base::failure
+#include <stdexcept>  // for range_error, length_error
+#include <string>     // for string
+#include <vector>     // for vector
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Reader, Serialiser
+
+TEST_CASE("Reading existing files"
+          "[!throws][reader]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    Traces_Serialiser::Serialiser<float> serialiser{
+        {"ab", "cd", "ef"}, {{1.0f, 2.0f}, {3.0f, 4.0f}, {5.0f, 6.0f}}};
+    serialiser.Set_Trace_Title("Traces");
+    serialiser.Save(file_path);
+
+    SECTION("Reading the headers")
+    {
+        const Traces_Serialiser::Reader reader{file_path};
+
+        REQUIRE(3 == reader.Get_Number_Of_Traces());
+        REQUIRE(2 == reader.Get_Samples_Per_Trace());
+        REQUIRE(0x14 == reader.Get_Sample_Coding());
+        REQUIRE(4 == reader.Get_Sample_Length());
+        REQUIRE(reader.Is_Floating_Point());
+        REQUIRE(1 == reader.Get_Extra_Data_Length());
+        REQUIRE(9 == reader.Get_Trace_Size());
+
+        // 4 required headers of 3 bytes, the title and the Trace Block
+        // Marker.
+        REQUIRE(4 * 3 + 8 + 2 == reader.Get_Data_Offset());
+
+        REQUIRE(reader.Has_Header(
+            Traces_Serialiser::Headers::Tag_Trace_Title));
+        REQUIRE("Traces" ==
+                reader.Get_Header(Traces_Serialiser::Headers::Tag_Trace_Title));
+        REQUIRE_FALSE(reader.Has_Header(
+            Traces_Serialiser::Headers::Tag_Description));
+        REQUIRE(reader.Get_Header(Traces_Serialiser::Headers::Tag_Description)
+                    .empty());
+    }
+
+    SECTION("Reading traces")
+    {
+        const Traces_Serialiser::Reader reader{file_path};
+
+        std::vector<char> traces(2 * reader.Get_Trace_Size());
+        REQUIRE_NOTHROW(reader.Read_Traces(1, 2, traces.data(), traces.size()));
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result{
+            0xcd,                    // Start of trace 2 extra data
+            0x00, 0x00, 0x40, 0x40,  // Start of trace 2 (3.0)
+            0x00, 0x00, 0x80, 0x40,  // 4.0
+            0xef,                    // Start of trace 3 extra data
+            0x00, 0x00, 0xa0, 0x40,  // Start of trace 3 (5.0)
+            0x00, 0x00, 0xc0, 0x40}; // 6.0
+        // clang-format on
+
+        REQUIRE(std::string(std::begin(expected_result),
+                            std::end(expected_result)) ==
+                std::string(std::begin(traces), std::end(traces)));
+
+        REQUIRE_THROWS_AS(
+            reader.Read_Traces(2, 2, traces.data(), traces.size()),
+            std::range_error);
+        REQUIRE_THROWS_AS(reader.Read_Traces(0, 1, traces.data(), traces.size()),
+                          std::length_error);
+    }
+
+    SECTION("Mapping multi-byte integer traces")
+    {
+        Traces_Serialiser::Serialiser<std::uint16_t> integer_serialiser{
+            {"ab", "cd"}, {{1, 256}, {0x1234, 0xff00}}};
+        integer_serialiser.Save(file_path);
+
+        const Traces_Serialiser::Reader reader{file_path};
+        REQUIRE(2 == reader.Get_Sample_Length());
+        REQUIRE_FALSE(reader.Is_Floating_Point());
+        REQUIRE(5 == reader.Get_Trace_Size());
+
+        // Decode the samples in the same way as the memory mapped "<u2"
+        // samples of the Python Trace_File, from the offset the reader gives.
+        const std::string file{load_file(file_path)};
+        REQUIRE(reader.Get_Data_Offset() +
+                    reader.Get_Number_Of_Traces() * reader.Get_Trace_Size() ==
+                file.size());
+        std::vector<std::uint16_t> samples{};
+        for (std::size_t i{0}; i < reader.Get_Number_Of_Traces(); ++i)
+        {
+            const std::size_t trace{reader.Get_Data_Offset() +
+                                    i * reader.Get_Trace_Size() +
+                                    reader.Get_Extra_Data_Length()};
+            for (std::size_t j{0}; j < reader.Get_Samples_Per_Trace(); ++j)
+            {
+                const auto low{static_cast<std::uint8_t>(file[trace + 2 * j])};
+                const auto high{
+                    static_cast<std::uint8_t>(file[trace + 2 * j + 1])};
+                samples.push_back(
+                    static_cast<std::uint16_t>(low | (high << 8)));
+            }
+        }
+
+        const std::vector<std::uint16_t> expected_result{
+            1, 256, 0x1234, 0xff00};
+        REQUIRE(expected_result == samples);
+    }
+
+    SECTION("Reading an invalid file")
+    {
+        REQUIRE_THROWS_AS(Traces_Serialiser::Reader{"Test_Missing_File.trs"},
+                          std::ios_base::failure);
+
+        // The headers describe more traces than the file holds.
+        const std::string truncated{load_file(file_path).substr(0, 30)};
+        {
+            std::ofstream file{file_path, std::ios::binary};
+            file << truncated;
+        }
+        REQUIRE_THROWS_AS(Traces_Serialiser::Reader{file_path},
+                          std::ios_base::failure);
+    }
+}
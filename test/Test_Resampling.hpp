@@ -0,0 +1,140 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Test_Resampling.hpp
+ *  @brief Contains the tests for resampling traces to the external clock as
+ *  they are added.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>  // for uint8_t
+#include <limits>   // for numeric_limits
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser
+
+TEST_CASE("Resampling traces"
+          "[!throws][traces][resampling]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    using Serialiser = Traces_Serialiser::Serialiser<std::uint8_t>;
+
+    SECTION("Mean of each clock cycle")
+    {
+        Serialiser serialiser{};
+        serialiser.Set_Clock_Resampling(400, 100);
+
+        serialiser.Add_Trace({1, 2, 3, 6, 5, 6, 7, 9, 9, 9});
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x01,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x02,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x4b,  // Scale value of X axis
+            0x04,  // Length
+            0x0a, 0xd7, 0x23, 0x3c,  // Value (0.01f)
+            0x60,  // External clock used
+            0x01,  // Length
+            0x01,  // Value
+            0x62,  // External clock multiplier
+            0x01,  // Length
+            0x01,  // Value
+            0x63,  // External clock phase shift
+            0x01,  // Length
+            0x00,  // Value
+            0x66,  // External clock frequency
+            0x04,  // Length
+            0x00, 0x00, 0xc8, 0x42,  // Value (100.0f)
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x03,  // Start of trace 1
+            0x07};
+        // clang-format on
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+    }
+
+    SECTION("Max of each clock cycle after a phase shift")
+    {
+        Serialiser serialiser{};
+        serialiser.Set_Clock_Resampling(
+            400, 100, Serialiser::Resample_Mode::Max, 1, 1);
+
+        serialiser.Add_Trace({0, 1, 2, 4, 3, 5, 8, 7, 6, 9});
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        REQUIRE("\x04\x08" == actual_result.substr(actual_result.size() - 2));
+    }
+
+    SECTION("Sum of each half clock cycle")
+    {
+        Serialiser serialiser{};
+        serialiser.Set_Clock_Resampling(
+            400, 100, Serialiser::Resample_Mode::Sum, 2);
+
+        serialiser.Add_Trace({1, 2, 3, 4, 200, 100, 5, 6});
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        // Sums that do not fit in a sample saturate.
+        REQUIRE("\x03\x07\xff\x0b" ==
+                actual_result.substr(actual_result.size() - 4));
+    }
+
+    SECTION("Clock faster than the sample rate")
+    {
+        Serialiser serialiser{};
+        REQUIRE_THROWS_AS(serialiser.Set_Clock_Resampling(100, 400),
+                          std::range_error);
+    }
+
+    SECTION("Invalid clock")
+    {
+        Serialiser serialiser{};
+        REQUIRE_THROWS_AS(serialiser.Set_Clock_Resampling(400, 0),
+                          std::range_error);
+        REQUIRE_THROWS_AS(serialiser.Set_Clock_Resampling(400, -100),
+                          std::range_error);
+        REQUIRE_THROWS_AS(serialiser.Set_Clock_Resampling(
+                              400, 100, Serialiser::Resample_Mode::Mean, 0),
+                          std::range_error);
+        REQUIRE_THROWS_AS(
+            serialiser.Set_Clock_Resampling(
+                std::numeric_limits<float>::infinity(), 100),
+            std::range_error);
+    }
+}
@@ -0,0 +1,156 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Test_Round_Trip.hpp
+ *  @brief Contains the tests for reading back the samples saved by each of
+ *  the writers.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>  // for uint16_t, uint32_t, int16_t
+#include <cstring>  // for memcpy
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Reader, Serialiser, Fixed_...
+
+//! @brief Reads every sample of the file at p_file_path, skipping the extra
+//! data of each trace.
+//! @returns The samples of all of the traces, one trace after another.
+template <typename T_Sample>
+std::vector<T_Sample> read_samples(const std::string& p_file_path)
+{
+    const Traces_Serialiser::Reader reader{p_file_path};
+    REQUIRE(sizeof(T_Sample) == reader.Get_Sample_Length());
+
+    std::vector<char> traces(reader.Get_Number_Of_Traces() *
+                             reader.Get_Trace_Size());
+    reader.Read_Traces(
+        0, reader.Get_Number_Of_Traces(), traces.data(), traces.size());
+
+    std::vector<T_Sample> samples(reader.Get_Number_Of_Traces() *
+                                  reader.Get_Samples_Per_Trace());
+    const std::size_t trace_length{reader.Get_Samples_Per_Trace() *
+                                   sizeof(T_Sample)};
+    for (std::size_t i{0}; i < reader.Get_Number_Of_Traces(); ++i)
+    {
+        std::memcpy(samples.data() + i * reader.Get_Samples_Per_Trace(),
+                    traces.data() + i * reader.Get_Trace_Size() +
+                        reader.Get_Extra_Data_Length(),
+                    trace_length);
+    }
+    return samples;
+}
+
+TEST_CASE("Reading back saved samples"
+          "[!throws][reader][round trip]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    // None of these can be told apart if zero bytes are lost.
+    const std::vector<std::uint16_t> samples_16{1, 256, 0x1234, 0xff00};
+    const std::vector<std::uint32_t> samples_32{
+        1, 256, 0x00ff00ff, 0xff000000};
+
+    SECTION("16 bit Serialiser")
+    {
+        Traces_Serialiser::Serialiser<std::uint16_t> serialiser{
+            {"ab", "cd"}, {{1, 256}, {0x1234, 0xff00}}};
+        serialiser.Save(file_path);
+
+        REQUIRE(samples_16 == read_samples<std::uint16_t>(file_path));
+    }
+
+    SECTION("32 bit Serialiser")
+    {
+        Traces_Serialiser::Serialiser<std::uint32_t> serialiser{
+            {{1, 256, 0x00ff00ff, 0xff000000}}};
+        serialiser.Save(file_path);
+
+        REQUIRE(samples_32 == read_samples<std::uint32_t>(file_path));
+    }
+
+    SECTION("Signed samples saved shorter than they are stored")
+    {
+        Traces_Serialiser::Serialiser<std::int32_t> serialiser{
+            {{-1, 256, -32768, 0x1234}}, 2};
+        serialiser.Save(file_path);
+
+        const std::vector<std::int16_t> expected_result{
+            -1, 256, -32768, 0x1234};
+        REQUIRE(expected_result == read_samples<std::int16_t>(file_path));
+    }
+
+    SECTION("16 bit Stream_Writer")
+    {
+        const std::uint8_t extra_data[]{0xab, 0xcd};
+        {
+            Traces_Serialiser::Stream_Writer<std::uint16_t> writer{
+                file_path, 2, 1};
+            writer.Append(samples_16.data(), 4, extra_data, 2);
+            writer.Close();
+        }
+
+        REQUIRE(samples_16 == read_samples<std::uint16_t>(file_path));
+    }
+
+    SECTION("32 bit Stream_Writer appending one trace at a time")
+    {
+        {
+            Traces_Serialiser::Stream_Writer<std::uint32_t> writer{file_path,
+                                                                   2};
+            writer.Append({1, 256});
+            writer.Append({0x00ff00ff, 0xff000000});
+            writer.Close();
+        }
+
+        REQUIRE(samples_32 == read_samples<std::uint32_t>(file_path));
+    }
+
+    SECTION("16 bit Fixed_Serialiser")
+    {
+        Traces_Serialiser::Fixed_Serialiser<std::uint16_t, 2> fixed{};
+        fixed.Add_Trace({1, 256});
+        fixed.Add_Trace({0x1234, 0xff00});
+        fixed.Save(file_path);
+
+        REQUIRE(samples_16 == read_samples<std::uint16_t>(file_path));
+    }
+
+    SECTION("32 bit Fixed_Serialiser with extra data")
+    {
+        Traces_Serialiser::Fixed_Serialiser<std::uint32_t, 4, 4> fixed{};
+        fixed.Add_Trace({1, 256, 0x00ff00ff, 0xff000000}, {1, 2, 3, 4});
+        fixed.Save(file_path);
+
+        REQUIRE(samples_32 == read_samples<std::uint32_t>(file_path));
+    }
+
+    SECTION("Raw_Serialiser")
+    {
+        Traces_Serialiser::Raw_Serialiser raw{0x04};
+        raw.Add_Traces(samples_32.data(), 2, 2 * sizeof(std::uint32_t));
+        raw.Save(file_path);
+
+        REQUIRE(samples_32 == read_samples<std::uint32_t>(file_path));
+    }
+}
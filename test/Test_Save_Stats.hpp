@@ -0,0 +1,94 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*!
+ *  @file Test_Save_Stats.hpp
+ *  @brief Contains the tests for the statistics and progress reported while
+ *  saving.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>  // for uint8_t
+#include <fstream>  // for ifstream
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser, Save_Stats
+
+TEST_CASE("Save statistics and progress"
+          "[!throws][save][stats]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+    for (std::uint8_t i{0}; i < 5; ++i)
+    {
+        serialiser.Add_Trace({i, 2, 3});
+    }
+
+    SECTION("The amount written is reported")
+    {
+        Traces_Serialiser::Save_Stats stats{};
+        serialiser.Set_Sync_On_Save();
+        REQUIRE_NOTHROW(serialiser.Save(file_path, &stats));
+
+        // 11 bytes of headers followed by 5 traces of 3 samples.
+        REQUIRE(26 == stats.bytes_written);
+        REQUIRE(load_file(file_path).size() == stats.bytes_written);
+        REQUIRE(5 == stats.traces_written);
+        REQUIRE(5 == stats.traces_to_write);
+        REQUIRE_FALSE(stats.cancelled);
+        REQUIRE(stats.total >= stats.io);
+    }
+
+    SECTION("Progress is reported every N traces")
+    {
+        std::vector<std::uint64_t> progress;
+        serialiser.Set_Save_Progress_Callback(
+            [&progress](const Traces_Serialiser::Save_Stats& p_stats) {
+                progress.push_back(p_stats.traces_written);
+                return true;
+            },
+            2);
+        serialiser.Save(file_path);
+
+        REQUIRE(std::vector<std::uint64_t>{2, 4} == progress);
+    }
+
+    SECTION("Cancelling removes the partially written file")
+    {
+        Traces_Serialiser::Save_Stats stats{};
+        serialiser.Set_Save_Progress_Callback(
+            [](const Traces_Serialiser::Save_Stats&) { return false; }, 3);
+        REQUIRE_NOTHROW(serialiser.Save(file_path, &stats));
+
+        REQUIRE(stats.cancelled);
+        REQUIRE(3 == stats.traces_written);
+        REQUIRE_FALSE(std::ifstream{file_path});
+    }
+
+    SECTION("The progress interval must be at least 1")
+    {
+        REQUIRE_THROWS_WITH(
+            serialiser.Set_Save_Progress_Callback(
+                [](const Traces_Serialiser::Save_Stats&) { return true; }, 0),
+            Catch::Contains("The progress interval must be at least 1"));
+    }
+}
@@ -0,0 +1,142 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Test_Sparse_Recording.hpp
+ *  @brief Contains the tests for only recording windows around events.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>  // for uint8_t
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser
+
+TEST_CASE("Sparse recording"
+          "[!throws][traces][sparse]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    using Serialiser = Traces_Serialiser::Serialiser<std::uint8_t>;
+
+    SECTION("Windows around rising edges across multiple traces")
+    {
+        Serialiser serialiser{};
+        serialiser.Set_Sparse_Recording(5, 4, 1);
+
+        // The second event is within the window of the first. The window of
+        // the third event ends in the next trace.
+        serialiser.Add_Trace({0, 0, 9, 0, 9, 0, 0, 0, 0, 7, 0});
+        serialiser.Add_Trace({1, 0, 0, 0});
+        // The event on the boundary is detected and its window begins in the
+        // previous trace.
+        serialiser.Add_Trace({8, 8, 0, 0});
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x03,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x04,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x44,  // Cryptographic data Length
+            0x01,  // Length
+            0x08,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,  // Position 1
+            0x00,  // Start of trace 1
+            0x09,
+            0x00,
+            0x09,
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08,  // Position 8
+            0x00,  // Start of trace 2
+            0x07,
+            0x00,
+            0x01,  // From the second trace added
+            0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0e,  // Position 14
+            0x00,  // Start of trace 3, from the second trace added
+            0x08,
+            0x08,
+            0x00};
+        // clang-format on
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+    }
+
+    SECTION("Windows around falling edges")
+    {
+        Serialiser serialiser{};
+        serialiser.Set_Sparse_Recording(
+            5, 2, 0, Serialiser::Trigger_Edge::Falling);
+
+        serialiser.Add_Trace({9, 9, 1, 2, 9, 9, 9, 3}, "ab");
+        serialiser.Add_Trace({4}, "cd");
+        // The window of this event is never completed so is not stored.
+        serialiser.Add_Trace({9, 1}, "ef");
+        serialiser.Save(file_path);
+
+        const std::string actual_result{load_file(file_path)};
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x02,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x44,  // Cryptographic data Length
+            0x01,  // Length
+            0x09,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0xab, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02,  // Position 2
+            0x01,  // Start of trace 1
+            0x02,
+            0xab, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07,  // Position 7
+            0x03,  // Start of trace 2
+            0x04}; // From the second trace added
+        // clang-format on
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+    }
+
+    SECTION("Pre-trigger longer than the window")
+    {
+        Serialiser serialiser{};
+        REQUIRE_THROWS_AS(serialiser.Set_Sparse_Recording(5, 2, 2),
+                          std::range_error);
+    }
+}
@@ -0,0 +1,138 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*!
+ *  @file Test_Spilling.hpp
+ *  @brief Contains the tests for spilling traces to disk once a Serialiser
+ *  exceeds its memory budget.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>  // for uint8_t, uint16_t
+#include <string>   // for string
+#include <vector>   // for vector
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser
+
+namespace
+{
+//! @brief Adds the same ragged traces with extra data to p_serialiser, so
+//! that some need padding when saved.
+template <typename T_Sample>
+void add_spilling_traces(Traces_Serialiser::Serialiser<T_Sample>& p_serialiser)
+{
+    for (std::size_t i{0}; i < 40; ++i)
+    {
+        std::vector<T_Sample> trace(0 == i % 3 ? 50 : 100);
+        for (std::size_t j{0}; j < trace.size(); ++j)
+        {
+            trace[j] = static_cast<T_Sample>((i * 31 + j * 7) % 251);
+        }
+        p_serialiser.Add_Trace(trace, 0 == i % 2 ? "0a1b" : "2c3d");
+    }
+}
+}  // namespace
+
+TEST_CASE("Spilling traces to disk"
+          "[!throws][traces][spilling]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    SECTION("8 bit traces are copied back when saved")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> expected{};
+        add_spilling_traces(expected);
+        expected.Save(file_path);
+        const std::string expected_result{load_file(file_path)};
+
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        serialiser.Set_Memory_Budget(1000);
+        add_spilling_traces(serialiser);
+        REQUIRE(0 < serialiser.Get_Number_Of_Spilled_Traces());
+        REQUIRE(40 > serialiser.Get_Number_Of_Spilled_Traces());
+
+        serialiser.Save(file_path);
+        REQUIRE(expected_result == load_file(file_path));
+
+        // Spilled traces are kept, so can be saved again.
+        serialiser.Save(file_path);
+        REQUIRE(expected_result == load_file(file_path));
+    }
+
+    SECTION("16 bit traces are encoded when saved")
+    {
+        Traces_Serialiser::Serialiser<std::uint16_t> expected{};
+        add_spilling_traces(expected);
+        expected.Save(file_path);
+        const std::string expected_result{load_file(file_path)};
+
+        Traces_Serialiser::Serialiser<std::uint16_t> serialiser{};
+        serialiser.Set_Memory_Budget(1000);
+        add_spilling_traces(serialiser);
+        REQUIRE(0 < serialiser.Get_Number_Of_Spilled_Traces());
+
+        serialiser.Save(file_path);
+        REQUIRE(expected_result == load_file(file_path));
+    }
+
+    SECTION("Automatic quantisation includes spilled traces")
+    {
+        Traces_Serialiser::Serialiser<float> expected{};
+        expected.Set_Quantisation(1);
+        add_spilling_traces(expected);
+        expected.Save(file_path);
+        const std::string expected_result{load_file(file_path)};
+
+        Traces_Serialiser::Serialiser<float> serialiser{};
+        serialiser.Set_Quantisation(1);
+        serialiser.Set_Memory_Budget(1000);
+        add_spilling_traces(serialiser);
+        REQUIRE(0 < serialiser.Get_Number_Of_Spilled_Traces());
+
+        serialiser.Save(file_path);
+        REQUIRE(expected_result == load_file(file_path));
+    }
+
+    SECTION("Setting a budget spills the traces already added")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> expected{};
+        add_spilling_traces(expected);
+        add_spilling_traces(expected);
+        expected.Save(file_path);
+        const std::string expected_result{load_file(file_path)};
+
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        add_spilling_traces(serialiser);
+        REQUIRE(0 == serialiser.Get_Number_Of_Spilled_Traces());
+        serialiser.Set_Memory_Budget(1000);
+        REQUIRE(0 < serialiser.Get_Number_Of_Spilled_Traces());
+
+        // A copy shares the spilled traces but adds its own.
+        auto copy{serialiser};
+        add_spilling_traces(serialiser);
+        add_spilling_traces(copy);
+
+        serialiser.Save(file_path);
+        REQUIRE(expected_result == load_file(file_path));
+        copy.Save(file_path);
+        REQUIRE(expected_result == load_file(file_path));
+    }
+}
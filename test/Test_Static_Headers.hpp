@@ -0,0 +1,121 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*!
+ *  @file Test_Static_Headers.hpp
+ *  @brief Contains the tests for headers encoded at compile time.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <array>      // for array
+#include <cstddef>    // for byte
+#include <cstdint>    // for uint8_t, uint32_t
+#include <cstring>    // for memcpy
+#include <stdexcept>  // for length_error
+#include <string>     // for string
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Serialiser, Static_Headers
+
+namespace
+{
+using Tags = Traces_Serialiser::Serialiser<>;
+
+// Encoded entirely at compile time.
+constexpr auto static_headers{
+    Traces_Serialiser::Static_Headers<256>{}
+        .Add(Tags::Tag_Trace_Title, "Rig 1")
+        .Add(Tags::Tag_Axis_Offset_X, std::uint32_t{0x00010200})
+        .Add(Tags::Tag_Axis_Scale_X, 1e-9f)
+        .Add(Tags::Tag_Scope_Range, -2.5f)
+        .Add(Tags::Tag_Description,
+             "A description that is long enough to need more than seven bits "
+             "to store its length, so that the longer form of length is "
+             "used.")};
+
+static_assert(5 == static_headers.Get_Count());
+static_assert(std::byte{Tags::Tag_Trace_Title} ==
+              static_headers.Get_Bytes()[0]);
+// 1e-9f is 0x3089705f
+static_assert(std::byte{0x5f} == static_headers.Get_Bytes()[14]);
+static_assert(std::byte{0x30} == static_headers.Get_Bytes()[17]);
+}  // namespace
+
+TEST_CASE("Headers encoded at compile time"
+          "[!throws][headers][static]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    SECTION("Encoded the same as Add_Header()")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> expected{};
+        expected.Add_Trace({1, 2});
+        expected.Set_Trace_Title("Rig 1");
+        expected.Set_Axis_Offset_X(0x00010200);
+        expected.Set_Axis_Scale_X(1e-9f);
+        expected.Set_Scope_Range(-2.5f);
+        expected.Set_Trace_Description(
+            "A description that is long enough to need more than seven bits "
+            "to store its length, so that the longer form of length is used.");
+        expected.Save(file_path);
+        const std::string expected_result{load_file(file_path)};
+
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        serialiser.Add_Trace({1, 2});
+        serialiser.Add_Headers(static_headers);
+        serialiser.Save(file_path);
+
+        REQUIRE(expected_result == load_file(file_path));
+    }
+
+    SECTION("Floats are encoded exactly")
+    {
+        for (const float value : {1.0f, -0.1f, 3.4e38f, 1e-40f, 123456.789f})
+        {
+            const auto headers{Traces_Serialiser::Static_Headers<8>{}.Add(
+                Tags::Tag_Axis_Scale_Y, value)};
+
+            std::array<std::byte, sizeof(value)> expected{};
+            std::memcpy(expected.data(), &value, sizeof(value));
+            for (std::size_t i{0}; i < sizeof(value); ++i)
+            {
+                REQUIRE(expected[i] == headers.Get_Bytes()[2 + i]);
+            }
+        }
+    }
+
+    SECTION("Exceeding the capacity")
+    {
+        REQUIRE_THROWS_AS(
+            Traces_Serialiser::Static_Headers<4>{}.Add(Tags::Tag_Trace_Title,
+                                                       "Too long"),
+            std::length_error);
+    }
+
+    SECTION("External clock headers still require the external clock")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> serialiser{};
+        REQUIRE_THROWS_WITH(
+            serialiser.Add_Headers(Traces_Serialiser::Static_Headers<8>{}.Add(
+                Tags::Tag_External_Clock_Frequency, 1e6f)),
+            Catch::Contains("Enable external clock explicitly"));
+    }
+}
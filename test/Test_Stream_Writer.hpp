@@ -0,0 +1,152 @@
+/*
+ *  This file is part of Traces-Serialiser.
+ *
+ *  Traces-Serialiser is free software: you can redistribute it and/or modify it
+ *  under the terms of the GNU Affero General Public License as published by the
+ *  Free Software Foundation, either version 3 of the License, or (at your
+ *  option) any later version.
+ *
+ *  Traces-Serialiser is distributed in the hope that it will be useful, but
+ *  WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ *  or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ *  License for more details.
+ *
+ *  You should have received a copy of the GNU Affero General Public License
+ *  along with Traces-Serialiser.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*!
+ *  @file Test_Stream_Writer.hpp
+ *  @brief Contains the tests for writing traces to a file as they are
+ *  appended.
+ *  @author Scott Egerton
+ *  @date 2017-2018
+ *  @copyright GNU Affero General Public License Version 3+
+ */
+
+#include <cstdint>    // for uint8_t, uint16_t, uint32_t
+#include <stdexcept>  // for domain_error
+#include <string>     // for string
+#include <vector>     // for vector
+
+#include <catch.hpp>  // for Section, StringRef, SECTION, Sectio...
+
+#include "Traces_Serialiser.hpp"  // for Stream_Writer, Serialiser
+
+TEST_CASE("Streaming traces to a file"
+          "[!throws][traces][stream]")
+{
+    constexpr static char file_path[]{"Test_Traces.trs"};
+
+    SECTION("Appending a batch of traces")
+    {
+        const std::uint16_t samples[]{0x0102, 0x0001, 0x0300, 0x0000};
+        const std::uint8_t extra_data[]{0xab, 0xcd};
+
+        Traces_Serialiser::Stream_Writer<std::uint16_t> writer{file_path, 2, 1};
+        writer.Set_Trace_Title("ab");
+        REQUIRE_NOTHROW(writer.Append(samples, 4, extra_data, 2));
+        REQUIRE(2 == writer.Get_Number_Of_Traces());
+        REQUIRE_NOTHROW(writer.Close());
+
+        // Load the trs file into a string
+        const std::string actual_result{load_file(file_path)};
+
+        const std::vector<std::uint8_t> expected_result{
+            0x41,  // Number of traces
+            0x04,  // Length (Always 4, so that it can be filled in later)
+            0x02,  // Value
+            0x00,
+            0x00,
+            0x00,
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x02,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x02,  // Value
+            0x44,  // Cryptographic data Length
+            0x01,  // Length
+            0x01,  // Value
+            0x46,  // Trace Title
+            0x02,  // Length
+            'a',   // Value
+            'b',
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0xab,  // Start of trace 1 extra data
+            0x02,  // Start of trace 1
+            0x01,
+            0x01,
+            0x00,
+            0xcd,  // Start of trace 2 extra data
+            0x00,  // Start of trace 2
+            0x03,
+            0x00,
+            0x00};
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string{std::begin(expected_result),
+                            std::end(expected_result)} == actual_result);
+    }
+
+    SECTION("Traces are encoded the same as Serialiser")
+    {
+        const std::vector<std::vector<std::uint32_t>> traces{
+            {0x00000001, 0x00ff0000, 0x12003400}, {0xffffffff, 0, 0x80}};
+
+        {
+            Traces_Serialiser::Stream_Writer<std::uint32_t> writer{file_path, 3};
+            for (const auto& trace : traces)
+            {
+                writer.Append(trace);
+            }
+            // The file is closed when the writer is destroyed.
+        }
+        const std::string streamed{load_file(file_path)};
+
+        Traces_Serialiser::Serialiser<std::uint32_t> serialiser{traces};
+        serialiser.Save(file_path);
+        const std::string saved{load_file(file_path)};
+
+        // Only the length of the number of traces differs.
+        REQUIRE(0x04 == streamed[1]);
+        REQUIRE(0x01 == saved[1]);
+        REQUIRE(streamed.substr(6) == saved.substr(3));
+    }
+
+    SECTION("Changing headers after appending traces")
+    {
+        Traces_Serialiser::Stream_Writer<std::uint8_t> writer{file_path, 3};
+        writer.Set_Trace_Title("ab");
+        writer.Append({1, 2, 3});
+
+        // Headers of the same size are still written.
+        writer.Set_Trace_Title("cd");
+        REQUIRE_NOTHROW(writer.Close());
+        REQUIRE(std::string::npos != load_file(file_path).find("cd"));
+
+        Traces_Serialiser::Stream_Writer<std::uint8_t> resized{file_path, 3};
+        resized.Append({1, 2, 3});
+        resized.Set_Trace_Title("ab");
+        REQUIRE_THROWS_AS(resized.Close(), std::domain_error);
+    }
+
+    SECTION("Appending invalid traces")
+    {
+        const std::uint8_t samples[]{1, 2, 3, 4};
+        Traces_Serialiser::Stream_Writer<std::uint8_t> writer{file_path, 3, 2};
+
+        REQUIRE_THROWS_AS(writer.Append(samples, 4, samples, 2),
+                          std::domain_error);
+        REQUIRE_THROWS_AS(writer.Append(samples, 3, samples, 1),
+                          std::domain_error);
+        REQUIRE_THROWS_AS(writer.Append({1, 2, 3}), std::domain_error);
+        REQUIRE(0 == writer.Get_Number_Of_Traces());
+
+        writer.Close();
+        REQUIRE_THROWS_AS(writer.Append(samples, 3, samples, 2),
+                          std::domain_error);
+    }
+}
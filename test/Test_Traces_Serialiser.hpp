@@ -114,12 +114,12 @@ TEST_CASE("Saving traces"
             0x02,  // Value
             0x5f,  // Trace Block Marker
             0x00,  // Length (Always 0)
-            0x00, 0x01,  // Start of trace 1
-            0x00, 0x02,
-            0x00, 0x03,
-            0x00, 0x04,  // Start of trace 2
-            0x00, 0x05,
-            0x00, 0x06};
+            0x01, 0x00,  // Start of trace 1
+            0x02, 0x00,
+            0x03, 0x00,
+            0x04, 0x00,  // Start of trace 2
+            0x05, 0x00,
+            0x06, 0x00};
         // clang-format on
 
         // Ensure that the actual result is the same as the expected result.
@@ -149,12 +149,12 @@ TEST_CASE("Saving traces"
             0x04,  // Value
             0x5f,  // Trace Block Marker
             0x00,  // Length (Always 0)
-            0x00, 0x00, 0x00, 0x01,  // Start of trace 1
-            0x00, 0x00, 0x00, 0x02,
-            0x00, 0x00, 0x00, 0x03,
-            0x00, 0x00, 0x00, 0x04,  // Start of trace 2
-            0x00, 0x00, 0x00, 0x05,
-            0x00, 0x00, 0x00, 0x06};
+            0x01, 0x00, 0x00, 0x00,  // Start of trace 1
+            0x02, 0x00, 0x00, 0x00,
+            0x03, 0x00, 0x00, 0x00,
+            0x04, 0x00, 0x00, 0x00,  // Start of trace 2
+            0x05, 0x00, 0x00, 0x00,
+            0x06, 0x00, 0x00, 0x00};
         // clang-format on
 
         // Ensure that the actual result is the same as the expected result.
@@ -1546,6 +1546,159 @@ TEST_CASE("Saving headers"
                             std::end(expected_result)) == actual_result);
     }
 
+    SECTION("Set header longer than 255 bytes")
+    {
+        serialiser.Set_Trace_Title(std::string(300, 'a'));
+
+        serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result = load_file(file_path);
+
+        // clang-format off
+        std::vector<std::uint8_t> expected_result = {
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x46,  // Trace title
+            0x82,  // Length is stored in the next 2 bytes
+            0x2c, 0x01};  // Length (300, little endian)
+        // clang-format on
+        expected_result.insert(std::end(expected_result), 300, 'a');
+        expected_result.insert(std::end(expected_result),
+                               {0x5f,  // Trace Block Marker
+                                0x00,  // Length (Always 0)
+                                0x01,  // Start of trace 1
+                                0x02,
+                                0x03,
+                                0x04,  // Start of trace 2
+                                0x05,
+                                0x06});
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string(std::begin(expected_result),
+                            std::end(expected_result)) == actual_result);
+    }
+
+    SECTION("Set integer header with a zero low byte")
+    {
+        serialiser.Set_Axis_Offset_X(0x0100);
+
+        serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result = load_file(file_path);
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result = {
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x48,  // Axis offset X
+            0x02,  // Length
+            0x00, 0x01,  // Value (256, little endian)
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x01,  // Start of trace 1
+            0x02,
+            0x03,
+            0x04,  // Start of trace 2
+            0x05,
+            0x06};
+        // clang-format on
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string(std::begin(expected_result),
+                            std::end(expected_result)) == actual_result);
+    }
+
+    SECTION("Saving with hex extra data longer than 255 bytes")
+    {
+        Traces_Serialiser::Serialiser<std::uint8_t> long_serialiser(
+            {std::string(1024, 'a'), std::string(1024, 'b')},
+            {{0, 1, 2}, {3, 4, 5}});
+        long_serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result = load_file(file_path);
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_headers = {
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x44,  // Cryptographic data Length
+            0x02,  // Length
+            0x00, 0x02,  // Value (512, little endian)
+            0x5f,  // Trace Block Marker
+            0x00};  // Length (Always 0)
+        // clang-format on
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string(std::begin(expected_headers),
+                            std::end(expected_headers)) ==
+                actual_result.substr(0, expected_headers.size()));
+        REQUIRE(expected_headers.size() + 2 * (512 + 3) ==
+                actual_result.size());
+    }
+
+    SECTION("Changing a header between saves")
+    {
+        serialiser.Set_Trace_Title("ab");
+        serialiser.Save(file_path);
+        serialiser.Set_Trace_Title("cd");
+        serialiser.Save(file_path);
+
+        // Load the trs file into a string
+        const std::string actual_result = load_file(file_path);
+
+        // clang-format off
+        const std::vector<std::uint8_t> expected_result = {
+            0x41,  // Number of traces
+            0x01,  // Length
+            0x02,  // Value
+            0x42,  // Number of Samples per Trace
+            0x01,  // Length
+            0x03,  // Value
+            0x43,  // Sample Coding
+            0x01,  // Length
+            0x01,  // Value
+            0x46,  // Trace title
+            0x02,  // Length
+            0x63, 0x64,  // Value
+            0x5f,  // Trace Block Marker
+            0x00,  // Length (Always 0)
+            0x01,  // Start of trace 1
+            0x02,
+            0x03,
+            0x04,  // Start of trace 2
+            0x05,
+            0x06};
+        // clang-format on
+
+        // Ensure that the actual result is the same as the expected result.
+        REQUIRE(std::string(std::begin(expected_result),
+                            std::end(expected_result)) == actual_result);
+    }
+
     // TODO: Check the sample length is correctly detected for every
     // trace
 }
@@ -93,12 +93,12 @@ TEST_CASE("Traces of different types"
             0x02,  // Value
             0x5f,  // Trace Block Marker
             0x00,  // Length (Always 0)
-            0x00, 0x01,  // Start of trace 1
-            0x00, 0x02,
-            0x00, 0x03,
-            0x00, 0x04,  // Start of trace 2
-            0x00, 0x05,
-            0x00, 0x06};
+            0x01, 0x00,  // Start of trace 1
+            0x02, 0x00,
+            0x03, 0x00,
+            0x04, 0x00,  // Start of trace 2
+            0x05, 0x00,
+            0x06, 0x00};
         // clang-format on
 
         // Ensure that the actual result is the same as the expected result
@@ -129,12 +129,12 @@ TEST_CASE("Traces of different types"
             0x04,  // Value
             0x5f,  // Trace Block Marker
             0x00,  // Length (Always 0)
-            0x00, 0x00, 0x00, 0x01,  // Start of trace 1
-            0x00, 0x00, 0x00, 0x02,
-            0x00, 0x00, 0x00, 0x03,
-            0x00, 0x00, 0x00, 0x04,  // Start of trace 2
-            0x00, 0x00, 0x00, 0x05,
-            0x00, 0x00, 0x00, 0x06};
+            0x01, 0x00, 0x00, 0x00,  // Start of trace 1
+            0x02, 0x00, 0x00, 0x00,
+            0x03, 0x00, 0x00, 0x00,
+            0x04, 0x00, 0x00, 0x00,  // Start of trace 2
+            0x05, 0x00, 0x00, 0x00,
+            0x06, 0x00, 0x00, 0x00};
         // clang-format on
 
         // Ensure that the actual result is the same as the expected result
@@ -30,32 +30,55 @@
 #define CATCH_CONFIG_MAIN
 #endif  // CATCH_CONFIG_MAIN
 
+#include <fstream>   // for ifstream
+#include <iterator>  // for istreambuf_iterator
+#include <string>    // for string
+
 #include <catch.hpp>  // for catch
 
 #include "Traces_Serialiser.hpp"  // for Serialiser
 
 // Instantiate all expected templates in order to include these in coverage
-// information.
+// information. The compiled library already instantiates them.
+#ifndef TRACES_SERIALISER_EXTERN_TEMPLATES
 template class Traces_Serialiser::Serialiser<std::uint8_t>;
 template class Traces_Serialiser::Serialiser<std::uint16_t>;
 template class Traces_Serialiser::Serialiser<std::uint32_t>;
 template class Traces_Serialiser::Serialiser<float>;
+#endif  // TRACES_SERIALISER_EXTERN_TEMPLATES
 
-// TODO: Document
+//! @brief Loads the entire contents of the file given by p_file_path.
+//! @param p_file_path The path of the file to load.
+//! @returns The contents of the file.
 const std::string load_file(const std::string& p_file_path)
 {
     std::ifstream file(p_file_path, std::ios::binary);
-    std::string actual_result;
-
-    // TRS files should only ever be one line
-    std::getline(file, actual_result);
 
-    return actual_result;
+    // TRS files are binary so may contain new lines anywhere. Read it all.
+    return std::string{std::istreambuf_iterator<char>{file},
+                       std::istreambuf_iterator<char>{}};
 }
 
 // The actual tests
 #include "Test_Adding_Traces.hpp"
+#include "Test_Alignment.hpp"
+#include "Test_Averaging.hpp"
 #include "Test_Constructors.hpp"
 #include "Test_Different_Length_Traces.hpp"
+#include "Test_Filtering.hpp"
+#include "Test_Fixed_Serialiser.hpp"
+#include "Test_Header_Editor.hpp"
+#include "Test_Memory_Resources.hpp"
+#include "Test_Metrics.hpp"
+#include "Test_Quantisation.hpp"
+#include "Test_Raw_Serialiser.hpp"
+#include "Test_Reader.hpp"
+#include "Test_Resampling.hpp"
+#include "Test_Round_Trip.hpp"
+#include "Test_Save_Stats.hpp"
+#include "Test_Sparse_Recording.hpp"
+#include "Test_Spilling.hpp"
+#include "Test_Static_Headers.hpp"
+#include "Test_Stream_Writer.hpp"
 #include "Test_Traces_Serialiser.hpp"
 #include "Test_Traces_Types.hpp"